@@ -0,0 +1,461 @@
+///
+/// \file   bench_abe.cpp
+///
+/// \brief  End-to-end timings of the ABE schemes: setup, key generation,
+///         KEM and CPA encryption/decryption, secret sharing, coefficient
+///         recovery and policy parsing, across policy shapes and sizes.
+///
+
+#include <benchmark/benchmark.h>
+
+#include "bench_common.h"
+
+using namespace std;
+
+// policy shapes
+enum BenchShape {
+    SHAPE_FLAT_AND = 0,
+    SHAPE_FLAT_OR,
+    SHAPE_BALANCED,
+    SHAPE_NUMERIC,
+    SHAPE_DATE
+};
+
+#define BENCH_DATE_RANGE    "Date = May 1-10, 2016"
+#define BENCH_DATE_VALUE    "Date = May 5, 2016"
+
+static const vector<int64_t> kSchemes = {OpenABE_SCHEME_CP_WATERS, OpenABE_SCHEME_KP_GPSW};
+static const vector<int64_t> kShapes = {SHAPE_FLAT_AND, SHAPE_FLAT_OR, SHAPE_BALANCED,
+                                        SHAPE_NUMERIC, SHAPE_DATE};
+static const vector<int64_t> kLeaves = {1, 4, 16, 64, 256, 1024};
+
+// returns a policy of the given shape with 'leaves' leaves (numeric
+// comparisons expand into several leaves each once parsed)
+static string getShapedPolicy(int shape, int leaves) {
+    string policystr;
+    switch (shape) {
+        case SHAPE_FLAT_OR:
+            return getFlatPolicyString(leaves, "or");
+        case SHAPE_BALANCED:
+            return getBalancedOpenABETree(0, leaves - 1);
+        case SHAPE_NUMERIC:
+            for (int i = 0; i < leaves; i++) {
+                string clause = "Level" + to_string(i) + " > 16";
+                policystr = (i == 0) ? clause : "(" + policystr + " and " + clause + ")";
+            }
+            return policystr;
+        case SHAPE_DATE:
+            if (leaves == 1) {
+                return BENCH_DATE_RANGE;
+            }
+            return "(" + getFlatPolicyString(leaves - 1, "and") + " and " BENCH_DATE_RANGE ")";
+        default:
+            return getFlatPolicyString(leaves, "and");
+    }
+}
+
+// returns an attribute list that satisfies getShapedPolicy(shape, leaves)
+static string getShapedAttributes(int shape, int leaves) {
+    string attrs;
+    switch (shape) {
+        case SHAPE_FLAT_OR:
+            return createAttribute(leaves - 1);
+        case SHAPE_NUMERIC:
+            for (int i = 0; i < leaves; i++) {
+                if (i > 0) attrs += "|";
+                attrs += "Level" + to_string(i) + " = 100";
+            }
+            return attrs;
+        case SHAPE_DATE:
+            if (leaves == 1) {
+                return BENCH_DATE_VALUE;
+            }
+            return getAttributeListString(leaves - 1) + "|" BENCH_DATE_VALUE;
+        default:
+            return getAttributeListString(leaves);
+    }
+}
+
+// function inputs for a scheme: the policy goes into the key for KP and
+// into the ciphertext for CP
+static bool getShapedInputs(OpenABE_SCHEME scheme, int shape, int leaves,
+                            unique_ptr<OpenABEFunctionInput> &encInput,
+                            unique_ptr<OpenABEFunctionInput> &keyInput) {
+    const string policy = getShapedPolicy(shape, leaves);
+    const string attributes = getShapedAttributes(shape, leaves);
+    if (scheme == OpenABE_SCHEME_CP_WATERS) {
+        encInput = createPolicyTree(policy);
+        keyInput = createAttributeList(attributes);
+    } else {
+        encInput = createAttributeList(attributes);
+        keyInput = createPolicyTree(policy);
+    }
+    return encInput != nullptr && keyInput != nullptr;
+}
+
+static void setLabels(benchmark::State& state, OpenABE_SCHEME scheme) {
+    state.SetLabel(OpenABE_convertSchemeIDToString(scheme));
+}
+
+/********************************************************************************
+ * Policy parsing and LSSS
+ ********************************************************************************/
+
+static void BM_PolicyParse(benchmark::State& state) {
+    const string policy = getShapedPolicy(state.range(0), state.range(1));
+    for (auto _ : state) {
+        unique_ptr<OpenABEPolicy> tree = createPolicyTree(policy);
+        if (tree == nullptr) {
+            state.SkipWithError("createPolicyTree failed");
+            return;
+        }
+        benchmark::DoNotOptimize(tree.get());
+    }
+}
+BENCHMARK(BM_PolicyParse)
+    ->ArgNames({"shape", "leaves"})
+    ->ArgsProduct({kShapes, kLeaves})
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_LSSSShareSecret(benchmark::State& state) {
+    OpenABEPairing pairing;
+    unique_ptr<OpenABEPolicy> policy = createPolicyTree(getShapedPolicy(state.range(0), state.range(1)));
+    if (policy == nullptr) {
+        state.SkipWithError("createPolicyTree failed");
+        return;
+    }
+    ZP secret = pairing.randomZP();
+    for (auto _ : state) {
+        OpenABELSSS lsss;
+        lsss.shareSecret(policy.get(), secret);
+        benchmark::DoNotOptimize(lsss.getRows().size());
+    }
+}
+BENCHMARK(BM_LSSSShareSecret)
+    ->ArgNames({"shape", "leaves"})
+    ->ArgsProduct({kShapes, kLeaves})
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_LSSSShareSecretMatrix(benchmark::State& state) {
+    OpenABEPairing pairing;
+    unique_ptr<OpenABEPolicy> policy = createPolicyTree(getShapedPolicy(state.range(0), state.range(1)));
+    if (policy == nullptr) {
+        state.SkipWithError("createPolicyTree failed");
+        return;
+    }
+    // compiled once, as the compiled policy cache does
+    OpenABELSSSMatrix matrix(policy.get());
+    ZP secret = pairing.randomZP();
+    for (auto _ : state) {
+        OpenABELSSS lsss;
+        lsss.shareSecret(matrix, secret);
+        benchmark::DoNotOptimize(lsss.getRows().size());
+    }
+}
+BENCHMARK(BM_LSSSShareSecretMatrix)
+    ->ArgNames({"shape", "leaves"})
+    ->ArgsProduct({kShapes, kLeaves})
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_LSSSCompileMatrix(benchmark::State& state) {
+    OpenABEPairing pairing;
+    unique_ptr<OpenABEPolicy> policy = createPolicyTree(getShapedPolicy(state.range(0), state.range(1)));
+    if (policy == nullptr) {
+        state.SkipWithError("createPolicyTree failed");
+        return;
+    }
+    for (auto _ : state) {
+        OpenABELSSSMatrix matrix(policy.get());
+        benchmark::DoNotOptimize(matrix.numColumns());
+    }
+}
+BENCHMARK(BM_LSSSCompileMatrix)
+    ->ArgNames({"shape", "leaves"})
+    ->ArgsProduct({kShapes, kLeaves})
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_LSSSRecoverCoefficients(benchmark::State& state) {
+    const int shape = state.range(0), leaves = state.range(1);
+    unique_ptr<OpenABEPolicy> policy = createPolicyTree(getShapedPolicy(shape, leaves));
+    unique_ptr<OpenABEAttributeList> attrList = createAttributeList(getShapedAttributes(shape, leaves));
+    if (policy == nullptr || attrList == nullptr) {
+        state.SkipWithError("invalid policy or attributes");
+        return;
+    }
+    for (auto _ : state) {
+        OpenABELSSS lsss;
+        if (!lsss.recoverCoefficients(policy.get(), attrList.get())) {
+            state.SkipWithError("recoverCoefficients failed");
+            return;
+        }
+    }
+}
+BENCHMARK(BM_LSSSRecoverCoefficients)
+    ->ArgNames({"shape", "leaves"})
+    ->ArgsProduct({kShapes, kLeaves})
+    ->Unit(benchmark::kMicrosecond);
+
+// scalar arithmetic behind the LSSS: heap-allocated ZP vs. fixed-width ZPFixed
+static void BM_ScalarMulAdd_ZP(benchmark::State& state) {
+    OpenABEPairing pairing;
+    ZP x = pairing.randomZP(), y = pairing.randomZP(), acc = pairing.randomZP();
+    for (auto _ : state) {
+        acc = acc * x + y;
+        benchmark::DoNotOptimize(acc);
+    }
+}
+BENCHMARK(BM_ScalarMulAdd_ZP);
+
+static void BM_ScalarMulAdd_ZPFixed(benchmark::State& state) {
+    ZPFixed x = ZPFixed::random(), y = ZPFixed::random(), acc = ZPFixed::random();
+    for (auto _ : state) {
+        acc = acc * x + y;
+        benchmark::DoNotOptimize(acc);
+    }
+}
+BENCHMARK(BM_ScalarMulAdd_ZPFixed);
+
+static void BM_ScalarInverse_ZP(benchmark::State& state) {
+    OpenABEPairing pairing;
+    ZP one = pairing.initZP(), x = pairing.randomZP();
+    pairing.initZP(one, 1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(one / x);
+    }
+}
+BENCHMARK(BM_ScalarInverse_ZP);
+
+static void BM_ScalarInverse_ZPFixed(benchmark::State& state) {
+    ZPFixed x = ZPFixed::random();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(x.inverse());
+    }
+}
+BENCHMARK(BM_ScalarInverse_ZPFixed);
+
+// satisfiability of a wide OR policy against a key with many attributes,
+// of which only the last one is in the policy
+static void BM_CheckIfSatisfied(benchmark::State& state) {
+    const int leaves = state.range(0), attributes = state.range(1);
+    unique_ptr<OpenABEPolicy> policy = createPolicyTree(getFlatPolicyString(leaves, "or"));
+    string attrs = "|";
+    for (int i = 0; i < attributes - 1; i++) {
+        attrs += "Other" + to_string(i) + "|";
+    }
+    attrs += createAttribute(leaves - 1) + "|";
+    unique_ptr<OpenABEAttributeList> attrList = createAttributeList(attrs);
+    if (policy == nullptr || attrList == nullptr) {
+        state.SkipWithError("invalid policy or attributes");
+        return;
+    }
+    for (auto _ : state) {
+        if (!checkIfSatisfied(policy.get(), attrList.get()).first) {
+            state.SkipWithError("policy not satisfied");
+            return;
+        }
+    }
+}
+BENCHMARK(BM_CheckIfSatisfied)
+    ->ArgNames({"leaves", "attributes"})
+    ->ArgsProduct({{16, 256}, {16, 256, 1024}})
+    ->Unit(benchmark::kMicrosecond);
+
+/********************************************************************************
+ * KEM contexts
+ ********************************************************************************/
+
+static void BM_GenerateParams(benchmark::State& state) {
+    const OpenABE_SCHEME scheme = (OpenABE_SCHEME)state.range(0);
+    unique_ptr<OpenABEContextABE> context = createContextABE(scheme);
+    for (auto _ : state) {
+        if (context->generateParams(BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR) {
+            state.SkipWithError("generateParams failed");
+            return;
+        }
+    }
+    setLabels(state, scheme);
+}
+BENCHMARK(BM_GenerateParams)
+    ->ArgName("scheme")
+    ->ArgsProduct({kSchemes})
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_Keygen(benchmark::State& state) {
+    const OpenABE_SCHEME scheme = (OpenABE_SCHEME)state.range(0);
+    unique_ptr<OpenABEContextABE> context = createContextABE(scheme);
+    unique_ptr<OpenABEFunctionInput> encInput, keyInput;
+    if (!getShapedInputs(scheme, state.range(1), state.range(2), encInput, keyInput)) {
+        state.SkipWithError("invalid policy or attributes");
+        return;
+    }
+    if (context->generateParams(BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR) {
+        state.SkipWithError("generateParams failed");
+        return;
+    }
+    for (auto _ : state) {
+        if (context->generateDecryptionKey(keyInput.get(), BENCH_KEY, BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR) {
+            state.SkipWithError("generateDecryptionKey failed");
+            return;
+        }
+    }
+    setLabels(state, scheme);
+}
+BENCHMARK(BM_Keygen)
+    ->ArgNames({"scheme", "shape", "leaves"})
+    ->ArgsProduct({kSchemes, kShapes, kLeaves})
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_EncryptKEM(benchmark::State& state) {
+    const OpenABE_SCHEME scheme = (OpenABE_SCHEME)state.range(0);
+    unique_ptr<OpenABEContextABE> context = createContextABE(scheme);
+    unique_ptr<OpenABEFunctionInput> encInput, keyInput;
+    if (!getShapedInputs(scheme, state.range(1), state.range(2), encInput, keyInput)) {
+        state.SkipWithError("invalid policy or attributes");
+        return;
+    }
+    if (context->generateParams(BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR) {
+        state.SkipWithError("generateParams failed");
+        return;
+    }
+    shared_ptr<OpenABESymKey> key = make_shared<OpenABESymKey>();
+    for (auto _ : state) {
+        OpenABECiphertext ciphertext;
+        if (context->encryptKEM(BENCH_MPK, encInput.get(), DEFAULT_SYM_KEY_BYTES,
+                                key, ciphertext) != OpenABE_NOERROR) {
+            state.SkipWithError("encryptKEM failed");
+            return;
+        }
+    }
+    setLabels(state, scheme);
+}
+BENCHMARK(BM_EncryptKEM)
+    ->ArgNames({"scheme", "shape", "leaves"})
+    ->ArgsProduct({kSchemes, kShapes, kLeaves})
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_DecryptKEM(benchmark::State& state) {
+    const OpenABE_SCHEME scheme = (OpenABE_SCHEME)state.range(0);
+    unique_ptr<OpenABEContextABE> context = createContextABE(scheme);
+    unique_ptr<OpenABEFunctionInput> encInput, keyInput;
+    if (!getShapedInputs(scheme, state.range(1), state.range(2), encInput, keyInput)) {
+        state.SkipWithError("invalid policy or attributes");
+        return;
+    }
+    shared_ptr<OpenABESymKey> key = make_shared<OpenABESymKey>();
+    shared_ptr<OpenABESymKey> recovered = make_shared<OpenABESymKey>();
+    OpenABECiphertext ciphertext;
+    if (context->generateParams(BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR ||
+        context->generateDecryptionKey(keyInput.get(), BENCH_KEY, BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR ||
+        context->encryptKEM(BENCH_MPK, encInput.get(), DEFAULT_SYM_KEY_BYTES, key, ciphertext) != OpenABE_NOERROR) {
+        state.SkipWithError("setup failed");
+        return;
+    }
+    for (auto _ : state) {
+        if (context->decryptKEM(BENCH_MPK, BENCH_KEY, ciphertext, DEFAULT_SYM_KEY_BYTES,
+                                recovered) != OpenABE_NOERROR) {
+            state.SkipWithError("decryptKEM failed");
+            return;
+        }
+    }
+    setLabels(state, scheme);
+}
+BENCHMARK(BM_DecryptKEM)
+    ->ArgNames({"scheme", "shape", "leaves"})
+    ->ArgsProduct({kSchemes, kShapes, kLeaves})
+    ->Unit(benchmark::kMillisecond);
+
+/********************************************************************************
+ * CPA scheme contexts (KEM + payload encryption)
+ ********************************************************************************/
+
+// Full encrypt() as a function of the payload size, on a 16-leaf policy.
+static void BM_Encrypt(benchmark::State& state) {
+    const OpenABE_SCHEME scheme = (OpenABE_SCHEME)state.range(0);
+    const int shape = state.range(1), payload = state.range(2);
+    unique_ptr<OpenABEContextSchemeCPA> context = createContextABESchemeCPA(scheme);
+    unique_ptr<OpenABEFunctionInput> encInput, keyInput;
+    if (!getShapedInputs(scheme, shape, 16, encInput, keyInput)) {
+        state.SkipWithError("invalid policy or attributes");
+        return;
+    }
+    if (context->generateParams(BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR) {
+        state.SkipWithError("generateParams failed");
+        return;
+    }
+    OpenABEByteString plaintext;
+    getRandomBytes(plaintext, payload);
+    for (auto _ : state) {
+        OpenABECiphertext ciphertext;
+        if (context->encrypt(BENCH_MPK, encInput.get(), plaintext, ciphertext) != OpenABE_NOERROR) {
+            state.SkipWithError("encrypt failed");
+            return;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * payload);
+    setLabels(state, scheme);
+}
+BENCHMARK(BM_Encrypt)
+    ->ArgNames({"scheme", "shape", "payload"})
+    ->ArgsProduct({kSchemes, {SHAPE_FLAT_AND, SHAPE_FLAT_OR}, {32, 4096, 1 << 20}})
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_Decrypt(benchmark::State& state) {
+    const OpenABE_SCHEME scheme = (OpenABE_SCHEME)state.range(0);
+    const int shape = state.range(1), payload = state.range(2);
+    unique_ptr<OpenABEContextSchemeCPA> context = createContextABESchemeCPA(scheme);
+    unique_ptr<OpenABEFunctionInput> encInput, keyInput;
+    if (!getShapedInputs(scheme, shape, 16, encInput, keyInput)) {
+        state.SkipWithError("invalid policy or attributes");
+        return;
+    }
+    OpenABEByteString plaintext, recovered;
+    getRandomBytes(plaintext, payload);
+    OpenABECiphertext ciphertext;
+    if (context->generateParams(BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR ||
+        context->keygen(keyInput.get(), BENCH_KEY, BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR ||
+        context->encrypt(BENCH_MPK, encInput.get(), plaintext, ciphertext) != OpenABE_NOERROR) {
+        state.SkipWithError("setup failed");
+        return;
+    }
+    for (auto _ : state) {
+        if (context->decrypt(BENCH_MPK, BENCH_KEY, recovered, ciphertext) != OpenABE_NOERROR) {
+            state.SkipWithError("decrypt failed");
+            return;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * payload);
+    setLabels(state, scheme);
+}
+BENCHMARK(BM_Decrypt)
+    ->ArgNames({"scheme", "shape", "payload"})
+    ->ArgsProduct({kSchemes, {SHAPE_FLAT_AND, SHAPE_FLAT_OR}, {32, 4096, 1 << 20}})
+    ->Unit(benchmark::kMillisecond);
+
+// CPA encrypt() with the hash mask vs. the AES-CTR keystream, on a
+// single-leaf policy so that the payload dominates.
+static void BM_EncryptPayloadMode(benchmark::State& state) {
+    const OpenABE_PAYLOAD_MODE mode = (OpenABE_PAYLOAD_MODE)state.range(0);
+    const int64_t payload = state.range(1);
+    unique_ptr<OpenABEContextSchemeCPA> context = createContextABESchemeCPA(OpenABE_SCHEME_CP_WATERS);
+    unique_ptr<OpenABEPolicy> policy = createPolicyTree(getFlatPolicyString(1, "and"));
+    if (context->generateParams(BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR) {
+        state.SkipWithError("generateParams failed");
+        return;
+    }
+    context->setPayloadMode(mode);
+    OpenABEByteString plaintext;
+    getRandomBytes(plaintext, payload);
+    for (auto _ : state) {
+        OpenABECiphertext ciphertext;
+        if (context->encrypt(BENCH_MPK, policy.get(), plaintext, ciphertext) != OpenABE_NOERROR) {
+            state.SkipWithError("encrypt failed");
+            return;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * payload);
+    state.SetLabel(mode == OpenABE_PAYLOAD_HASH ? "hash" : "aes-ctr");
+}
+BENCHMARK(BM_EncryptPayloadMode)
+    ->ArgNames({"mode", "payload"})
+    ->ArgsProduct({{OpenABE_PAYLOAD_HASH, OpenABE_PAYLOAD_AES_CTR}, {1 << 10, 1 << 20, 100 << 20}})
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,182 @@
+///
+/// \file   bench_batch.cpp
+///
+/// \brief  Throughput of encrypting many messages under one policy:
+///         independent encrypt() calls vs. encryptBatch(). Likewise for
+///         issuing many decryption keys: keygen() + exportKey() per user
+///         vs. keygenBatch().
+///
+
+#include <benchmark/benchmark.h>
+
+#include "bench_common.h"
+
+using namespace std;
+
+#define BATCH_MSG_LEN   32
+
+// Encrypts 'batch' messages under a policy of 'leaves' attributes. The
+// 'threads' argument selects the mode: 0 is a loop of encrypt() calls,
+// n > 0 is encryptBatch() on n threads.
+static void BM_CPWatersEncryptBatch(benchmark::State& state) {
+    const int batch = state.range(0);
+    const int leaves = state.range(1);
+    const unsigned int threads = state.range(2);
+    unique_ptr<OpenABEContextSchemeCPA> context =
+        createContextABESchemeCPA(OpenABE_SCHEME_CP_WATERS);
+    if (context->generateParams(BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR) {
+        state.SkipWithError("generateParams failed");
+        return;
+    }
+    unique_ptr<OpenABEPolicy> policy = createPolicyTree(getFlatPolicyString(leaves, "and"));
+    vector<OpenABEByteString> plaintexts(batch);
+    for (auto& pt : plaintexts) {
+        getRandomBytes(pt, BATCH_MSG_LEN);
+    }
+
+    for (auto _ : state) {
+        if (threads == 0) {
+            for (auto& pt : plaintexts) {
+                OpenABECiphertext ciphertext;
+                if (context->encrypt(BENCH_MPK, policy.get(), pt, ciphertext) != OpenABE_NOERROR) {
+                    state.SkipWithError("encrypt failed");
+                    return;
+                }
+            }
+        } else {
+            vector<unique_ptr<OpenABECiphertext>> ciphertexts;
+            if (context->encryptBatch(BENCH_MPK, policy.get(), plaintexts,
+                                      ciphertexts, threads) != OpenABE_NOERROR) {
+                state.SkipWithError("encryptBatch failed");
+                return;
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+    state.counters["workers"] = OpenABE_getWorkerCount(threads, batch);
+}
+BENCHMARK(BM_CPWatersEncryptBatch)
+    ->ArgNames({"batch", "leaves", "threads"})
+    ->ArgsProduct({{64}, {4, 16}, {0, 1, 2, 4, 8}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+static void BM_KPGPSWEncryptBatch(benchmark::State& state) {
+    const int batch = state.range(0);
+    const int attrs = state.range(1);
+    const unsigned int threads = state.range(2);
+    unique_ptr<OpenABEContextSchemeCPA> context =
+        createContextABESchemeCPA(OpenABE_SCHEME_KP_GPSW);
+    if (context->generateParams(BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR) {
+        state.SkipWithError("generateParams failed");
+        return;
+    }
+    unique_ptr<OpenABEAttributeList> attrList = createAttributeList(getAttributeListString(attrs));
+    vector<OpenABEByteString> plaintexts(batch);
+    for (auto& pt : plaintexts) {
+        getRandomBytes(pt, BATCH_MSG_LEN);
+    }
+
+    for (auto _ : state) {
+        if (threads == 0) {
+            for (auto& pt : plaintexts) {
+                OpenABECiphertext ciphertext;
+                if (context->encrypt(BENCH_MPK, attrList.get(), pt, ciphertext) != OpenABE_NOERROR) {
+                    state.SkipWithError("encrypt failed");
+                    return;
+                }
+            }
+        } else {
+            vector<unique_ptr<OpenABECiphertext>> ciphertexts;
+            if (context->encryptBatch(BENCH_MPK, attrList.get(), plaintexts,
+                                      ciphertexts, threads) != OpenABE_NOERROR) {
+                state.SkipWithError("encryptBatch failed");
+                return;
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+    state.counters["workers"] = OpenABE_getWorkerCount(threads, batch);
+}
+BENCHMARK(BM_KPGPSWEncryptBatch)
+    ->ArgNames({"batch", "attrs", "threads"})
+    ->ArgsProduct({{64}, {4, 16}, {0, 1, 2, 4, 8}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Issues 'users' exported CP-Waters keys of 'attrs' attributes each. The
+// 'threads' argument selects the mode as above: 0 is a loop of keygen()
+// and exportKey() calls, n > 0 is keygenBatch() on n threads.
+static void BM_CPWatersKeygenBatch(benchmark::State& state) {
+    const int users = state.range(0);
+    const int attrs = state.range(1);
+    const unsigned int threads = state.range(2);
+    unique_ptr<OpenABEContextSchemeCPA> context =
+        createContextABESchemeCPA(OpenABE_SCHEME_CP_WATERS);
+    if (context->generateParams(BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR) {
+        state.SkipWithError("generateParams failed");
+        return;
+    }
+    unique_ptr<OpenABEAttributeList> attrList = createAttributeList(getAttributeListString(attrs));
+    vector<OpenABEFunctionInput*> keyInputs(users, attrList.get());
+    vector<string> keyIDs;
+    for (int i = 0; i < users; i++) {
+        keyIDs.push_back("user" + to_string(i));
+    }
+
+    for (auto _ : state) {
+        vector<OpenABEByteString> keyBlobs(users);
+        if (threads == 0) {
+            for (int i = 0; i < users; i++) {
+                if (context->keygen(keyInputs[i], keyIDs[i], BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR ||
+                    context->exportKey(keyIDs[i], keyBlobs[i]) != OpenABE_NOERROR ||
+                    context->deleteKey(keyIDs[i]) != OpenABE_NOERROR) {
+                    state.SkipWithError("keygen failed");
+                    return;
+                }
+            }
+        } else if (context->keygenBatch(keyInputs, keyIDs, BENCH_MPK, BENCH_MSK,
+                                        keyBlobs, threads) != OpenABE_NOERROR) {
+            state.SkipWithError("keygenBatch failed");
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * users);
+    state.counters["workers"] = OpenABE_getWorkerCount(threads, users);
+}
+BENCHMARK(BM_CPWatersKeygenBatch)
+    ->ArgNames({"users", "attrs", "threads"})
+    ->ArgsProduct({{64}, {4, 16}, {0, 1, 2, 4, 8}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// One KP-GPSW key for a policy of 'leaves' attributes, its rows computed
+// on 'threads' threads.
+static void BM_KPGPSWKeygenLargePolicy(benchmark::State& state) {
+    const int leaves = state.range(0);
+    const unsigned int threads = state.range(1);
+    unique_ptr<OpenABEContextSchemeCPA> context =
+        createContextABESchemeCPA(OpenABE_SCHEME_KP_GPSW);
+    if (context->generateParams(BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR) {
+        state.SkipWithError("generateParams failed");
+        return;
+    }
+    unique_ptr<OpenABEPolicy> policy = createPolicyTree(getFlatPolicyString(leaves, "or"));
+    vector<OpenABEFunctionInput*> keyInputs = {policy.get()};
+    vector<string> keyIDs = {"user"};
+
+    for (auto _ : state) {
+        vector<OpenABEByteString> keyBlobs;
+        if (context->keygenBatch(keyInputs, keyIDs, BENCH_MPK, BENCH_MSK,
+                                 keyBlobs, threads) != OpenABE_NOERROR) {
+            state.SkipWithError("keygenBatch failed");
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * leaves);
+}
+BENCHMARK(BM_KPGPSWKeygenLargePolicy)
+    ->ArgNames({"leaves", "threads"})
+    ->ArgsProduct({{64, 256}, {1, 2, 4, 8}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
@@ -0,0 +1,22 @@
+///
+/// \file   bench_common.h
+///
+/// \brief  Shared helpers for the OpenABE benchmarks.
+///
+
+#ifndef __BENCH_COMMON_H__
+#define __BENCH_COMMON_H__
+
+#include <string>
+
+#include <abe_lsss.h>
+
+#include "../schemes/schemes.h"
+#include "../utils/utils.h"
+#include "../utils/policygen.h"
+
+#define BENCH_MPK   "benchMPK"
+#define BENCH_MSK   "benchMSK"
+#define BENCH_KEY   "benchKey"
+
+#endif // __BENCH_COMMON_H__
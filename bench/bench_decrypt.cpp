@@ -0,0 +1,168 @@
+///
+/// \file   bench_decrypt.cpp
+///
+/// \brief  Decryption cost as a function of the number of satisfied rows
+///         and the number of decryption threads, and on OR-heavy policies
+///         whose coefficients are mostly trivial (0 or +-1), including
+///         loading 1-of-N OR ciphertexts from bytes, and coefficient
+///         recovery with and without the reconstruction cache.
+///
+
+#include <benchmark/benchmark.h>
+
+#include "bench_common.h"
+
+using namespace std;
+
+#define DECRYPT_MSG_LEN   32
+
+// Decrypts a ciphertext whose policy (CP) or key policy (KP) is an AND of
+// 'leaves' attributes, so that every leaf is a satisfied row.
+static void runDecrypt(benchmark::State& state, OpenABE_SCHEME scheme,
+                       const string &policy, const string &attributes) {
+    const unsigned int threads = state.range(1);
+    unique_ptr<OpenABEContextSchemeCPA> context = createContextABESchemeCPA(scheme);
+    if (context->generateParams(BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR) {
+        state.SkipWithError("generateParams failed");
+        return;
+    }
+    unique_ptr<OpenABEFunctionInput> encInput, keyInput;
+    if (scheme == OpenABE_SCHEME_CP_WATERS) {
+        encInput = createPolicyTree(policy);
+        keyInput = createAttributeList(attributes);
+    } else {
+        encInput = createAttributeList(attributes);
+        keyInput = createPolicyTree(policy);
+    }
+    OpenABEByteString plaintext, recovered;
+    getRandomBytes(plaintext, DECRYPT_MSG_LEN);
+    OpenABECiphertext ciphertext;
+    if (context->keygen(keyInput.get(), BENCH_KEY, BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR ||
+        context->encrypt(BENCH_MPK, encInput.get(), plaintext, ciphertext) != OpenABE_NOERROR) {
+        state.SkipWithError("setup failed");
+        return;
+    }
+    context->setDecryptionThreads(threads);
+
+    for (auto _ : state) {
+        if (context->decrypt(BENCH_MPK, BENCH_KEY, recovered, ciphertext) != OpenABE_NOERROR) {
+            state.SkipWithError("decrypt failed");
+            return;
+        }
+    }
+    state.counters["workers"] = OpenABE_getWorkerCount(threads, state.range(0));
+}
+
+static void BM_CPWatersDecrypt(benchmark::State& state) {
+    const int leaves = state.range(0);
+    runDecrypt(state, OpenABE_SCHEME_CP_WATERS, getFlatPolicyString(leaves, "and"),
+               getAttributeListString(leaves));
+}
+BENCHMARK(BM_CPWatersDecrypt)
+    ->ArgNames({"leaves", "threads"})
+    ->ArgsProduct({{8, 32, 128}, {1, 2, 4, 8, 16, 32}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+static void BM_KPGPSWDecrypt(benchmark::State& state) {
+    const int leaves = state.range(0);
+    runDecrypt(state, OpenABE_SCHEME_KP_GPSW, getFlatPolicyString(leaves, "and"),
+               getAttributeListString(leaves));
+}
+BENCHMARK(BM_KPGPSWDecrypt)
+    ->ArgNames({"leaves", "threads"})
+    ->ArgsProduct({{8, 32, 128}, {1, 2, 4, 8, 16, 32}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// AND of (A or B) clauses with one attribute per clause: half the leaves are
+// unsatisfied and the OR gates contribute coefficients of 1.
+static void BM_CPWatersDecryptOrPairs(benchmark::State& state) {
+    const int pairs = state.range(0);
+    runDecrypt(state, OpenABE_SCHEME_CP_WATERS, getOrPairsPolicyString(pairs),
+               getOrPairsAttributeString(pairs));
+}
+BENCHMARK(BM_CPWatersDecryptOrPairs)
+    ->ArgNames({"pairs", "threads"})
+    ->ArgsProduct({{8, 32, 128}, {1}})
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_KPGPSWDecryptOrPairs(benchmark::State& state) {
+    const int pairs = state.range(0);
+    runDecrypt(state, OpenABE_SCHEME_KP_GPSW, getOrPairsPolicyString(pairs),
+               getOrPairsAttributeString(pairs));
+}
+BENCHMARK(BM_KPGPSWDecryptOrPairs)
+    ->ArgNames({"pairs", "threads"})
+    ->ArgsProduct({{8, 32, 128}, {1}})
+    ->Unit(benchmark::kMillisecond);
+
+// Loads a serialized CP ciphertext under a 1-of-N OR policy and decrypts it
+// with a key holding a single attribute, so one row of N is used.
+static void BM_CPWatersLoadAndDecryptOneOfN(benchmark::State& state) {
+    const int leaves = state.range(0);
+    unique_ptr<OpenABEContextSchemeCPA> context = createContextABESchemeCPA(OpenABE_SCHEME_CP_WATERS);
+    if (context->generateParams(BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR) {
+        state.SkipWithError("generateParams failed");
+        return;
+    }
+    unique_ptr<OpenABEPolicy> policy = createPolicyTree(getFlatPolicyString(leaves, "or"));
+    unique_ptr<OpenABEAttributeList> attributes = createAttributeList(createAttribute(leaves - 1));
+    OpenABEByteString plaintext, recovered, ctBlob;
+    getRandomBytes(plaintext, DECRYPT_MSG_LEN);
+    OpenABECiphertext ciphertext;
+    if (context->keygen(attributes.get(), BENCH_KEY, BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR ||
+        context->encrypt(BENCH_MPK, policy.get(), plaintext, ciphertext) != OpenABE_NOERROR) {
+        state.SkipWithError("setup failed");
+        return;
+    }
+    ciphertext.exportToBytes(ctBlob);
+
+    for (auto _ : state) {
+        OpenABECiphertext loaded;
+        loaded.loadFromBytes(ctBlob);
+        if (context->decrypt(BENCH_MPK, BENCH_KEY, recovered, loaded) != OpenABE_NOERROR) {
+            state.SkipWithError("decrypt failed");
+            return;
+        }
+    }
+    state.counters["leaves"] = leaves;
+    state.counters["bytes"] = ctBlob.size();
+}
+BENCHMARK(BM_CPWatersLoadAndDecryptOneOfN)
+    ->ArgName("leaves")
+    ->RangeMultiplier(4)->Range(4, 1024)
+    ->Unit(benchmark::kMillisecond);
+
+// Recovers the coefficients of a flat AND policy of 'leaves' attributes
+// for the same attribute set; 'cached' selects whether the reconstruction
+// cache is enabled.
+static void BM_RecoverCoefficientsCached(benchmark::State& state) {
+    const int leaves = state.range(0);
+    const bool cached = state.range(1);
+    OpenABEPairing pairing;
+    OpenABEReconstructionCache& cache = OpenABEReconstructionCache::getInstance();
+    cache.clear();
+    cache.resetStats();
+    cache.setMaxBytes(cached ? DEFAULT_RECONSTRUCTION_CACHE_BYTES : 0);
+
+    const string policy = getFlatPolicyString(leaves, "and");
+    unique_ptr<OpenABEAttributeList> attributes = createAttributeList(getAttributeListString(leaves));
+    for (auto _ : state) {
+        if (OpenABE_recoverCoefficients(policy, attributes.get()) == nullptr) {
+            state.SkipWithError("recovery failed");
+            return;
+        }
+    }
+
+    OpenABECacheStats stats = cache.getStats();
+    state.counters["hit_rate"] = (stats.hits + stats.misses) ?
+        (double)stats.hits / (stats.hits + stats.misses) : 0.0;
+    state.counters["cache_bytes"] = stats.bytes;
+    cache.setMaxBytes(DEFAULT_RECONSTRUCTION_CACHE_BYTES);
+    cache.clear();
+}
+BENCHMARK(BM_RecoverCoefficientsCached)
+    ->ArgNames({"leaves", "cached"})
+    ->ArgsProduct({{8, 128, 1024}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
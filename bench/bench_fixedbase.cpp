@@ -0,0 +1,141 @@
+///
+/// \file   bench_fixedbase.cpp
+///
+/// \brief  Fixed-base vs. generic scalar multiplication for the MPK
+///         generators and GT exponentiation, and CP-Waters encryption
+///         as the policy grows.
+///
+
+#include <benchmark/benchmark.h>
+
+#include "bench_common.h"
+
+using namespace std;
+
+static void BM_G1Mul_Generic(benchmark::State& state) {
+    OpenABEPairing pairing;
+    G1 g1 = pairing.randomG1();
+    ZP k = pairing.randomZP();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(g1 * k);
+    }
+}
+BENCHMARK(BM_G1Mul_Generic);
+
+static void BM_G1Mul_FixedBase(benchmark::State& state) {
+    OpenABEPairing pairing;
+    G1FixedBase g1(pairing.randomG1());
+    ZP k = pairing.randomZP();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(g1 * k);
+    }
+}
+BENCHMARK(BM_G1Mul_FixedBase);
+
+static void BM_G2Mul_Generic(benchmark::State& state) {
+    OpenABEPairing pairing;
+    G2 g2 = pairing.randomG2();
+    ZP k = pairing.randomZP();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(g2 * k);
+    }
+}
+BENCHMARK(BM_G2Mul_Generic);
+
+static void BM_G2Mul_FixedBase(benchmark::State& state) {
+    OpenABEPairing pairing;
+    G2FixedBase g2(pairing.randomG2());
+    ZP k = pairing.randomZP();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(g2 * k);
+    }
+}
+BENCHMARK(BM_G2Mul_FixedBase);
+
+// Per-row generator work of CP-Waters encryption (g2^ri and g1a^share)
+// with and without the fixed-base tables, as a function of the row count.
+static void BM_CPWatersRows(benchmark::State& state) {
+    const int rows = state.range(0);
+    const bool fixed = state.range(1);
+    OpenABEPairing pairing;
+    G1 g1a = pairing.randomG1();
+    G2 g2 = pairing.randomG2();
+    G1FixedBase g1aTable(g1a);
+    G2FixedBase g2Table(g2);
+    vector<ZP> scalars;
+    for (int i = 0; i < rows; i++) {
+        scalars.push_back(pairing.randomZP());
+    }
+
+    for (auto _ : state) {
+        for (int i = 0; i < rows; i++) {
+            if (fixed) {
+                benchmark::DoNotOptimize(g2Table * scalars[i]);
+                benchmark::DoNotOptimize(g1aTable * scalars[i]);
+            } else {
+                benchmark::DoNotOptimize(g2 * scalars[i]);
+                benchmark::DoNotOptimize(g1a * scalars[i]);
+            }
+        }
+    }
+    state.counters["rows"] = rows;
+}
+BENCHMARK(BM_CPWatersRows)
+    ->ArgNames({"rows", "fixed"})
+    ->ArgsProduct({{1, 4, 16, 64, 256}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_CPWatersEncryptKEM(benchmark::State& state) {
+    const int leaves = state.range(0);
+    OpenABEContextCPWaters context;
+    if (context.generateParams(BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR) {
+        state.SkipWithError("generateParams failed");
+        return;
+    }
+    unique_ptr<OpenABEPolicy> policy = createPolicyTree(getFlatPolicyString(leaves, "and"));
+    shared_ptr<OpenABESymKey> key = make_shared<OpenABESymKey>();
+
+    for (auto _ : state) {
+        OpenABECiphertext ciphertext;
+        if (context.encryptKEM(BENCH_MPK, policy.get(), DEFAULT_SYM_KEY_BYTES,
+                               key, ciphertext) != OpenABE_NOERROR) {
+            state.SkipWithError("encryptKEM failed");
+            break;
+        }
+    }
+    state.counters["leaves"] = leaves;
+}
+BENCHMARK(BM_CPWatersEncryptKEM)
+    ->RangeMultiplier(4)->Range(1, 256)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_GTExp_Generic(benchmark::State& state) {
+    OpenABEPairing pairing;
+    GT A = pairing.pairing(pairing.randomG1(), pairing.randomG2());
+    ZP k = pairing.randomZP();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(A.exp(k));
+    }
+}
+BENCHMARK(BM_GTExp_Generic);
+
+static void BM_GTExp_FixedBase(benchmark::State& state) {
+    OpenABEPairing pairing;
+    GT A = pairing.pairing(pairing.randomG1(), pairing.randomG2());
+    A.setFixedBase(make_shared<GTFixedBase>(A));
+    ZP k = pairing.randomZP();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(A.exp(k));
+    }
+}
+BENCHMARK(BM_GTExp_FixedBase);
+
+static void BM_GTFixedBase_Precompute(benchmark::State& state) {
+    OpenABEPairing pairing;
+    GT A = pairing.pairing(pairing.randomG1(), pairing.randomG2());
+    for (auto _ : state) {
+        GTFixedBase table(A);
+        benchmark::DoNotOptimize(&table);
+    }
+}
+BENCHMARK(BM_GTFixedBase_Precompute)->Unit(benchmark::kMillisecond);
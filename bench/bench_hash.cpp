@@ -0,0 +1,45 @@
+///
+/// \file   bench_hash.cpp
+///
+/// \brief  hash_to_G1 of attributes with and without the point cache.
+///
+
+#include <benchmark/benchmark.h>
+
+#include "bench_common.h"
+
+using namespace std;
+
+// Hashes a vocabulary of 'attrs' attributes round-robin; 'cached' selects
+// whether the hash_to_G1 cache is enabled.
+static void BM_HashToG1(benchmark::State& state) {
+    const int attrs = state.range(0);
+    const bool cached = state.range(1);
+    OpenABEPairing pairing;
+    OpenABEHashToG1Cache& cache = OpenABEHashToG1Cache::getInstance();
+    cache.clear();
+    cache.resetStats();
+    cache.setMaxBytes(cached ? DEFAULT_HASH_TO_G1_CACHE_BYTES : 0);
+
+    OpenABEByteString k;
+    getRandomBytes(k, 32);
+    vector<string> vocabulary;
+    for (int i = 0; i < attrs; i++) {
+        vocabulary.push_back(createAttribute(i));
+    }
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(pairing.hashToG1(k, vocabulary[i++ % vocabulary.size()]));
+    }
+
+    OpenABECacheStats stats = cache.getStats();
+    state.counters["hit_rate"] = (stats.hits + stats.misses) ?
+        (double)stats.hits / (stats.hits + stats.misses) : 0.0;
+    state.counters["cache_bytes"] = stats.bytes;
+    cache.setMaxBytes(DEFAULT_HASH_TO_G1_CACHE_BYTES);
+    cache.clear();
+}
+BENCHMARK(BM_HashToG1)
+    ->ArgNames({"attrs", "cached"})
+    ->ArgsProduct({{100, 10000}, {0, 1}});
@@ -0,0 +1,95 @@
+///
+/// \file   bench_keymgr.cpp
+///
+/// \brief  Keystore manager key search with up to 100k keys per user,
+///         through the inverted attribute index and with the previous
+///         scan over every key of the user.
+///
+
+#include <benchmark/benchmark.h>
+
+#include "bench_common.h"
+
+using namespace std;
+
+#define BENCH_USER  "benchUser"
+
+// stores key metadata directly (no key blobs) and keeps the linear scan
+// for comparison
+class BenchKeystoreManager : public OpenABEKeystoreManager {
+public:
+    void addInput(const string& keyID, unique_ptr<OpenABEFunctionInput> input) {
+        OpenABEMetadata metadata(new _OpenABEMetadata);
+        metadata->userId = BENCH_USER;
+        metadata->inputType = input->getFunctionType();
+        metadata->input = move(input);
+        addKeyMetadata(keyID, metadata);
+    }
+
+    const string scanKeys(OpenABEFunctionInput *funcInput) {
+        for (auto& keyID : filterKeys(BENCH_USER, funcInput->getFunctionType())) {
+            if (testAKey(keyMetadata_[keyID], funcInput).first) {
+                return keyID;
+            }
+        }
+        return "";
+    }
+};
+
+static unique_ptr<BenchKeystoreManager> gKeyManager;
+
+// key i holds Dept(i % 100), Role(i % 50) and a unique attribute; with
+// policy keys, the key policy is the AND of the first two
+static void SetupKeyManager(const benchmark::State& state) {
+    const bool policyKeys = state.range(1);
+    gKeyManager.reset(new BenchKeystoreManager);
+    for (int i = 0; i < state.range(0); i++) {
+        const string dept = "Dept" + to_string(i % 100), role = "Role" + to_string(i % 50);
+        if (policyKeys) {
+            gKeyManager->addInput("key" + to_string(i), createPolicyTree(
+                "((" + dept + " and " + role + ") and Id" + to_string(i) + ")"));
+        } else {
+            gKeyManager->addInput("key" + to_string(i), createAttributeList(
+                "|" + dept + "|" + role + "|Id" + to_string(i) + "|"));
+        }
+    }
+}
+
+static void TeardownKeyManager(const benchmark::State&) {
+    gKeyManager.reset();
+}
+
+// searches for the last key added, so the scan
+// visits every key before it finds a match
+static void BM_KeySearch(benchmark::State& state) {
+    const int numKeys = state.range(0);
+    const bool policyKeys = state.range(1), indexed = state.range(2);
+    const int last = numKeys - 1;
+    const string dept = "Dept" + to_string(last % 100), role = "Role" + to_string(last % 50);
+    unique_ptr<OpenABEFunctionInput> ctInput;
+    if (policyKeys) {
+        ctInput = createAttributeList("|" + dept + "|" + role + "|Id" + to_string(last) + "|");
+    } else {
+        ctInput = createPolicyTree("((" + dept + " and " + role + ") and Id" + to_string(last) + ")");
+    }
+    OpenABEKeyQuery query;
+    query.isEfficient = false;
+    query.currentTime = 0;
+    query.userId = BENCH_USER;
+
+    for (auto _ : state) {
+        const string keyID = indexed ? gKeyManager->searchKeyCommand(&query, ctInput.get())
+                                     : gKeyManager->scanKeys(ctInput.get());
+        if (keyID.empty()) {
+            state.SkipWithError("no key found");
+            break;
+        }
+    }
+    state.SetLabel(policyKeys ? "policy keys" : "attribute keys");
+}
+BENCHMARK(BM_KeySearch)
+    ->ArgNames({"keys", "policy", "indexed"})
+    ->ArgsProduct({{1000, 10000, 100000}, {0, 1}, {0, 1}})
+    ->Setup(SetupKeyManager)
+    ->Teardown(TeardownKeyManager)
+    ->Unit(benchmark::kMicrosecond);
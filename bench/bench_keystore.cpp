@@ -0,0 +1,56 @@
+///
+/// \file   bench_keystore.cpp
+///
+/// \brief  Keystore lookups from several threads, with the sharded
+///         keystore and with a global mutex around it (what callers had
+///         to do before the keystore was thread-safe).
+///
+
+#include <benchmark/benchmark.h>
+
+#include <mutex>
+
+#include "bench_common.h"
+
+using namespace std;
+
+static unique_ptr<OpenABEKeystore> gKeystore;
+static vector<string> gKeyIDs;
+static mutex gGlobalLock;
+
+static void SetupKeystore(const benchmark::State& state) {
+    gKeystore.reset(new OpenABEKeystore);
+    gKeyIDs.clear();
+    for (int i = 0; i < state.range(0); i++) {
+        string keyID = "key" + to_string(i);
+        gKeystore->addKey(keyID, make_shared<OpenABEKey>(), (i % 2) ? KEY_TYPE_SECRET : KEY_TYPE_PUBLIC);
+        gKeyIDs.push_back(keyID);
+    }
+}
+
+static void TeardownKeystore(const benchmark::State&) {
+    gKeystore.reset();
+    gKeyIDs.clear();
+}
+
+static void BM_KeystoreLookup(benchmark::State& state) {
+    const bool globalLock = state.range(1);
+    size_t i = state.thread_index() * 7919;
+    for (auto _ : state) {
+        const string& keyID = gKeyIDs[i++ % gKeyIDs.size()];
+        if (globalLock) {
+            lock_guard<mutex> guard(gGlobalLock);
+            benchmark::DoNotOptimize(gKeystore->getKey(keyID));
+        } else {
+            benchmark::DoNotOptimize(gKeystore->getKey(keyID));
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_KeystoreLookup)
+    ->ArgNames({"keys", "global_lock"})
+    ->ArgsProduct({{1000}, {0, 1}})
+    ->Setup(SetupKeystore)
+    ->Teardown(TeardownKeystore)
+    ->ThreadRange(1, 32)
+    ->UseRealTime();
@@ -0,0 +1,33 @@
+///
+/// \file   bench_main.cpp
+///
+/// \brief  Entry point for the OpenABE benchmarks.
+///
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include <abe_lsss.h>
+
+int main(int argc, char **argv) {
+    InitializeOpenABE();
+
+    // recorded in the "context" section of the JSON output
+    ::benchmark::AddCustomContext("openabe_library_version",
+                                  std::to_string(OpenABE_getLibraryVersion()));
+    ::benchmark::AddCustomContext("compression",
+                                  OpenABE_GetCompressionOption() ? "on" : "off");
+
+    ::benchmark::Initialize(&argc, argv);
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        ShutdownOpenABE();
+        return 1;
+    }
+    ::benchmark::RunSpecifiedBenchmarks();
+    ::benchmark::Shutdown();
+
+    ShutdownOpenABE();
+
+    return 0;
+}
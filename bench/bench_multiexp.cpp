@@ -0,0 +1,68 @@
+///
+/// \file   bench_multiexp.cpp
+///
+/// \brief  Multi-scalar multiplication vs. one scalar multiplication and
+///         addition per term, as used for prod1 in decryption.
+///
+
+#include <benchmark/benchmark.h>
+
+#include "bench_common.h"
+
+using namespace std;
+
+static void BM_G1SumOfProducts(benchmark::State& state) {
+    const int terms = state.range(0);
+    const bool multiExp = state.range(1);
+    OpenABEPairing pairing;
+    vector<G1> points;
+    vector<ZP> scalars;
+    for (int i = 0; i < terms; i++) {
+        points.push_back(pairing.randomG1());
+        scalars.push_back(pairing.randomZP());
+    }
+
+    for (auto _ : state) {
+        if (multiExp) {
+            benchmark::DoNotOptimize(G1::multiExp(points, scalars));
+        } else {
+            G1 sum;
+            for (int i = 0; i < terms; i++) {
+                sum += points[i] * scalars[i];
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+    }
+}
+BENCHMARK(BM_G1SumOfProducts)
+    ->ArgNames({"terms", "multiexp"})
+    ->ArgsProduct({{2, 8, 32, 128}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_G2SumOfProducts(benchmark::State& state) {
+    const int terms = state.range(0);
+    const bool multiExp = state.range(1);
+    OpenABEPairing pairing;
+    vector<G2> points;
+    vector<ZP> scalars;
+    for (int i = 0; i < terms; i++) {
+        points.push_back(pairing.randomG2());
+        scalars.push_back(pairing.randomZP());
+    }
+
+    for (auto _ : state) {
+        if (multiExp) {
+            benchmark::DoNotOptimize(G2::multiExp(points, scalars));
+        } else {
+            G2 sum;
+            for (int i = 0; i < terms; i++) {
+                sum += points[i] * scalars[i];
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+    }
+}
+BENCHMARK(BM_G2SumOfProducts)
+    ->ArgNames({"terms", "multiexp"})
+    ->ArgsProduct({{2, 8, 32, 128}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
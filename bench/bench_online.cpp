@@ -0,0 +1,65 @@
+///
+/// \file   bench_online.cpp
+///
+/// \brief  Online cost of CP-Waters encryption with and without the pool of
+///         precomputed randomness (online/offline encryption).
+///
+
+#include <benchmark/benchmark.h>
+
+#include "bench_common.h"
+
+using namespace std;
+
+// encryptKEM on the request thread; with the pool enabled it is refilled
+// outside the timed region so that every iteration hits
+static void BM_EncryptKEMOnline(benchmark::State& state) {
+    const int leaves = state.range(0);
+    const bool precompute = state.range(1);
+    OpenABEContextCPWaters context;
+    if (context.generateParams(BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR) {
+        state.SkipWithError("generateParams failed");
+        return;
+    }
+    unique_ptr<OpenABEPolicy> policy = createPolicyTree(getFlatPolicyString(leaves, "and"));
+    shared_ptr<OpenABESymKey> key = make_shared<OpenABESymKey>();
+
+    OpenABEPrecomputeSettings settings;
+    settings.sessionDepth = 1;
+    settings.shareDepth = leaves;
+    settings.attributeDepth = 1;
+    shared_ptr<OpenABEPrecomputePool> pool;
+    if (precompute) {
+        context.enablePrecomputation(BENCH_MPK, settings);
+        pool = context.getPrecomputePool(BENCH_MPK);
+        // stop the background thread: refills below are explicit
+        pool->stop();
+        OpenABECiphertext warmup;
+        context.encryptKEM(BENCH_MPK, policy.get(), DEFAULT_SYM_KEY_BYTES, key, warmup);
+        pool->resetStats();
+    }
+
+    for (auto _ : state) {
+        if (pool != nullptr) {
+            state.PauseTiming();
+            pool->refill(2 * leaves + 1);
+            state.ResumeTiming();
+        }
+        OpenABECiphertext ciphertext;
+        if (context.encryptKEM(BENCH_MPK, policy.get(), DEFAULT_SYM_KEY_BYTES,
+                               key, ciphertext) != OpenABE_NOERROR) {
+            state.SkipWithError("encryptKEM failed");
+            break;
+        }
+    }
+    if (pool != nullptr) {
+        OpenABEPrecomputeStats stats = pool->getStats();
+        state.counters["hits"] = stats.sessionHits + stats.shareHits + stats.attributeHits;
+        state.counters["misses"] = stats.sessionMisses + stats.shareMisses + stats.attributeMisses;
+    }
+    state.counters["leaves"] = leaves;
+}
+BENCHMARK(BM_EncryptKEMOnline)
+    ->ArgNames({"leaves", "precompute"})
+    ->ArgsProduct({{1, 4, 16, 64}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
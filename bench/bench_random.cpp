@@ -0,0 +1,89 @@
+///
+/// \file   bench_random.cpp
+///
+/// \brief  Random scalar and byte throughput on 1, 8 and 32 threads. The
+///         per-thread buffered generator is compared against RELIC's
+///         bn_rand_mod and rand_bytes.
+///
+
+#include <benchmark/benchmark.h>
+
+#include "bench_common.h"
+
+using namespace std;
+
+// bn_rand_mod on top of RELIC's rand_bytes, which sampling used before
+static void BM_RandomZP_Relic(benchmark::State& state) {
+    if (!OpenABE_isThreadSafe() && state.threads() > 1) {
+        state.SkipWithError("RELIC was not built with MULTI=PTHREAD");
+        return;
+    }
+    OpenABEPairing pairing;
+    ZP z = pairing.initZP();
+    for (auto _ : state) {
+        bn_rand_mod(z.m_ZP, pairing.order);
+        benchmark::DoNotOptimize(z);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RandomZP_Relic)->Threads(1)->Threads(8)->Threads(32)->UseRealTime();
+
+static void BM_RandomZP(benchmark::State& state) {
+    if (!OpenABE_isThreadSafe() && state.threads() > 1) {
+        state.SkipWithError("RELIC was not built with MULTI=PTHREAD");
+        return;
+    }
+    OpenABEPairing pairing;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(pairing.randomZP());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RandomZP)->Threads(1)->Threads(8)->Threads(32)->UseRealTime();
+
+// scalars per iteration given by the argument, e.g. the coefficients of
+// one secret sharing
+static void BM_RandomZPs(benchmark::State& state) {
+    if (!OpenABE_isThreadSafe() && state.threads() > 1) {
+        state.SkipWithError("RELIC was not built with MULTI=PTHREAD");
+        return;
+    }
+    const size_t count = state.range(0);
+    OpenABEPairing pairing;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(pairing.randomZPs(count));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_RandomZPs)->Arg(64)->Threads(1)->Threads(8)->Threads(32)->UseRealTime();
+
+// 12-byte nonces, as drawn for every AES-GCM encryption
+static void BM_RandomNonce_Relic(benchmark::State& state) {
+    if (!OpenABE_isThreadSafe() && state.threads() > 1) {
+        state.SkipWithError("RELIC was not built with MULTI=PTHREAD");
+        return;
+    }
+    OpenABEPairing pairing;
+    uint8_t nonce[12];
+    for (auto _ : state) {
+        rand_bytes(nonce, sizeof(nonce));
+        benchmark::DoNotOptimize(nonce);
+    }
+    state.SetBytesProcessed(state.iterations() * sizeof(nonce));
+}
+BENCHMARK(BM_RandomNonce_Relic)->Threads(1)->Threads(8)->Threads(32)->UseRealTime();
+
+static void BM_RandomNonce(benchmark::State& state) {
+    if (!OpenABE_isThreadSafe() && state.threads() > 1) {
+        state.SkipWithError("RELIC was not built with MULTI=PTHREAD");
+        return;
+    }
+    OpenABEPairing pairing;
+    uint8_t nonce[12];
+    for (auto _ : state) {
+        getRandomBytes(nonce, sizeof(nonce));
+        benchmark::DoNotOptimize(nonce);
+    }
+    state.SetBytesProcessed(state.iterations() * sizeof(nonce));
+}
+BENCHMARK(BM_RandomNonce)->Threads(1)->Threads(8)->Threads(32)->UseRealTime();
@@ -0,0 +1,49 @@
+///
+/// \file   bench_scaling.cpp
+///
+/// \brief  Encrypt/decrypt throughput as the number of threads grows.
+///         Every thread uses its own scheme context, which is the
+///         supported way of running OpenABE concurrently.
+///
+
+#include <benchmark/benchmark.h>
+
+#include <thread>
+
+#include "bench_common.h"
+
+using namespace std;
+
+// one encrypt and one decrypt per iteration on a 4-leaf AND policy;
+// items/s in the output is the aggregate throughput of all threads
+static void BM_EncryptDecryptScaling(benchmark::State& state) {
+    if (!OpenABE_isThreadSafe() && state.threads() > 1) {
+        state.SkipWithError("RELIC was not built with MULTI=PTHREAD");
+        return;
+    }
+    unique_ptr<OpenABEContextSchemeCPA> context =
+        createContextABESchemeCPA(OpenABE_SCHEME_CP_WATERS);
+    unique_ptr<OpenABEFunctionInput> encInput = createPolicyTree(getFlatPolicyString(4, "and"));
+    unique_ptr<OpenABEFunctionInput> keyInput = createAttributeList(getAttributeListString(4));
+    OpenABEByteString plaintext, recovered;
+    getRandomBytes(plaintext, 256);
+    if (context->generateParams(BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR ||
+        context->keygen(keyInput.get(), BENCH_KEY, BENCH_MPK, BENCH_MSK) != OpenABE_NOERROR) {
+        state.SkipWithError("setup failed");
+        return;
+    }
+
+    for (auto _ : state) {
+        OpenABECiphertext ciphertext;
+        if (context->encrypt(BENCH_MPK, encInput.get(), plaintext, ciphertext) != OpenABE_NOERROR ||
+            context->decrypt(BENCH_MPK, BENCH_KEY, recovered, ciphertext) != OpenABE_NOERROR) {
+            state.SkipWithError("encrypt/decrypt failed");
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EncryptDecryptScaling)
+    ->ThreadRange(1, max(1u, thread::hardware_concurrency()))
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,100 @@
+///
+/// \file   bench_segmented.cpp
+///
+/// \brief  Single-nonce AES-GCM vs. segmented STREAM_GCM encryption of a
+///         large payload as the thread count grows, and the cost of a
+///         random single-segment read.
+///
+
+#include <benchmark/benchmark.h>
+
+#include <thread>
+
+#include "bench_common.h"
+
+using namespace std;
+
+#define BENCH_SEGMENTED_PAYLOAD_MB  64
+
+static void BM_GCMEncrypt(benchmark::State& state) {
+    OpenABEByteString key, plaintext, iv, ciphertext, tag;
+    getRandomBytes(key, DEFAULT_SYM_KEY_BYTES);
+    getRandomBytes(plaintext, BENCH_SEGMENTED_PAYLOAD_MB << 20);
+    string input = plaintext.toString();
+    OpenABESymKeyAuthEnc gcm(DEFAULT_AES_SEC_LEVEL, key);
+    gcm.setAddAuthData(NULL, 0);
+
+    for (auto _ : state) {
+        gcm.encrypt(input, iv, ciphertext, tag);
+        benchmark::DoNotOptimize(ciphertext.data());
+    }
+    state.SetBytesProcessed(state.iterations() * plaintext.size());
+}
+BENCHMARK(BM_GCMEncrypt)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_SegmentedEncrypt(benchmark::State& state) {
+    const unsigned int threads = state.range(0);
+    OpenABEByteString key, plaintext, header, ciphertext;
+    getRandomBytes(key, DEFAULT_SYM_KEY_BYTES);
+    getRandomBytes(plaintext, BENCH_SEGMENTED_PAYLOAD_MB << 20);
+    OpenABESymKeySegmentedAuthEnc stream(DEFAULT_AES_SEC_LEVEL, key);
+
+    for (auto _ : state) {
+        stream.encrypt(plaintext, header, ciphertext, threads);
+        benchmark::DoNotOptimize(ciphertext.data());
+    }
+    state.SetBytesProcessed(state.iterations() * plaintext.size());
+    state.counters["threads"] = threads;
+}
+BENCHMARK(BM_SegmentedEncrypt)
+    ->ArgName("threads")
+    ->DenseRange(1, max(1u, thread::hardware_concurrency()), 1)
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_SegmentedDecrypt(benchmark::State& state) {
+    const unsigned int threads = state.range(0);
+    OpenABEByteString key, plaintext, header, ciphertext, decrypted;
+    getRandomBytes(key, DEFAULT_SYM_KEY_BYTES);
+    getRandomBytes(plaintext, BENCH_SEGMENTED_PAYLOAD_MB << 20);
+    OpenABESymKeySegmentedAuthEnc stream(DEFAULT_AES_SEC_LEVEL, key);
+    if (stream.encrypt(plaintext, header, ciphertext) != OpenABE_NOERROR) {
+        state.SkipWithError("encrypt failed");
+        return;
+    }
+
+    for (auto _ : state) {
+        if (!stream.decrypt(decrypted, header, ciphertext, threads)) {
+            state.SkipWithError("decrypt failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * plaintext.size());
+    state.counters["threads"] = threads;
+}
+BENCHMARK(BM_SegmentedDecrypt)
+    ->ArgName("threads")
+    ->DenseRange(1, max(1u, thread::hardware_concurrency()), 1)
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// range read: authenticate and decrypt one segment out of the payload
+static void BM_SegmentedRandomRead(benchmark::State& state) {
+    OpenABEByteString key, plaintext, header, ciphertext, segment, decrypted;
+    getRandomBytes(key, DEFAULT_SYM_KEY_BYTES);
+    getRandomBytes(plaintext, BENCH_SEGMENTED_PAYLOAD_MB << 20);
+    OpenABESymKeySegmentedAuthEnc stream(DEFAULT_AES_SEC_LEVEL, key);
+    stream.encrypt(plaintext, header, ciphertext);
+    size_t sealed = OpenABE_STREAM_SEGMENT_SIZE + AES_BLOCK_SIZE;
+    size_t count = OpenABESymKeySegmentedAuthEnc::getSegmentCount(ciphertext.size(),
+                                                                  OpenABE_STREAM_SEGMENT_SIZE);
+    size_t index = count / 2;
+    segment = ciphertext.getSubset(index * sealed, sealed);
+
+    for (auto _ : state) {
+        if (!stream.decryptSegment(decrypted, header, segment, index, false)) {
+            state.SkipWithError("decryptSegment failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * OpenABE_STREAM_SEGMENT_SIZE);
+}
+BENCHMARK(BM_SegmentedRandomRead)->Unit(benchmark::kMicrosecond);
@@ -10,7 +10,8 @@ git clone --branch ${RELIC_TAG} --depth 1 https://github.com/relic-toolkit/relic
 
 mkdir -p /tmp/relic/build-${CURVE}
 cd /tmp/relic/build-${CURVE}
-sed -i 's/-DSHLIB=OFF -DSTBIN=ON/-DSHLIB=ON -DSTBIN=OFF/' ../preset/x64-pbc-${CURVE}.sh
+# MULTI=PTHREAD gives every thread its own RELIC context
+sed -i 's/-DSHLIB=OFF -DSTBIN=ON/-DSHLIB=ON -DSTBIN=OFF -DMULTI=PTHREAD/' ../preset/x64-pbc-${CURVE}.sh
 ../preset/x64-pbc-${CURVE}.sh ..
 make -j && sudo make install
 sudo cp /tmp/relic/src/md/blake2.h /usr/local/include/
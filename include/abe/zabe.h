@@ -9,6 +9,7 @@ extern "C" {
 }
 
 #include "../lsss/zlsss.h"
+#include "../lsss/zrandom.h"
 
 #include "zerror.h"
 #include "zexception.h"
@@ -36,8 +36,10 @@
 #define __ZCIPHERTEXT_H__
 
 #include <map>
+#include <span>
 
 #include "zcontainer.h"
+#include "zflatciphertext.h"
 
 /// \class	ZCiphertext
 /// \brief	Generic container for Functional Encryption ciphertexts.
@@ -76,6 +78,11 @@ public:
   void exportToBytes(OpenABEByteString &output);
   void loadFromBytes(OpenABEByteString &input);
 
+  // flat layout with a component table (see zflatciphertext.h);
+  // loadFromBytes also accepts it
+  void exportToFlatBytes(OpenABEByteString &output);
+  void loadFromFlatBytes(std::span<const uint8_t> input);
+
   void exportToBytesWithoutHeader(OpenABEByteString& output);
   void loadFromBytesWithoutHeader(OpenABEByteString& input);
 };
@@ -0,0 +1,178 @@
+/// 
+/// Copyright (c) 2018 Zeutro, LLC. All rights reserved.
+/// 
+/// This file is part of Zeutro's OpenABE.
+/// 
+/// OpenABE is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU Affero General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+/// 
+/// OpenABE is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU Affero General Public License for more details.
+/// 
+/// You should have received a copy of the GNU Affero General Public
+/// License along with OpenABE. If not, see <http://www.gnu.org/licenses/>.
+/// 
+/// You can be released from the requirements of the GNU Affero General
+/// Public License and obtain additional features by purchasing a
+/// commercial license. Buying such a license is mandatory if you
+/// engage in commercial activities involving OpenABE that do not
+/// comply with the open source requirements of the GNU Affero General
+/// Public License. For more information on commerical licenses,
+/// visit <http://www.zeutro.com>.
+///
+///
+/// \file   zcompiledpolicy.h
+///
+/// \brief  Class definition for compiled (pre-processed) policies and the
+///         process-wide compiled policy cache.
+///
+
+#ifndef __ZCOMPILEDPOLICY_H__
+#define __ZCOMPILEDPOLICY_H__
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../lsss/zpolicy.h"
+#include "../lsss/zelement_bp.h"
+#include "../lsss/zlsss.h"
+#include "zpairing.h"
+
+// default number of policies kept by the compiled policy cache
+#define DEFAULT_COMPILED_POLICY_CACHE_SIZE  128
+// default memory budget of the reconstruction coefficient cache
+#define DEFAULT_RECONSTRUCTION_CACHE_BYTES  (4 * 1024 * 1024)
+
+class OpenABEPairing;
+
+/// \typedef    OpenABEHashedAttributes
+/// \brief      hash_to_G1 point of each attribute, keyed by attribute label
+typedef std::map<std::string, G1> OpenABEHashedAttributes;
+
+///
+/// @class  OpenABECompiledPolicy
+///
+/// @brief  A parsed policy together with everything encryption and
+///         decryption derive from it: the compact policy string, the
+///         share-generating matrix of the LSSS (whose rows are the unique
+///         labels from the LSSS in leaf order) and the hash_to_G1 points
+///         of the attributes for each MPK hash key. It is an
+///         OpenABEPolicy, so it can be passed wherever a policy is
+///         accepted. Once built it is never modified (the hashed points
+///         are filled in under a lock), so it can be shared by threads.
+///
+
+class OpenABECompiledPolicy : public OpenABEPolicy {
+public:
+  OpenABECompiledPolicy(const OpenABEPolicy &policy);
+  ~OpenABECompiledPolicy();
+
+  OpenABECompiledPolicy(const OpenABECompiledPolicy&) = delete;
+  OpenABECompiledPolicy& operator=(const OpenABECompiledPolicy&) = delete;
+
+  const OpenABEByteString& getPolicyBytes() const { return this->m_PolicyBytes; }
+  // (unique row label, attribute label) for every leaf, left to right
+  const std::vector<std::pair<std::string, std::string>>& getRows() const { return this->m_Matrix->getRowLabels(); }
+  std::shared_ptr<const OpenABELSSSMatrix> getMatrix() const { return this->m_Matrix; }
+  std::unique_ptr<OpenABEPolicy> copyPolicyTree() const;
+  std::shared_ptr<const OpenABEHashedAttributes> getHashedAttributes(OpenABEPairing *pairing,
+                                                                     OpenABEByteString &hashKey) const;
+
+private:
+  OpenABEByteString m_PolicyBytes;
+  std::shared_ptr<const OpenABELSSSMatrix> m_Matrix;
+  mutable std::mutex m_Lock;
+  mutable std::map<std::string, std::shared_ptr<const OpenABEHashedAttributes>> m_HashedAttributes;
+};
+
+///
+/// @class  OpenABECompiledPolicyCache
+///
+/// @brief  Process-wide LRU cache of compiled policies, keyed by the policy
+///         string. A miss runs the policy parser once; every later lookup
+///         of the same policy returns the shared compiled policy.
+///
+
+class OpenABECompiledPolicyCache {
+public:
+  static OpenABECompiledPolicyCache& getInstance();
+
+  std::shared_ptr<const OpenABECompiledPolicy> get(const std::string &policyStr);
+  void setCapacity(size_t capacity);
+  size_t size();
+  void clear();
+
+private:
+  OpenABECompiledPolicyCache();
+  void evict();
+
+  typedef std::pair<std::string, std::shared_ptr<const OpenABECompiledPolicy>> Entry;
+
+  std::mutex m_Lock;
+  size_t m_Capacity;
+  // most recently used first
+  std::list<Entry> m_Entries;
+  std::unordered_map<std::string, std::list<Entry>::iterator> m_Index;
+};
+
+///
+/// @class  OpenABEReconstructionCache
+///
+/// @brief  Process-wide, thread-safe LRU cache of LSSS reconstruction
+///         coefficients (the selected rows and their coefficients), keyed
+///         by (hash(policy), hash(attribute set)). The coefficients depend
+///         on nothing else, so a hit replaces the whole coefficient
+///         recovery. Its memory use is bounded by a byte budget; a budget
+///         of zero disables caching.
+///
+
+class OpenABEReconstructionCache {
+public:
+  static OpenABEReconstructionCache& getInstance();
+  static std::string makeKey(const std::string &policyStr, const OpenABEAttributeList &attrList);
+
+  std::shared_ptr<const OpenABELSSSRowMap> lookup(const std::string &key);
+  void insert(const std::string &key, const std::shared_ptr<const OpenABELSSSRowMap> &coefficients);
+
+  void setMaxBytes(size_t maxBytes);
+  OpenABECacheStats getStats();
+  void resetStats();
+  void clear();
+
+private:
+  OpenABEReconstructionCache();
+  void evict();
+  static size_t entrySize(const std::string &key, const OpenABELSSSRowMap &coefficients);
+
+  struct Entry {
+    std::string key;
+    std::shared_ptr<const OpenABELSSSRowMap> coefficients;
+    size_t size;
+  };
+
+  std::mutex m_Lock;
+  size_t m_MaxBytes, m_Bytes;
+  std::atomic<uint64_t> m_Hits, m_Misses, m_Evictions;
+  // most recently used first
+  std::list<Entry> m_Entries;
+  std::unordered_map<std::string, std::list<Entry>::iterator> m_Index;
+};
+
+std::shared_ptr<const OpenABECompiledPolicy> OpenABE_getCompiledPolicy(const std::string &policyStr);
+std::shared_ptr<const OpenABEHashedAttributes> OpenABE_hashPolicyAttributes(OpenABEPairing *pairing,
+                        OpenABEByteString &hashKey, const std::vector<std::pair<std::string, std::string>> &rows);
+std::shared_ptr<const OpenABELSSSRowMap> OpenABE_recoverCoefficients(const std::string &policyStr,
+                                                                     OpenABEAttributeList *attrList);
+
+#endif /* ifdef __ZCOMPILEDPOLICY_H__ */
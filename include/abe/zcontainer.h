@@ -36,10 +36,40 @@
 #define __ZCONTAINER_H__
 
 #include <map>
+#include <mutex>
 
 #include "zabe.h"
 #include "zinteger.h"
 
+/// \class  OpenABELazyElement
+/// \brief  Serialized component that has not been decoded yet. It is
+///         replaced by the decoded element on first access.
+class OpenABELazyElement : public ZObject {
+public:
+  OpenABELazyElement() : ZObject() {}
+  OpenABELazyElement(const OpenABEByteString &bytes) : ZObject(), bytes(bytes) {}
+
+  OpenABELazyElement* clone() const { return new OpenABELazyElement(*this); }
+  void serialize(OpenABEByteString &result) const { result = this->bytes; }
+  const OpenABEByteString& getBytes() const { return this->bytes; }
+  // decode without rebuilding the serialized form (nullptr if unsupported)
+  virtual ZObject* decodeInPlace(const BPGroup *group) const { return nullptr; }
+
+private:
+  OpenABEByteString bytes;
+};
+
+/// Guards lazy decoding of the components. Copies of a container get
+/// their own lock.
+class OpenABEComponentLock {
+public:
+  OpenABEComponentLock() {}
+  OpenABEComponentLock(const OpenABEComponentLock&) {}
+  OpenABEComponentLock& operator=(const OpenABEComponentLock&) { return *this; }
+
+  std::mutex lock;
+};
+
 /// \class	OpenABEContainer
 /// \brief	Generic container for Functional Encryption data structures.
 ///         May be subclassed for specific schemes.
@@ -48,9 +78,16 @@ class OpenABEContainer : protected ZObject {
 protected:
   std::shared_ptr<BPGroup> group;
   std::map<std::string, ZObject*> val;
+  // keep deserialized components as bytes until they are first accessed
+  bool lazyDecoding;
+  OpenABEComponentLock decodeLock;
   void deserialize(OpenABEByteString &blob);
   void deserialize(std::string &blob);
   void deserializeElement(std::string key, OpenABEByteString& value);
+  ZObject* decodeElement(OpenABEByteString& value);
+  void setSerializedComponent(const std::string &name, const OpenABEByteString &value);
+  void decodeAllComponents();
+  void replaceComponent(const std::string &name, ZObject *component);
   void serialize(OpenABEByteString &result) const;
   // void serializeAsTuple(std::vector<std::string>& keys, OpenABEByteString &result) const;
 
@@ -63,6 +100,7 @@ public:
   void        setComponent(const std::string &name, const ZObject *component);
   void        setComponent(const std::string &name, ZObject component);
   ZObject*    getComponent(const std::string &name);
+  bool        hasComponent(const std::string &name) const { return this->val.count(name) > 0; }
   OpenABE_ERROR   deleteComponent(const std::string name);
 
   // Some helper methods for getting components of specific types
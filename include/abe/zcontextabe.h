@@ -36,9 +36,73 @@
 
 // #include <abe_lsss.h>
 
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include "zcontext.h"
 #include "zciphertext.h"
 
+///
+/// @class  OpenABEEncryptionSetup
+///
+/// @brief  Per-recipient encryption state (policy or attribute list, MPK
+///         tables and hashed attributes) that a KEM computes once and then
+///         reuses for every ciphertext of a batch. It is only read during
+///         encryption, so one setup can be shared by several threads.
+///
+
+class OpenABEEncryptionSetup {
+public:
+  virtual ~OpenABEEncryptionSetup() {}
+};
+
+///
+/// @class  OpenABEKeygenSetup
+///
+/// @brief  Master key state (MPK/MSK tables and derived group elements)
+///         that a KEM computes once and then shares across every key of a
+///         batch. Attributes are hashed to G1 at most once per setup, so
+///         users with overlapping attributes share the hashed points.
+///
+
+class OpenABEKeygenSetup {
+public:
+  OpenABEKeygenSetup(OpenABEPairing *pairing, const OpenABEByteString &hashKey);
+  virtual ~OpenABEKeygenSetup() {}
+
+  G1 hashAttribute(const std::string &attribute);
+
+private:
+  OpenABEPairing *pairing;
+  OpenABEByteString hashKey;
+  std::mutex hashLock;
+  std::map<std::string, G1> hashedAttributes;
+};
+
+// minimum number of key rows (attributes or policy leaves) per worker
+// thread when a single key is generated in parallel
+#define OpenABE_MIN_KEYGEN_ROWS_PER_THREAD  8
+
+// minimum number of decryption rows handed to each worker thread
+#define OpenABE_MIN_DECRYPTION_ROWS_PER_THREAD  4
+
+///
+/// @struct OpenABEDecryptionRow
+///
+/// @brief  One satisfied LSSS row on the decryption side. The scheme needs
+///         sum(coeff * sumTerm) in G1 and prod(e(coeff * pairingG1, pairingG2)).
+///
+
+struct OpenABEDecryptionRow {
+  ZP coeff;
+  const G1 *sumTerm;
+  const G1 *pairingG1;
+  const G2 *pairingG2;
+};
+
 ///
 /// @class  OpenABEContextABE
 ///
@@ -62,11 +126,96 @@ public:
   virtual OpenABE_ERROR encryptKEM(const std::string &mpkID, const OpenABEFunctionInput* encryptInput,
                                uint32_t keyByteLen, const std::shared_ptr<OpenABESymKey>& key,
                                OpenABECiphertext& ciphertext) = 0;
+  virtual std::unique_ptr<OpenABEEncryptionSetup> prepareEncryption(const std::string &mpkID,
+                               const OpenABEFunctionInput* encryptInput) = 0;
+  virtual OpenABE_ERROR encryptKEMPrepared(const OpenABEEncryptionSetup *setup, uint32_t keyByteLen,
+                               const std::shared_ptr<OpenABESymKey>& key, OpenABECiphertext& ciphertext) = 0;
   virtual OpenABE_ERROR decryptKEM(const std::string &mpkID, const std::string &keyID, OpenABECiphertext& ciphertext,
                                uint32_t keyByteLen, const std::shared_ptr<OpenABESymKey>& key) = 0;
+
+  // batch key generation: the master key state is prepared once and the
+  // generated keys are returned instead of being added to the keystore
+  // (schemes without support return nullptr / OpenABE_ERROR_NOT_IMPLEMENTED)
+  virtual std::unique_ptr<OpenABEKeygenSetup> prepareKeygen(const std::string &mpkID,
+                               const std::string &mskID) { return nullptr; }
+  virtual OpenABE_ERROR generateDecryptionKeyPrepared(OpenABEKeygenSetup *setup,
+                               OpenABEFunctionInput* keyInput, const std::string &keyID,
+                               std::shared_ptr<OpenABEKey>& decKey,
+                               unsigned int numThreads = 1) { return OpenABE_ERROR_NOT_IMPLEMENTED; }
+
+  // number of threads used by decryptKEM (1, the default, keeps it serial)
+  void setDecryptionThreads(unsigned int numThreads) { this->m_DecryptionThreads = numThreads; }
+  unsigned int getDecryptionThreads() const { return this->m_DecryptionThreads; }
+
+  // online/offline encryption: a background pool of precomputed randomness
+  // per MPK (schemes without support return OpenABE_ERROR_NOT_IMPLEMENTED)
+  virtual OpenABE_ERROR enablePrecomputation(const std::string &mpkID,
+                               const OpenABEPrecomputeSettings &settings) { return OpenABE_ERROR_NOT_IMPLEMENTED; }
+  virtual OpenABE_ERROR disablePrecomputation(const std::string &mpkID) { return OpenABE_ERROR_NOT_IMPLEMENTED; }
+  virtual std::shared_ptr<OpenABEPrecomputePool> getPrecomputePool(const std::string &mpkID) { return nullptr; }
+
+protected:
+  unsigned int m_DecryptionThreads;
+
+  void evaluateDecryptionRows(const std::vector<OpenABEDecryptionRow> &rows, G1 &prod1, GT &prodT);
+  void parallelKeygenRows(size_t numRows, unsigned int numThreads,
+                          const std::function<void(size_t)> &row);
 };
 
 
+// How the CPA payload is masked with the encapsulated key. The mode is
+// stored in the ciphertext ("_PM"); ciphertexts without it use the hash mask.
+typedef enum _OpenABE_PAYLOAD_MODE {
+  OpenABE_PAYLOAD_HASH = 0,
+  OpenABE_PAYLOAD_AES_CTR = 1
+} OpenABE_PAYLOAD_MODE;
+
+// bytes of AES-CTR keystream applied per call when masking the payload
+#define OpenABE_PAYLOAD_CHUNK_SIZE  (1 << 20)
+
+///
+/// @class  OpenABEStreamEncryptor
+///
+/// @brief  One streaming encryption started by
+///         OpenABEContextSchemeCPA::encryptInit. It owns the AES-GCM state,
+///         so a context can run any number of streams at once; each stream
+///         is used by one thread at a time.
+///
+
+class OpenABEStreamEncryptor {
+public:
+  OpenABE_ERROR update(OpenABEByteString& plaintextBlock, OpenABEByteString& ciphertextBlock);
+  OpenABE_ERROR finalize(OpenABEByteString& tag);
+
+private:
+  friend class OpenABEContextSchemeCPA;
+  explicit OpenABEStreamEncryptor(std::unique_ptr<OpenABESymKeyAuthEncStream> stream)
+    : m_Stream(std::move(stream)) {}
+
+  std::unique_ptr<OpenABESymKeyAuthEncStream> m_Stream;
+};
+
+///
+/// @class  OpenABEStreamDecryptor
+///
+/// @brief  One streaming decryption started by
+///         OpenABEContextSchemeCPA::decryptInit (see OpenABEStreamEncryptor).
+///         Plaintext blocks must not be trusted until finalize succeeds.
+///
+
+class OpenABEStreamDecryptor {
+public:
+  OpenABE_ERROR update(OpenABEByteString& ciphertextBlock, OpenABEByteString& plaintextBlock);
+  OpenABE_ERROR finalize(OpenABEByteString& tag);
+
+private:
+  friend class OpenABEContextSchemeCPA;
+  explicit OpenABEStreamDecryptor(std::unique_ptr<OpenABESymKeyAuthEncStream> stream)
+    : m_Stream(std::move(stream)) {}
+
+  std::unique_ptr<OpenABESymKeyAuthEncStream> m_Stream;
+};
+
 ///
 /// @class  OpenABEContextScheme
 ///
@@ -77,7 +226,12 @@ public:
 class OpenABEContextSchemeCPA : public ZObject {
 private:
   OpenABE_ERROR loadKey(const std::string &ID, OpenABEByteString &keyBlob, zKeyType keyType);
+  OpenABE_ERROR encryptPayload(std::shared_ptr<OpenABESymKey>& K, OpenABEByteString& plaintext,
+                           OpenABECiphertext& ciphertext);
+  OpenABE_ERROR maskPayload(OpenABE_PAYLOAD_MODE mode, OpenABEByteString& key,
+                            OpenABEByteString& input, OpenABEByteString& output);
   bool isMAABE;
+  OpenABE_PAYLOAD_MODE m_PayloadMode;
 
 protected:
   std::unique_ptr<OpenABEContextABE> m_KEM_;
@@ -88,6 +242,18 @@ public:
 
   void setSchemeType(OpenABE_SCHEME scheme_type) { this->m_KEM_->setSchemeType(scheme_type); }
   OpenABE_SCHEME getSchemeType() { return this->m_KEM_->getSchemeType(); }
+  void setDecryptionThreads(unsigned int numThreads) { this->m_KEM_->setDecryptionThreads(numThreads); }
+  // payload mask used by encrypt (decrypt follows the ciphertext)
+  void setPayloadMode(OpenABE_PAYLOAD_MODE mode) { this->m_PayloadMode = mode; }
+  OpenABE_PAYLOAD_MODE getPayloadMode() const { return this->m_PayloadMode; }
+  OpenABE_ERROR enablePrecomputation(const std::string &mpkID,
+                               const OpenABEPrecomputeSettings &settings = OpenABEPrecomputeSettings()) {
+    return this->m_KEM_->enablePrecomputation(mpkID, settings);
+  }
+  OpenABE_ERROR disablePrecomputation(const std::string &mpkID) { return this->m_KEM_->disablePrecomputation(mpkID); }
+  std::shared_ptr<OpenABEPrecomputePool> getPrecomputePool(const std::string &mpkID) {
+    return this->m_KEM_->getPrecomputePool(mpkID);
+  }
 
   OpenABEByteString* getHashKey(const std::string &mpkID);
   OpenABE_ERROR exportKey(const std::string &keyID, OpenABEByteString &keyBlob);
@@ -106,10 +272,27 @@ public:
 
   OpenABE_ERROR keygen(OpenABEFunctionInput* keyInput, const std::string &keyID, const std::string &mpkID,
                    const std::string &mskID, const std::string &gpkID="", const std::string &GID="");
+  OpenABE_ERROR keygenBatch(const std::vector<OpenABEFunctionInput*>& keyInputs,
+                    const std::vector<std::string>& keyIDs, const std::string &mpkID,
+                    const std::string &mskID, std::vector<OpenABEByteString>& keyBlobs,
+                    unsigned int numThreads = 0);
   OpenABE_ERROR encrypt(const std::string &mpkID, const OpenABEFunctionInput* encryptInput,
                     OpenABEByteString& plaintext, OpenABECiphertext& ciphertext);
+  OpenABE_ERROR encryptBatch(const std::string &mpkID, const OpenABEFunctionInput* encryptInput,
+                    std::vector<OpenABEByteString>& plaintexts,
+                    std::vector<std::unique_ptr<OpenABECiphertext>>& ciphertexts,
+                    unsigned int numThreads = 0);
   OpenABE_ERROR decrypt(const std::string &mpkID, const std::string &keyID,
                     OpenABEByteString& plaintext, OpenABECiphertext& ciphertext);
+
+  // Streaming hybrid encryption for large payloads: the ciphertext holds
+  // the KEM components and the IV (authenticated as AAD), the payload is
+  // encrypted with AES-GCM block by block through the returned stream and
+  // the tag is returned by its finalize.
+  OpenABE_ERROR encryptInit(const std::string &mpkID, const OpenABEFunctionInput* encryptInput,
+                    OpenABECiphertext& ciphertext, std::unique_ptr<OpenABEStreamEncryptor>& encryptor);
+  OpenABE_ERROR decryptInit(const std::string &mpkID, const std::string &keyID,
+                    OpenABECiphertext& ciphertext, std::unique_ptr<OpenABEStreamDecryptor>& decryptor);
 };
 
 
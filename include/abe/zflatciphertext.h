@@ -0,0 +1,127 @@
+/// 
+/// Copyright (c) 2018 Zeutro, LLC. All rights reserved.
+/// 
+/// This file is part of Zeutro's OpenABE.
+/// 
+/// OpenABE is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU Affero General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+/// 
+/// OpenABE is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU Affero General Public License for more details.
+/// 
+/// You should have received a copy of the GNU Affero General Public
+/// License along with OpenABE. If not, see <http://www.gnu.org/licenses/>.
+/// 
+/// You can be released from the requirements of the GNU Affero General
+/// Public License and obtain additional features by purchasing a
+/// commercial license. Buying such a license is mandatory if you
+/// engage in commercial activities involving OpenABE that do not
+/// comply with the open source requirements of the GNU Affero General
+/// Public License. For more information on commerical licenses,
+/// visit <http://www.zeutro.com>.
+///
+/// \file   zflatciphertext.h
+///
+/// \brief  Versioned flat binary layout for ciphertexts and a
+///         zero-copy reader that decodes elements on access.
+///
+
+#ifndef __ZFLATCIPHERTEXT_H__
+#define __ZFLATCIPHERTEXT_H__
+
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "zcontainer.h"
+
+// Flat layout (all integers big-endian, offsets from the start of the blob):
+//
+//   header     magic "OABF" | format version | library version |
+//              algorithm ID | reserved | uid (UID_LEN bytes) | component count (4)
+//   table      one entry per component, sorted by name:
+//              type (1) | reserved (1) | name length (2) |
+//              name offset (4) | data offset (4) | data length (4)
+//   names      component names, back to back
+//   data       element slots: raw point/scalar bytes for ZP, G1, G2 and GT
+//              (fixed width for a given curve and compression setting) and
+//              the tagged serialization for every other type
+#define OpenABE_FLAT_CT_MAGIC          "OABF"
+#define OpenABE_FLAT_CT_MAGIC_LEN      4
+#define OpenABE_FLAT_CT_VERSION        1
+#define OpenABE_FLAT_CT_HEADER_LEN     (OpenABE_FLAT_CT_MAGIC_LEN + 4 + UID_LEN + 4)
+#define OpenABE_FLAT_CT_ENTRY_LEN      16
+
+/// \class  OpenABEFlatCiphertextReader
+/// \brief  Non-owning view over a flat ciphertext. The constructor only
+///         validates the header and the component table; elements are
+///         decoded when they are requested. The underlying buffer must
+///         outlive the reader.
+class OpenABEFlatCiphertextReader {
+public:
+  explicit OpenABEFlatCiphertextReader(std::span<const uint8_t> input);
+
+  static bool isFlatFormat(std::span<const uint8_t> input);
+
+  uint8_t getFormatVersion() const { return this->m_Input[OpenABE_FLAT_CT_MAGIC_LEN]; }
+  uint8_t getLibraryVersion() const { return this->m_Input[OpenABE_FLAT_CT_MAGIC_LEN + 1]; }
+  uint8_t getAlgorithmID() const { return this->m_Input[OpenABE_FLAT_CT_MAGIC_LEN + 2]; }
+  std::span<const uint8_t> getUID() const {
+    return this->m_Input.subspan(OpenABE_FLAT_CT_MAGIC_LEN + 4, UID_LEN);
+  }
+
+  size_t numComponents() const { return this->m_Count; }
+  std::string_view getName(size_t i) const;
+  uint8_t getType(size_t i) const;
+  std::span<const uint8_t> getData(size_t i) const;
+
+  bool hasComponent(std::string_view name) const;
+  std::span<const uint8_t> getRawComponent(std::string_view name, uint8_t *type = nullptr) const;
+
+  ZP getZP(std::string_view name, const bignum_t order) const;
+  G1 getG1(std::string_view name) const;
+  G2 getG2(std::string_view name) const;
+  GT getGT(std::string_view name) const;
+
+private:
+  std::span<const uint8_t> m_Input;
+  size_t m_Count;
+
+  const uint8_t *entry(size_t i) const {
+    return this->m_Input.data() + OpenABE_FLAT_CT_HEADER_LEN + i * OpenABE_FLAT_CT_ENTRY_LEN;
+  }
+  size_t find(std::string_view name) const;
+};
+
+/// \class  OpenABEFlatElement
+/// \brief  Component of a loaded flat ciphertext that has not been decoded
+///         yet. It points at its slot in the copy of the blob shared by all
+///         components, and group elements are decoded from the slot on
+///         first access without an intermediate serialized form.
+class OpenABEFlatElement : public OpenABELazyElement {
+public:
+  OpenABEFlatElement(uint8_t type, std::span<const uint8_t> data,
+                     std::shared_ptr<const OpenABEByteString> buffer)
+    : OpenABELazyElement(), m_Type(type), m_Data(data), m_Buffer(buffer) {}
+
+  OpenABEFlatElement* clone() const { return new OpenABEFlatElement(*this); }
+  void serialize(OpenABEByteString &result) const;
+  ZObject* decodeInPlace(const BPGroup *group) const;
+
+private:
+  uint8_t m_Type;
+  std::span<const uint8_t> m_Data;
+  std::shared_ptr<const OpenABEByteString> m_Buffer;
+};
+
+void OpenABE_exportFlatContainer(uint8_t libraryVersion, uint8_t algorithmID,
+                                 const OpenABEByteString &uid,
+                                 const std::map<std::string, ZObject*> &components,
+                                 OpenABEByteString &output);
+
+#endif	// __ZFLATCIPHERTEXT_H__
@@ -35,6 +35,7 @@
 #define __ZKEY_H__
 
 #include <map>
+#include <mutex>
 
 #include "zabe.h"
 #include "zcontainer.h"
@@ -43,6 +44,26 @@
 /// \class	OpenABEKey
 /// \brief	Abstract base class class for keys and parameters
 
+/// Fixed-base tables built lazily from the group elements of a key. The
+/// tables are tied to the elements they were built from, so a copied key
+/// starts with an empty cache.
+class OpenABEFixedBaseCache {
+public:
+  OpenABEFixedBaseCache() {}
+  OpenABEFixedBaseCache(const OpenABEFixedBaseCache&) {}
+  OpenABEFixedBaseCache& operator=(const OpenABEFixedBaseCache&) { this->clear(); return *this; }
+
+  void clear() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->g1Tables.clear();
+    this->g2Tables.clear();
+  }
+
+  std::mutex lock;
+  std::map<std::string, std::shared_ptr<G1FixedBase>> g1Tables;
+  std::map<std::string, std::shared_ptr<G2FixedBase>> g2Tables;
+};
+
 class OpenABEKey : public OpenABEContainer {
 protected:
   // 32-bytes for representing OpenABEKey Header information as follows:
@@ -60,6 +81,8 @@ protected:
   OpenABEKeyType key_type;
   // key is a public or private key
   bool isPrivate;
+  // precomputed tables for the fixed bases of this key
+  OpenABEFixedBaseCache fixedBase;
 
 public:
   OpenABEKey();
@@ -74,6 +97,11 @@ public:
   std::string getID() { return this->ID; }
   OpenABEKeyType getKeyType() { return this->key_type; }
 
+  std::shared_ptr<G1FixedBase> getG1FixedBase(const std::string &name);
+  std::shared_ptr<G2FixedBase> getG2FixedBase(const std::string &name);
+  void clearFixedBase() { this->fixedBase.clear(); }
+  void precomputeGTFixedBase();
+
   virtual OpenABE_ERROR exportKeyToBytes(OpenABEByteString &output) const;
   virtual OpenABE_ERROR loadKeyFromBytes(OpenABEByteString &input);
 
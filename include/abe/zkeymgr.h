@@ -37,12 +37,16 @@
 #if 1
 
 #include <map>
+#include <set>
+#include <unordered_map>
 #include <vector>
 #include <mutex>
 
 #include "lsss/zfunctioninput.h"
 #include "zkeystore.h"
 
+class OpenABETreeNode;
+
 struct _OpenABEMetadata {
     /* add as many fields as necessary */
     std::string userId;
@@ -54,6 +58,11 @@ struct _OpenABEMetadata {
     OpenABE_SCHEME schemeID;
     OpenABEByteString keyBlob;
     uint64_t keyExpirationDate;
+    /* search summary: the attributes of an attribute list key, or the
+     * clauses of a policy key (see getPolicyClauses) */
+    std::set<std::string> attributes;
+    std::vector<std::set<std::string>> clauses;
+    std::string signature;
 };
 
 #define MAX_KEYS_PER_USER  20
@@ -67,6 +76,23 @@ struct OpenABEKeyQuery {
      * advanced --> find key for subset of ciphertexts */
 };
 
+// Summary of a policy as a list of attribute sets: an attribute list can
+// only satisfy the policy if it holds at least one attribute of every set.
+typedef std::vector<std::set<std::string>> OpenABEPolicyClauses;
+OpenABEPolicyClauses getPolicyClauses(OpenABETreeNode *node);
+
+/// \struct OpenABEKeyIndex
+/// \brief  Inverted index over the keys of one user, so that a search
+///         only tests keys that can possibly match the ciphertext.
+struct OpenABEKeyIndex {
+    // attribute -> attribute list keys that hold it
+    std::unordered_map<std::string, std::set<std::string>> attrKeys;
+    // attribute -> policy keys whose smallest clause contains it
+    std::unordered_map<std::string, std::set<std::string>> policyKeys;
+    // policy keys without clauses (always tested)
+    std::set<std::string> unindexedPolicyKeys;
+};
+
 /// \class  ZKeystoreManager
 /// \brief  Keystore Manager class for OpenABEKeys. Stores keys and metadata
 ///         about the key
@@ -102,7 +128,12 @@ protected:
     std::pair<bool,int> testAKey(OpenABEMetadata& key, OpenABEFunctionInput* funcInput);
     std::mutex ks_lock_;
     const std::string searchKey(OpenABEKeyQuery* query, OpenABEFunctionInput *funcInput);
+    std::vector<std::string> findCandidateKeys(const std::string& userId, OpenABEFunctionInput *funcInput);
+    void addKeyMetadata(const std::string& keyID, OpenABEMetadata metadata);
+    void removeKeyMetadata(const std::string& keyID);
     std::map<std::string, OpenABEMetadata> keyMetadata_;
+    std::map<std::string, OpenABEKeyIndex> keyIndex_;
+    std::unordered_map<std::string, std::string> keySignatures_;
     std::map<std::string, unsigned int> keyCounter_;
     std::map<std::string, std::string> keyPassphrase_, activeUsers_;
     std::map<std::string, bool> keyLoaded_;
@@ -34,7 +34,10 @@
 #ifndef __ZKEYSTORE_H__
 #define __ZKEYSTORE_H__
 
+#include <array>
 #include <map>
+#include <shared_mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "zabe.h"
@@ -47,9 +50,15 @@ typedef enum _zKeyType {
   KEY_TYPE_SECRET
 } zKeyType;
 
+// number of independently locked shards of a keystore
+#define OpenABE_KEYSTORE_SHARDS   16
+
 /// \class  ZKeystore
 /// \brief  Keystore class for the OpenABE. Stores public and secret parameters
-///         and keys, each indexed by a string identifier.
+///         and keys, each indexed by a string identifier. The keystore is
+///         safe to use from several threads: keys are hashed into shards,
+///         each guarded by a reader-writer lock, so lookups only take a
+///         shared lock and never wait on each other.
 //
 class OpenABEKeystore : public ZObject {
 public:
@@ -81,8 +90,20 @@ public:
   OpenABE_ERROR exportKeyToBytes(const std::string keyID, OpenABEByteString &exportedKey);
 
 protected:
-  std::map<std::string, std::shared_ptr<OpenABEKey>> pubKeys;
-  std::map<std::string, std::shared_ptr<OpenABEKey>> secKeys;
+  typedef std::unordered_map<std::string, std::shared_ptr<OpenABEKey>> OpenABEKeyMap;
+
+  // one cache line per shard so that readers of different shards do not
+  // share the lock word
+  struct alignas(64) Shard {
+    mutable std::shared_mutex lock;
+    OpenABEKeyMap pubKeys;
+    OpenABEKeyMap secKeys;
+  };
+  std::array<Shard, OpenABE_KEYSTORE_SHARDS> shards;
+
+  Shard& getShard(const std::string &keyID) {
+    return this->shards[std::hash<std::string>{}(keyID) % OpenABE_KEYSTORE_SHARDS];
+  }
 };
 
 typedef std::pair<std::string,int> KeyRef;
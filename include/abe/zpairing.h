@@ -34,8 +34,16 @@
 #ifndef __ZPAIRING_H__
 #define __ZPAIRING_H__
 
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
 #include "zabe.h"
 
+// default memory budget (in bytes) of the hash_to_G1 point cache
+#define DEFAULT_HASH_TO_G1_CACHE_BYTES  (8 * 1024 * 1024)
+
 /// \class	OpenABEPairing
 /// \brief	Generic container for pairing functionality.
 
@@ -53,6 +61,7 @@ public:
   GT       initGT() { return GT(); }
 
   ZP       randomZP();
+  std::vector<ZP> randomZPs(size_t count);
   G1       randomG1();
   G2       randomG2();
 
@@ -72,6 +81,50 @@ protected:
   std::shared_ptr<BPGroup>  bpgroup;
 };
 
+/// \struct  OpenABECacheStats
+/// \brief   Snapshot of the counters of a cache.
+
+struct OpenABECacheStats {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+  size_t   entries;
+  size_t   bytes;
+  size_t   maxBytes;
+};
+
+/// \class  OpenABEHashToG1Cache
+/// \brief  Process-wide, thread-safe LRU cache of hash_to_G1 results keyed
+///         by (hash key prefix, attribute). Its memory use is bounded by a
+///         byte budget; a budget of zero disables caching.
+
+class OpenABEHashToG1Cache {
+public:
+  static OpenABEHashToG1Cache& getInstance();
+
+  bool lookup(const std::string &key, G1 &point);
+  void insert(const std::string &key, const G1 &point);
+
+  void setMaxBytes(size_t maxBytes);
+  OpenABECacheStats getStats();
+  void resetStats();
+  void clear();
+
+private:
+  OpenABEHashToG1Cache();
+  void evict();
+  static size_t entrySize(const std::string &key);
+
+  typedef std::pair<std::string, G1> Entry;
+
+  std::mutex m_Lock;
+  size_t m_MaxBytes, m_Bytes;
+  std::atomic<uint64_t> m_Hits, m_Misses, m_Evictions;
+  // most recently used first
+  std::list<Entry> m_Entries;
+  std::unordered_map<std::string, std::list<Entry>::iterator> m_Index;
+};
+
 // Global library initialization and shutdown functions
 OpenABE_ERROR zMathInitLibrary();
 OpenABE_ERROR zMathShutdownLibrary();
@@ -0,0 +1,171 @@
+/// 
+/// Copyright (c) 2018 Zeutro, LLC. All rights reserved.
+/// 
+/// This file is part of Zeutro's OpenABE.
+/// 
+/// OpenABE is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU Affero General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+/// 
+/// OpenABE is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU Affero General Public License for more details.
+/// 
+/// You should have received a copy of the GNU Affero General Public
+/// License along with OpenABE. If not, see <http://www.gnu.org/licenses/>.
+/// 
+/// You can be released from the requirements of the GNU Affero General
+/// Public License and obtain additional features by purchasing a
+/// commercial license. Buying such a license is mandatory if you
+/// engage in commercial activities involving OpenABE that do not
+/// comply with the open source requirements of the GNU Affero General
+/// Public License. For more information on commerical licenses,
+/// visit <http://www.zeutro.com>.
+///
+/// \file   zprecompute.h
+///
+/// \brief  Class definition for the pool of precomputed encryption
+///         randomness used by online/offline encryption.
+///
+
+#ifndef __ZPRECOMPUTE_H__
+#define __ZPRECOMPUTE_H__
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// default pool sizes (see OpenABEPrecomputeSettings)
+#define DEFAULT_PRECOMPUTE_SESSIONS        32
+#define DEFAULT_PRECOMPUTE_SHARES          512
+#define DEFAULT_PRECOMPUTE_PER_ATTRIBUTE   16
+#define DEFAULT_PRECOMPUTE_MAX_ATTRIBUTES  1024
+#define DEFAULT_PRECOMPUTE_REFILL_BATCH    8
+
+/// \struct  OpenABEPrecomputeSettings
+/// \brief   Depth and refill rate of an OpenABEPrecomputePool.
+
+struct OpenABEPrecomputeSettings {
+  // session tuples (s, A^s, g1^s) kept ready
+  size_t sessionDepth = DEFAULT_PRECOMPUTE_SESSIONS;
+  // share tuples (l, g1a^l) kept ready
+  size_t shareDepth = DEFAULT_PRECOMPUTE_SHARES;
+  // attribute tuples (r, g2^r, H(attr)^-r) kept ready per known attribute
+  size_t attributeDepth = DEFAULT_PRECOMPUTE_PER_ATTRIBUTE;
+  // number of attributes the pool keeps tuples for
+  size_t maxAttributes = DEFAULT_PRECOMPUTE_MAX_ATTRIBUTES;
+  // tuples computed per round of the background thread
+  size_t refillBatch = DEFAULT_PRECOMPUTE_REFILL_BATCH;
+  // upper bound on tuples computed per second (0 for no limit)
+  double maxRefillRate = 0;
+};
+
+/// \struct  OpenABEPrecomputeStats
+/// \brief   Snapshot of the counters and fill level of a pool.
+
+struct OpenABEPrecomputeStats {
+  uint64_t sessionHits;
+  uint64_t sessionMisses;
+  uint64_t shareHits;
+  uint64_t shareMisses;
+  uint64_t attributeHits;
+  uint64_t attributeMisses;
+  uint64_t produced;
+  size_t   sessions;
+  size_t   shares;
+  size_t   attributes;
+  size_t   attributeTuples;
+};
+
+/// \struct  OpenABEPrecomputedSession
+/// \brief   Policy-independent part of a ciphertext: s, A^s and g1^s.
+
+struct OpenABEPrecomputedSession {
+  ZP s;
+  GT C;
+  G1 Cprime;
+};
+
+/// \struct  OpenABEPrecomputedShare
+/// \brief   A random l with g1a^l; the ciphertext carries share - l.
+
+struct OpenABEPrecomputedShare {
+  ZP lambda;
+  G1 g1aLambda;
+};
+
+/// \struct  OpenABEPrecomputedAttribute
+/// \brief   Row randomness for a known attribute: r, g2^r and H(attr)^-r.
+
+struct OpenABEPrecomputedAttribute {
+  ZP r;
+  G2 D;
+  G1 hashNeg;
+};
+
+/// \class  OpenABEPrecomputePool
+/// \brief  Bounded pool of precomputed encryption randomness for one
+///         master public key, in the style of Hohenberger-Waters
+///         online/offline ABE. A background thread keeps the pool filled;
+///         an encryption takes tuples from it and falls back to computing
+///         them itself when the pool is empty (a miss). Attributes are
+///         learned from the encryptions that miss them.
+
+class OpenABEPrecomputePool {
+public:
+  OpenABEPrecomputePool(const GT &A, const std::shared_ptr<G1FixedBase> &g1,
+                        const std::shared_ptr<G1FixedBase> &g1a,
+                        const std::shared_ptr<G2FixedBase> &g2,
+                        bignum_t order,
+                        const OpenABEPrecomputeSettings &settings);
+  ~OpenABEPrecomputePool();
+
+  OpenABEPrecomputePool(const OpenABEPrecomputePool&) = delete;
+  OpenABEPrecomputePool& operator=(const OpenABEPrecomputePool&) = delete;
+
+  void start();
+  void stop();
+  size_t refill(size_t maxTuples);
+
+  bool takeSession(OpenABEPrecomputedSession &session);
+  bool takeShare(OpenABEPrecomputedShare &share);
+  bool takeAttribute(const std::string &label, OpenABEPrecomputedAttribute &tuple);
+  void addAttribute(const std::string &label, const G1 &hashedPoint);
+
+  OpenABEPrecomputeStats getStats();
+  void resetStats();
+
+private:
+  struct AttributeSlot {
+    G1 hashedPoint;
+    std::deque<OpenABEPrecomputedAttribute> tuples;
+  };
+
+  bool needsRefill();
+  void refillLoop();
+  ZP randomZP();
+
+  GT A;
+  std::shared_ptr<G1FixedBase> g1, g1a;
+  std::shared_ptr<G2FixedBase> g2;
+  ZP order;
+  OpenABEPrecomputeSettings settings;
+
+  std::mutex lock;
+  std::condition_variable wake;
+  std::thread worker;
+  bool stopping;
+  std::deque<OpenABEPrecomputedSession> sessions;
+  std::deque<OpenABEPrecomputedShare> shares;
+  std::unordered_map<std::string, AttributeSlot> attributes;
+  OpenABEPrecomputeStats stats;
+};
+
+#endif /* ifdef __ZPRECOMPUTE_H__ */
@@ -99,6 +99,8 @@ public:
   OpenABE_ERROR decrypt(OpenABEByteString& plaintext, const OpenABEByteString& ciphertext);
   std::string encrypt(const std::string& plaintext);
   std::string decrypt(const std::string& ciphertext);
+  OpenABE_ERROR decryptSegment(OpenABEByteString& plaintext,
+                               const OpenABEByteString& ciphertext, size_t index);
 
 private:
   bool b64_encode_;
@@ -108,6 +110,9 @@ private:
 
   // Pointers to different encryption handlers
   std::unique_ptr<OpenABESymKeyAuthEnc> gcm_handler_;
+  std::unique_ptr<OpenABESymKeySegmentedAuthEnc> stream_handler_;
+
+  OpenABEByteString getAuthData(const OpenABEByteString& aad);
 };
 
 OpenABE_SCHEME SchemeFromEncryptionMode(EncryptionMode mode);
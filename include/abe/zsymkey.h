@@ -35,6 +35,8 @@
 #ifndef __ZSYMKEY_H__
 #define __ZSYMKEY_H__
 
+#include <span>
+
 #include <openssl/aes.h>
 #include <openssl/rand.h>
 #include <openssl/bio.h>
@@ -51,6 +53,14 @@
 #define CT_STR	"Ciphertext"
 #define TG_STR	"Tag"
 
+// STREAM segmentation: plaintext is cut into segments of this many bytes
+// and each segment is sealed with its own AES-GCM nonce
+#define OpenABE_STREAM_SEGMENT_SIZE   65536
+#define OpenABE_STREAM_MAX_SEGMENT    (1 << 24)
+#define OpenABE_STREAM_PREFIX_LEN     7
+#define OpenABE_STREAM_NONCE_LEN      12
+#define OpenABE_STREAM_HEADER_LEN     (OpenABE_STREAM_PREFIX_LEN + 4)
+
 ///
 /// @class  OpenABESymKey
 ///
@@ -143,6 +153,52 @@ public:
   OpenABE_ERROR   decryptInit(OpenABEByteString& iv, OpenABEByteString& tag);
   OpenABE_ERROR   decryptUpdate(OpenABEByteString& ciphertextBlock, OpenABEByteString& plaintext);
   OpenABE_ERROR   decryptFinalize(OpenABEByteString& plaintext);
+  OpenABE_ERROR   decryptFinalize(OpenABEByteString& plaintext, OpenABEByteString& tag);
+};
+
+
+///
+/// @class  OpenABESymKeySegmentedAuthEnc
+///
+/// @brief  Segmented AES-GCM following the STREAM construction (nonce-based
+///         OAE2). Segment i is sealed under the nonce
+///         prefix || i (32-bit big-endian) || last-segment flag, so segments
+///         can be encrypted and decrypted independently (in parallel or by
+///         random access) while reordering, dropping or truncating segments
+///         is still detected.
+///
+
+class OpenABESymKeySegmentedAuthEnc : ZObject {
+private:
+  EVP_CIPHER *cipher;
+  OpenABEByteString key;
+  OpenABEByteString aad;
+  uint32_t segment_size;
+
+  void makeNonce(uint8_t *nonce, const OpenABEByteString& header,
+                 uint32_t index, bool last) const;
+  void encryptSegment(uint8_t *ct, const uint8_t *pt, size_t pt_len,
+                      const OpenABEByteString& header, uint32_t index, bool last) const;
+  bool decryptSegment(uint8_t *pt, const uint8_t *ct, size_t ct_len,
+                      const OpenABEByteString& header, uint32_t index, bool last) const;
+
+public:
+  OpenABESymKeySegmentedAuthEnc(int securitylevel, OpenABEByteString& zkey,
+                                uint32_t segmentSize = OpenABE_STREAM_SEGMENT_SIZE);
+  ~OpenABESymKeySegmentedAuthEnc();
+
+  void setAddAuthData(OpenABEByteString &aad);
+  uint32_t getSegmentSize() const { return this->segment_size; }
+
+  OpenABE_ERROR encrypt(const OpenABEByteString& plaintext, OpenABEByteString& header,
+                        OpenABEByteString& ciphertext, unsigned int numThreads = 0);
+  bool decrypt(OpenABEByteString& plaintext, const OpenABEByteString& header,
+               const OpenABEByteString& ciphertext, unsigned int numThreads = 0);
+  bool decryptSegment(OpenABEByteString& plaintext, const OpenABEByteString& header,
+                      std::span<const uint8_t> segment, uint32_t index, bool last);
+
+  static bool parseHeader(const OpenABEByteString& header, uint32_t& segmentSize);
+  static size_t getSegmentCount(size_t ciphertextLen, uint32_t segmentSize);
 };
 
 
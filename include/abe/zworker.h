@@ -0,0 +1,101 @@
+/// 
+/// Copyright (c) 2018 Zeutro, LLC. All rights reserved.
+/// 
+/// This file is part of Zeutro's OpenABE.
+/// 
+/// OpenABE is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU Affero General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+/// 
+/// OpenABE is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU Affero General Public License for more details.
+/// 
+/// You should have received a copy of the GNU Affero General Public
+/// License along with OpenABE. If not, see <http://www.gnu.org/licenses/>.
+/// 
+/// You can be released from the requirements of the GNU Affero General
+/// Public License and obtain additional features by purchasing a
+/// commercial license. Buying such a license is mandatory if you
+/// engage in commercial activities involving OpenABE that do not
+/// comply with the open source requirements of the GNU Affero General
+/// Public License. For more information on commerical licenses,
+/// visit <http://www.zeutro.com>.
+///
+///
+/// \file   zworker.h
+///
+/// \brief  Helpers for running OpenABE operations on several threads.
+///
+
+#ifndef __ZWORKER_H__
+#define __ZWORKER_H__
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <relic/relic.h>
+
+// RELIC keeps its state in a per-thread context only when it is built with
+// MULTI=PTHREAD; otherwise every OpenABE call must stay on a single thread.
+#if defined(MULTI) && defined(PTHREAD) && (MULTI == PTHREAD)
+#define OpenABE_THREADS_SUPPORTED 1
+#else
+#define OpenABE_THREADS_SUPPORTED 0
+#endif
+
+// Every thread that uses OpenABE needs its own RELIC context. It is set up
+// on first use (by AssertLibInit and the keygen, encrypt and decrypt entry
+// points of the ABE contexts) and released when the thread exits; the
+// functions below only make that explicit. They are no-ops for the thread
+// that called InitializeOpenABE and when threads are not supported.
+bool OpenABE_initializeThreadContext();
+void OpenABE_shutdownThreadContext();
+void OpenABE_setMainThreadContext(bool ready);
+bool OpenABE_isThreadSafe();
+
+unsigned int OpenABE_getWorkerCount(unsigned int requested, size_t numTasks);
+void OpenABE_parallelFor(size_t numTasks, unsigned int numThreads,
+                         const std::function<void(size_t)> &task);
+
+/// \class  OpenABEWorkerPool
+/// \brief  Process-wide pool of worker threads used by OpenABE_parallelFor.
+///         Workers are started on demand and keep their RELIC context
+///         between jobs, so a parallel decryption does not pay for thread
+///         creation and curve setup. One job runs at a time; callers that
+///         find the pool busy fall back to temporary threads.
+class OpenABEWorkerPool {
+public:
+  static OpenABEWorkerPool& getInstance();
+
+  bool tryRun(unsigned int numWorkers, const std::function<void()> &job);
+  void shutdown();
+  size_t size();
+
+  OpenABEWorkerPool(const OpenABEWorkerPool&) = delete;
+  OpenABEWorkerPool& operator=(const OpenABEWorkerPool&) = delete;
+
+private:
+  OpenABEWorkerPool() {}
+  ~OpenABEWorkerPool() { this->shutdown(); }
+
+  void workerLoop();
+
+  std::mutex runLock;
+  std::mutex lock;
+  std::condition_variable wake, done;
+  std::vector<std::thread> threads;
+  const std::function<void()> *job = nullptr;
+  uint64_t generation = 0;
+  unsigned int wanted = 0, taken = 0, active = 0;
+  bool stopping = false;
+};
+
+#endif /* ifdef __ZWORKER_H__ */
@@ -8,6 +8,7 @@
 #include "abe/zkey.h"
 #include "abe/zkeystore.h"
 #include "abe/zpairing.h"
+#include "abe/zprecompute.h"
 #include "abe/zsymcrypto.h"
 #include "abe/zsymkey.h"
 #include "abe/zcontextabe.h"
@@ -16,6 +17,8 @@
 #include "abe/zcontextpke.h"
 #include "abe/zcontextpksig.h"
 #include "abe/zkeymgr.h"
+#include "abe/zworker.h"
+#include "abe/zcompiledpolicy.h"
 
 ///
 /// Utility functions
@@ -64,29 +67,37 @@ OpenABE_SCHEME OpenABE_getSchemeID(uint8_t id);
 ///
 /// OpenABE initialization per thread
 ///
+/// Concurrency model: when RELIC is built with MULTI=PTHREAD
+/// (OpenABE_isThreadSafe() returns true), every thread gets its own RELIC
+/// context, set up on first use and released when the thread exits.
+/// Separate scheme contexts may then run keygen, encrypt and decrypt in
+/// parallel on different threads. The keygen, encrypt and decrypt entry
+/// points of the ABE contexts set up the RELIC context of the calling
+/// thread, and the keystore and the process-wide caches are synchronized,
+/// so one context may also be shared for encryption and decryption with
+/// keys that are already loaded, including from threads other than the
+/// one that created it. set_compression_flag() is process-wide and should
+/// be called before starting threads.
+///
 class OpenABEStateContext {
 public:
   /*! \brief Initialize OpenABE per thread
    *
-   * The following function needs to be called exactly once at the
-   * beginning of any OpenABE-using thread except for the thread that
-   * calls OpenABE_initialize.  This must be done in a thread before any
-   * OpenABE functionality is invoked in that thread, otherwise, your
-   * program may crash arbitrarily.
+   * Sets up the RELIC context of the calling thread. Contexts are also
+   * created automatically on first use, so this is only needed to pay
+   * the setup cost up front or to control when the context is released.
    */
   void initializeThread();
 
   /*! \brief Shutdown OpenABE per thread
    *
-   * The following function needs to be called exactly once at the
-   * end of any OpenABE-using thread except for the thread that calls
-   * OpenABE_shutdown.  This should be done before the destruction of
-   * the thread. If you forget to call this function, it is invoked
-   * in the destructor of the OpenABE state context.
+   * Releases the RELIC context created by initializeThread(). It is
+   * invoked by the destructor of the OpenABE state context, and does
+   * nothing for the thread that called InitializeOpenABE.
    */
   void shutdownThread();
 
-  OpenABEStateContext() : isInitialized_(false) {
+  OpenABEStateContext() : isInitialized_(false), ownsContext_(false) {
     // initializeThread() on constructor initialization
     initializeThread();
     isInitialized_ = true;
@@ -101,6 +112,8 @@ public:
 
 private:
   bool isInitialized_;
+  // whether initializeThread() created the RELIC context of this thread
+  bool ownsContext_;
 };
 
 void getRandomBytes(uint8_t *buf, size_t buf_len);
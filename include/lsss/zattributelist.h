@@ -39,9 +39,37 @@
 #define WHITESPACE   ' '
 #define ATTR_SEP     '|'
 
+#include <algorithm>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+
 #include "zfunctioninput.h"
 #include "zbytestring.h"
 
+///
+/// @class  OpenABEAttributeInterner
+///
+/// @brief  Process-wide map from attribute strings to dense integer IDs, so
+///         that matching a policy leaf against an attribute list is a bit
+///         test. IDs are never released; the table grows with the number
+///         of distinct attributes seen by the process.
+///
+class OpenABEAttributeInterner {
+public:
+  static OpenABEAttributeInterner& getInstance();
+
+  uint32_t intern(const std::string &attribute);
+  bool lookup(const std::string &attribute, uint32_t &id);
+  size_t size();
+
+private:
+  OpenABEAttributeInterner() {}
+
+  std::shared_mutex m_Lock;
+  std::unordered_map<std::string, uint32_t> m_Ids;
+};
+
 ///
 /// @class  OpenABEAttributeList
 ///
@@ -51,6 +79,9 @@ class OpenABEAttributeList : public OpenABEFunctionInput {
 protected:
   std::vector<std::string>     m_Attributes;
   std::vector<std::string>     m_OriginalAttributes;
+  // sorted interned IDs of m_Attributes (no duplicates)
+  std::vector<uint32_t>        m_AttributeIds;
+  void addAttributeId(const std::string &attribute);
 public:
   void setAttributes(std::vector<std::string>& attr_list,
                      std::vector<std::string>& orig_attr_list,
@@ -68,11 +99,18 @@ public:
   bool hasOrigAttributes() const { return (this->m_OriginalAttributes.size() > 0); }
   void syncOrigAttributes(const std::string& prefix, OpenABEAttributeList& attrList);
   bool matchAttribute(const std::string &attribute);
+  bool matchAttribute(uint32_t id) const {
+    return std::binary_search(this->m_AttributeIds.begin(),
+                              this->m_AttributeIds.end(), id);
+  }
   bool addAttribute(std::string attribute);
 
   friend std::ostream& operator<<(std::ostream&, const OpenABEAttributeList&);
   const std::vector<std::string>*	 getAttributeList() const { return &this->m_Attributes; }
   const std::vector<std::string>*  getOriginalAttributeList() const { return &this->m_OriginalAttributes; }
+  // sorted interned IDs of the attributes (two lists with the same
+  // attributes have the same IDs)
+  const std::vector<uint32_t>& getAttributeIds() const { return this->m_AttributeIds; }
   OpenABEAttributeList* clone() const { return new OpenABEAttributeList(*this); }
   std::string toString() const;
   std::string toCompactString() const;
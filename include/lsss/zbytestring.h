@@ -104,10 +104,18 @@ public:
   }
 
   OpenABEByteString& operator^=(OpenABEByteString &rhs) {
-    uint8_t *lhs_ptr = this->getInternalPtr();
-    uint8_t *rhs_ptr = rhs.getInternalPtr();
-    for(size_t i = 0; i < this->size(); i++) {
-      lhs_ptr[i] = this->at(i) ^ rhs_ptr[i % rhs.size()];
+    uint8_t *lhs_ptr = this->data();
+    const uint8_t *rhs_ptr = rhs.data();
+    size_t len = this->size();
+    if (rhs.size() >= len) {
+      // common case (a full-length mask): plain loop the compiler vectorizes
+      for(size_t i = 0; i < len; i++) {
+        lhs_ptr[i] ^= rhs_ptr[i];
+      }
+    } else {
+      for(size_t i = 0; i < len; i++) {
+        lhs_ptr[i] ^= rhs_ptr[i % rhs.size()];
+      }
     }
     return *this;
   }
@@ -267,10 +275,10 @@ public:
     }
   }
 
-  // bool isEqual(ZObject* z) const {
-  //   OpenABEByteString *z1 = dynamic_cast<OpenABEByteString*>(z);
-  //   return (z1 != NULL) && (*z1 == *this);
-  // }
+  bool isEqual(ZObject* z) const {
+    OpenABEByteString *z1 = dynamic_cast<OpenABEByteString*>(z);
+    return (z1 != NULL) && (*z1 == *this);
+  }
 
   void pack8bits(uint8_t byte) {
     this->push_back(byte);
@@ -36,6 +36,7 @@
 
 #include <list>
 #include <memory>
+#include <vector>
 
 extern "C" {
   #include "zelement.h"
@@ -54,6 +55,10 @@ void set_compression_flag(int value);
 #define GET_BP_GROUP(g)    g->group
 
 class ZP;
+class GTFixedBase;
+
+// window size (in bits) of the fixed-base GT exponentiation tables
+#define GT_FIXED_BASE_WINDOW  4
 
 /// \class  ECGroup
 /// \brief  Wrapper for managing elliptic curve groups
@@ -98,6 +103,9 @@ public:
 
   void setFrom(ZP&, uint32_t);
   bool ismember();
+  bool isZero() const;
+  bool isOne() const;
+  bool isMinusOne() const;
   void multInverse();
 
   friend ZP power(const ZP&, unsigned int);
@@ -148,6 +156,7 @@ public:
   uint8_t* hashToBytes(size_t *size) const;
 
   G1 operator*(const ZP k) const;
+  G1 operator-() const;
   G1 operator-(const G1 &x) const;
   G1 operator+(const G1 &x) const;
   bool operator==(const G1 &x) const;
@@ -159,6 +168,8 @@ public:
   bool isEqual(ZObject *z) const;
   G1* clone() const;
 
+  static G1 multiExp(const std::vector<G1> &points, const std::vector<ZP> &scalars);
+
   void serialize(OpenABEByteString &result) const;
   void deserialize(OpenABEByteString &input);
 };
@@ -188,6 +199,7 @@ public:
   uint8_t* getBytes(int *bufferSize) const;
 
   G2 operator*(const ZP k) const;
+  G2 operator-() const;
   G2 operator-(const G2 &x) const;
   G2 operator+(const G2 &x) const;
   bool operator==(const G2 &x) const;
@@ -199,6 +211,8 @@ public:
   bool isEqual(ZObject *z) const;
   G2* clone() const;
 
+  static G2 multiExp(const std::vector<G2> &points, const std::vector<ZP> &scalars);
+
   void serialize(OpenABEByteString &result) const;
   void deserialize(OpenABEByteString &input);
 };
@@ -209,6 +223,8 @@ class GT : public ZObject {
 public:
   gt_t m_GT;
   bool isInit;
+  // optional precomputed table used by exp() when this element is a fixed base
+  std::shared_ptr<GTFixedBase> m_FixedBase;
 
   GT();
   GT(const GT &w);
@@ -224,6 +240,9 @@ public:
   GT exp(const ZP k) const;
   GT inverse() const;
 
+  void setFixedBase(const std::shared_ptr<GTFixedBase> &table) { this->m_FixedBase = table; }
+  bool hasFixedBase() const { return this->m_FixedBase != nullptr; }
+
   GT& operator*=(const GT &x);
   GT& operator=(const GT &x);
 
@@ -242,6 +261,64 @@ public:
   void deserialize(OpenABEByteString &input);
 };
 
+/// \class  G1FixedBase
+/// \brief  Precomputed table for fixed-base scalar multiplication in G1.
+///         Intended for long-lived bases such as the MPK generators.
+class G1FixedBase {
+public:
+  G1FixedBase(const G1 &base);
+  ~G1FixedBase();
+
+  G1FixedBase(const G1FixedBase&) = delete;
+  G1FixedBase& operator=(const G1FixedBase&) = delete;
+
+  G1 operator*(const ZP &k) const;
+
+private:
+  // order of the group the table was built for (scalars must be below it)
+  BPGroup m_Group;
+  g1_t m_Base;
+  mutable g1_t m_Table[RLC_G1_TABLE];
+};
+
+/// \class  G2FixedBase
+/// \brief  Precomputed table for fixed-base scalar multiplication in G2.
+class G2FixedBase {
+public:
+  G2FixedBase(const G2 &base);
+  ~G2FixedBase();
+
+  G2FixedBase(const G2FixedBase&) = delete;
+  G2FixedBase& operator=(const G2FixedBase&) = delete;
+
+  G2 operator*(const ZP &k) const;
+
+private:
+  BPGroup m_Group;
+  g2_t m_Base;
+  mutable g2_t m_Table[RLC_G2_TABLE];
+};
+
+/// \class  GTFixedBase
+/// \brief  Windowed table for fixed-base exponentiation in GT. Stores
+///         base^(d * 2^(w*i)) for every window i and digit d, so that an
+///         exponentiation costs one multiplication per non-zero window.
+class GTFixedBase {
+public:
+  GTFixedBase(const GT &base);
+  ~GTFixedBase() {}
+
+  GTFixedBase(const GTFixedBase&) = delete;
+  GTFixedBase& operator=(const GTFixedBase&) = delete;
+
+  GT exp(const ZP &k) const;
+
+private:
+  GT m_Base;
+  int m_MaxBits;
+  std::vector<GT> m_Table;
+};
+
 GT pairing(const G1 &x, const G2 &y);
 
 /// \typedef    OpenABEElementList
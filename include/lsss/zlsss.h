@@ -36,11 +36,14 @@
 #define __ZLSSS_H__
 
 #include <stack>
+#include <string>
+#include <utility>
 #include <vector>
 #include <map>
 
 #include "zobject.h"
 #include "zelement_bp.h"
+#include "zscalar.h"
 #include "zpolicy.h"
 #include "zattributelist.h"
 #include "hashattributes.h"
@@ -84,6 +87,44 @@ typedef std::map<const std::string, OpenABELSSSElement> OpenABELSSSRowMap;
 /// \brief      Iterator for vector of results in an LSSS
 typedef OpenABELSSSRowMap::iterator OpenABELSSSRowMapIterator;
 
+/// \class  OpenABELSSSMatrix
+/// \brief  Share-generating matrix of a policy tree, compiled once. Row i
+///         belongs to the i-th leaf (left to right) and share i is row i
+///         times (secret, r_1, ..., r_{d-1}). Column 0 is the secret; a
+///         gate with threshold t owns t-1 consecutive columns and gives its
+///         j-th subnode the entries x, x^2, ..., x^{t-1} in them (x = j+1),
+///         so the shares are those of the tree sharing and coefficient
+///         recovery is unchanged. Rows are stored as these blocks.
+
+class OpenABELSSSMatrix {
+public:
+  OpenABELSSSMatrix() : m_NumColumns(1) {}
+  explicit OpenABELSSSMatrix(const OpenABEPolicy *policy);
+
+  size_t numRows() const    { return this->m_RowLabels.size(); }
+  size_t numColumns() const { return this->m_NumColumns; }
+  // (unique row label, attribute label) of every row
+  const std::vector<std::pair<std::string, std::string>>& getRowLabels() const { return this->m_RowLabels; }
+  void getRow(size_t row, std::vector<std::pair<uint32_t, ZPFixed>> &entries) const;
+
+  void multiply(const std::vector<ZPFixed> &vec, std::vector<ZPFixed> &shares) const;
+  void shareSecret(const ZPFixed &secret, std::vector<ZPFixed> &shares) const;
+  bool checkReconstruction(const OpenABELSSSRowMap &coefficients) const;
+  std::string toString() const;
+
+private:
+  struct Block {
+    uint32_t column, length;
+    ZPFixed x;
+  };
+
+  std::vector<std::pair<std::string, std::string>> m_RowLabels;
+  // blocks of row i are m_Blocks[m_RowStart[i]] ... m_Blocks[m_RowStart[i+1]-1]
+  std::vector<uint32_t> m_RowStart;
+  std::vector<Block> m_Blocks;
+  uint32_t m_NumColumns;
+};
+
 /// \class	ZLSSS
 /// \brief	Secret sharing class.
 
@@ -91,7 +132,6 @@ class OpenABELSSS : public ZObject {
 protected:
   OpenABELSSSRowMap	m_ResultMap;
   bool debug;
-  ZP zero, iPlusOne, indexPlusOne;
   std::map<std::string, int> m_AttrCount;
   bn_t order;
 
@@ -102,11 +142,11 @@ protected:
   void addShareToResults(OpenABETreeNode *treeNode, ZP &elt);
   bool clearExistingResults() { this->m_ResultMap.clear(); return true; }
   inline std::string makeUniqueLabel(const OpenABETreeNode *treeNode);
-  inline ZP evaluatePolynomial(std::vector<ZP> &coefficients, uint32_t x);
+  inline ZPFixed evaluatePolynomial(const std::vector<ZPFixed> &coefficients, uint32_t x);
 
   void iterativeShareSecret(OpenABETreeNode *treeNode, ZP &elt);
-  bool iterativeCoefficientRecover(OpenABETreeNode *treeNode, ZP &inCoeff);
-  inline ZP calculateCoefficient(OpenABETreeNode *treeNode, uint32_t index, uint32_t threshold, uint32_t total);
+  bool iterativeCoefficientRecover(OpenABETreeNode *treeNode, const ZPFixed &inCoeff);
+  inline ZPFixed calculateCoefficient(OpenABETreeNode *treeNode, uint32_t index, uint32_t threshold, uint32_t total);
 
 public:
   OpenABELSSS();
@@ -115,7 +155,9 @@ public:
     
   // Public secret sharing and recovery methods
   void shareSecret(const OpenABEFunctionInput *input, ZP &elt);
+  void shareSecret(const OpenABELSSSMatrix &matrix, ZP &elt);
   bool recoverCoefficients(OpenABEPolicy *policy, OpenABEAttributeList *attrList);
+  void getRowLabels(const OpenABEPolicy *policy, std::vector<std::pair<std::string, std::string>> &rows);
 
   // Methods for obtaining the rows
   OpenABELSSSRowMap& getRows() { return m_ResultMap; }
@@ -78,6 +78,8 @@ protected:
   std::string                 m_Prefix;
   std::string                 m_Label;
   int                         m_Index;
+  // interned ID of the complete label (-1 until first use)
+  int64_t                     m_AttributeId = -1;
     
 public:
   // Constructors/destructors
@@ -100,7 +102,7 @@ public:
   OpenABETreeNode*  getSubnode(uint32_t index);
 
   void addSubnode(OpenABETreeNode* subnode);
-  void setLabel(const std::string label) { this->m_Label = label; }
+  void setLabel(const std::string label) { this->m_Label = label; this->m_AttributeId = -1; }
   const std::string& getPrefix() const  { return this->m_Prefix; }
   const std::string& getLabel() const	{ return this->m_Label; }
   const std::string getCompleteLabel() const {
@@ -112,6 +114,7 @@ public:
       return this->m_Label;
     }
   }
+  uint32_t getAttributeId();
   const int getIndex() const   { return this->m_Index; }
   void setThresholdValue(uint32_t k) { if (this->m_Subnodes.size() > 0) { this->m_thresholdValue = k; } }
   uint32_t getThresholdValue();
@@ -0,0 +1,85 @@
+/// 
+/// Copyright (c) 2018 Zeutro, LLC. All rights reserved.
+/// 
+/// This file is part of Zeutro's OpenABE.
+/// 
+/// OpenABE is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU Affero General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+/// 
+/// OpenABE is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU Affero General Public License for more details.
+/// 
+/// You should have received a copy of the GNU Affero General Public
+/// License along with OpenABE. If not, see <http://www.gnu.org/licenses/>.
+/// 
+/// You can be released from the requirements of the GNU Affero General
+/// Public License and obtain additional features by purchasing a
+/// commercial license. Buying such a license is mandatory if you
+/// engage in commercial activities involving OpenABE that do not
+/// comply with the open source requirements of the GNU Affero General
+/// Public License. For more information on commerical licenses,
+/// visit <http://www.zeutro.com>.
+///
+/// \file   zrandom.h
+///
+/// \brief  Per-thread buffered random number generator used for group
+///         scalars, keys and nonces.
+///
+
+#ifndef __ZRANDOM_H__
+#define __ZRANDOM_H__
+
+#include <cstdint>
+#include <vector>
+
+#include <openssl/evp.h>
+
+#include "zelement_bp.h"
+
+// keystream bytes produced per refill of the per-thread buffer
+#define OpenABE_RNG_BUFFER_SIZE   4096
+// bytes generated before the key is replaced with fresh OS entropy
+#define OpenABE_RNG_RESEED_BYTES  (1ULL << 30)
+#define OpenABE_RNG_KEY_LEN       32
+
+/// \class  OpenABERandom
+/// \brief  CSPRNG with one instance per thread, so sampling needs no lock
+///         and threads do not share generator state. It outputs an
+///         AES-256-CTR keystream in batches of OpenABE_RNG_BUFFER_SIZE
+///         bytes. After every batch the key is replaced by keystream
+///         output (fast key erasure). It is reseeded from the OS every
+///         OpenABE_RNG_RESEED_BYTES and after a fork.
+
+class OpenABERandom {
+public:
+  static OpenABERandom& getInstance();
+
+  void getBytes(uint8_t *buf, size_t len);
+  void sampleBelow(const uint8_t *bound, size_t boundLen, uint8_t *out, size_t count);
+
+  OpenABERandom(const OpenABERandom&) = delete;
+  OpenABERandom& operator=(const OpenABERandom&) = delete;
+  ~OpenABERandom();
+
+private:
+  OpenABERandom();
+
+  void reseed();
+  void refill();
+
+  EVP_CIPHER_CTX *ctx;
+  uint8_t buffer[OpenABE_RNG_BUFFER_SIZE + OpenABE_RNG_KEY_LEN];
+  size_t position;
+  uint64_t generated;
+  // fork generation the generator was last seeded in
+  uint64_t forkGeneration;
+};
+
+void OpenABE_randomBelow(bignum_t result, bignum_t order);
+std::vector<ZP> OpenABE_randomZPs(size_t count, bignum_t order);
+
+#endif /* ifdef __ZRANDOM_H__ */
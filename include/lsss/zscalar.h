@@ -0,0 +1,240 @@
+/// 
+/// Copyright (c) 2018 Zeutro, LLC. All rights reserved.
+/// 
+/// This file is part of Zeutro's OpenABE.
+/// 
+/// OpenABE is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU Affero General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+/// 
+/// OpenABE is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU Affero General Public License for more details.
+/// 
+/// You should have received a copy of the GNU Affero General Public
+/// License along with OpenABE. If not, see <http://www.gnu.org/licenses/>.
+/// 
+/// You can be released from the requirements of the GNU Affero General
+/// Public License and obtain additional features by purchasing a
+/// commercial license. Buying such a license is mandatory if you
+/// engage in commercial activities involving OpenABE that do not
+/// comply with the open source requirements of the GNU Affero General
+/// Public License. For more information on commerical licenses,
+/// visit <http://www.zeutro.com>.
+///
+/// \file   zscalar.h
+///
+/// \brief  Fixed-width scalar field element for the group order of the
+///         configured curve, used by the LSSS arithmetic.
+///
+
+#ifndef __ZSCALAR_H__
+#define __ZSCALAR_H__
+
+#include <array>
+#include <cstdint>
+
+#include "zelement_bp.h"
+
+// Group order of the curve RELIC is built for, least significant limb
+// first. ZPFixed::initGroupOrder() checks it against the order reported by
+// RELIC. Other curves read the order from RELIC once at run time and use
+// enough limbs for any order below 2^(FP_PRIME+1).
+#if FP_PRIME == 254
+// BN-P254
+#define OpenABE_ZP_FIXED_LIMBS    4
+#define OpenABE_ZP_FIXED_MODULUS  { 0xA10000000000000DULL, 0xFF9F800000000010ULL, \
+                                    0xBA344D8000000007ULL, 0x2523648240000001ULL }
+#elif FP_PRIME == 381
+// BLS12-381
+#define OpenABE_ZP_FIXED_LIMBS    4
+#define OpenABE_ZP_FIXED_MODULUS  { 0xFFFFFFFF00000001ULL, 0x53BDA402FFFE5BFEULL, \
+                                    0x3339D80809A1D805ULL, 0x73EDA753299D7D48ULL }
+#else
+#define OpenABE_ZP_FIXED_LIMBS    ((FP_PRIME + 64) / 64)
+#endif
+
+#define OpenABE_ZP_FIXED_BYTES    (OpenABE_ZP_FIXED_LIMBS * 8)
+
+typedef std::array<uint64_t, OpenABE_ZP_FIXED_LIMBS> ZPFixedLimbs;
+
+// helpers for the Montgomery constants of ZPFixed (compile time when the
+// modulus is known)
+
+static constexpr bool zpfixed_lessThan(const ZPFixedLimbs &a, const ZPFixedLimbs &b) {
+  for (int i = OpenABE_ZP_FIXED_LIMBS - 1; i >= 0; i--) {
+    if (a[i] != b[i]) {
+      return a[i] < b[i];
+    }
+  }
+  return false;
+}
+
+// r = a - b, returns the borrow
+static constexpr uint64_t zpfixed_subtract(ZPFixedLimbs &r, const ZPFixedLimbs &a,
+                                           const ZPFixedLimbs &b) {
+  uint64_t borrow = 0;
+  for (int i = 0; i < OpenABE_ZP_FIXED_LIMBS; i++) {
+    uint64_t d = a[i] - b[i];
+    uint64_t nextBorrow = (a[i] < b[i]) | (d < borrow);
+    r[i] = d - borrow;
+    borrow = nextBorrow;
+  }
+  return borrow;
+}
+
+// -p^-1 mod 2^64 (Newton iteration, each step doubles the correct bits)
+static constexpr uint64_t zpfixed_montInverse(const ZPFixedLimbs &p) {
+  uint64_t inv = 1;
+  for (int i = 0; i < 6; i++) {
+    inv *= 2 - p[0] * inv;
+  }
+  return ~inv + 1;
+}
+
+// 2^(2 * 64 * limbs) mod p, by doubling 1 modulo p
+static constexpr ZPFixedLimbs zpfixed_montR2(const ZPFixedLimbs &p) {
+  ZPFixedLimbs r{};
+  r[0] = 1;
+  for (int i = 0; i < 2 * 64 * OpenABE_ZP_FIXED_LIMBS; i++) {
+    uint64_t carry = 0;
+    for (int j = 0; j < OpenABE_ZP_FIXED_LIMBS; j++) {
+      uint64_t next = r[j] >> 63;
+      r[j] = (r[j] << 1) | carry;
+      carry = next;
+    }
+    if (carry || !zpfixed_lessThan(r, p)) {
+      zpfixed_subtract(r, r, p);
+    }
+  }
+  return r;
+}
+
+/// \class  ZPFixed
+/// \brief  Element of ZP kept in Montgomery form in a fixed number of
+///         64-bit limbs. For the curves listed above the modulus and the
+///         Montgomery constants are compile-time constants. The
+///         arithmetic never allocates and needs no RELIC context.
+///         Conversions from and to ZP happen at the LSSS boundaries.
+
+class ZPFixed {
+public:
+  typedef ZPFixedLimbs Limbs;
+
+#ifdef OpenABE_ZP_FIXED_MODULUS
+  static constexpr Limbs MODULUS = OpenABE_ZP_FIXED_MODULUS;
+#else
+  static Limbs MODULUS;
+#endif
+
+  ZPFixed() : v{} {}
+
+  static void initGroupOrder();
+  static ZPFixed fromUint(uint64_t x);
+  static ZPFixed fromBytes(const uint8_t *buf, size_t len);
+  static ZPFixed fromZP(const ZP &z);
+  static ZPFixed random();
+
+  void toBytes(uint8_t out[OpenABE_ZP_FIXED_BYTES]) const;
+  ZP toZP() const;
+
+  ZPFixed operator+(const ZPFixed &y) const { ZPFixed r; add(r.v, this->v, y.v); return r; }
+  ZPFixed operator-(const ZPFixed &y) const { ZPFixed r; sub(r.v, this->v, y.v); return r; }
+  ZPFixed operator*(const ZPFixed &y) const { ZPFixed r; montMul(r.v, this->v, y.v); return r; }
+  ZPFixed operator-() const { return ZPFixed() - *this; }
+  ZPFixed& operator+=(const ZPFixed &y) { add(this->v, this->v, y.v); return *this; }
+  ZPFixed& operator-=(const ZPFixed &y) { sub(this->v, this->v, y.v); return *this; }
+  ZPFixed& operator*=(const ZPFixed &y) { montMul(this->v, this->v, y.v); return *this; }
+  bool operator==(const ZPFixed &y) const { return this->v == y.v; }
+  bool operator!=(const ZPFixed &y) const { return this->v != y.v; }
+
+  bool isZero() const { return this->v == Limbs{}; }
+  ZPFixed inverse() const;
+
+private:
+  // Montgomery form: value * 2^(64 * limbs) mod MODULUS
+  Limbs v;
+
+#ifdef OpenABE_ZP_FIXED_MODULUS
+  static constexpr uint64_t N0INV = zpfixed_montInverse(MODULUS);
+  static constexpr Limbs R2 = zpfixed_montR2(MODULUS);
+  static_assert((MODULUS[0] & 1) == 1, "ZPFixed: the modulus must be odd");
+#else
+  static uint64_t N0INV;
+  static Limbs R2;
+#endif
+
+  static void add(Limbs &r, const Limbs &a, const Limbs &b);
+  static void sub(Limbs &r, const Limbs &a, const Limbs &b);
+  static void montMul(Limbs &r, const Limbs &a, const Limbs &b);
+};
+
+/********************************************************************************
+ * Inline arithmetic of the ZPFixed class
+ ********************************************************************************/
+
+inline void ZPFixed::add(Limbs &r, const Limbs &a, const Limbs &b) {
+  unsigned __int128 carry = 0;
+  for (int i = 0; i < OpenABE_ZP_FIXED_LIMBS; i++) {
+    carry += (unsigned __int128) a[i] + b[i];
+    r[i] = (uint64_t) carry;
+    carry >>= 64;
+  }
+  // a + b < 2 * MODULUS, so one subtraction (modulo 2^(64 * limbs)) reduces it
+  if (carry || !zpfixed_lessThan(r, MODULUS)) {
+    zpfixed_subtract(r, r, MODULUS);
+  }
+}
+
+inline void ZPFixed::sub(Limbs &r, const Limbs &a, const Limbs &b) {
+  if (zpfixed_subtract(r, a, b)) {
+    unsigned __int128 carry = 0;
+    for (int i = 0; i < OpenABE_ZP_FIXED_LIMBS; i++) {
+      carry += (unsigned __int128) r[i] + MODULUS[i];
+      r[i] = (uint64_t) carry;
+      carry >>= 64;
+    }
+  }
+}
+
+// r = a * b * 2^-(64 * limbs) mod MODULUS (CIOS Montgomery multiplication)
+inline void ZPFixed::montMul(Limbs &r, const Limbs &a, const Limbs &b) {
+  const int n = OpenABE_ZP_FIXED_LIMBS;
+  uint64_t t[n + 2] = {0};
+  for (int i = 0; i < n; i++) {
+    unsigned __int128 s;
+    uint64_t carry = 0;
+    for (int j = 0; j < n; j++) {
+      s = (unsigned __int128) a[j] * b[i] + t[j] + carry;
+      t[j] = (uint64_t) s;
+      carry = (uint64_t) (s >> 64);
+    }
+    s = (unsigned __int128) t[n] + carry;
+    t[n] = (uint64_t) s;
+    t[n + 1] = (uint64_t) (s >> 64);
+
+    uint64_t m = t[0] * N0INV;
+    s = (unsigned __int128) m * MODULUS[0] + t[0];
+    carry = (uint64_t) (s >> 64);
+    for (int j = 1; j < n; j++) {
+      s = (unsigned __int128) m * MODULUS[j] + t[j] + carry;
+      t[j - 1] = (uint64_t) s;
+      carry = (uint64_t) (s >> 64);
+    }
+    s = (unsigned __int128) t[n] + carry;
+    t[n - 1] = (uint64_t) s;
+    t[n] = t[n + 1] + (uint64_t) (s >> 64);
+  }
+  Limbs result;
+  for (int i = 0; i < n; i++) {
+    result[i] = t[i];
+  }
+  if (t[n] || !zpfixed_lessThan(result, MODULUS)) {
+    zpfixed_subtract(result, result, MODULUS);
+  }
+  r = result;
+}
+
+#endif /* ifdef __ZSCALAR_H__ */
@@ -81,6 +81,7 @@ OpenABEContextCPWaters::generateParams(const string &mpkID, const string &mskID)
   OpenABEByteString k;
 
   try {
+    OpenABE_initializeThreadContext();
     // Instantiate a OpenABE pairing object with the given parameters
     this->initializeCurve();
 
@@ -116,6 +117,7 @@ OpenABEContextCPWaters::generateParams(const string &mpkID, const string &mskID)
     MPK->setComponent("g1a", &g1a);
     MPK->setComponent("A", &A);
     MPK->setComponent("k", &k);
+    MPK->precomputeGTFixedBase();
 
     // Add (\alpha and g2a) to the secret params
     MSK->setComponent("alpha", &alpha);
@@ -150,58 +152,127 @@ OpenABEContextCPWaters::generateDecryptionKey(
     const string &mskID, const string &gpkID = "", const string &GID = "") {
   OpenABE_ERROR result = OpenABE_ERROR_UNKNOWN;
   shared_ptr<OpenABEKey> decKey = nullptr;
+
+  try {
+    OpenABE_initializeThreadContext();
+    unique_ptr<OpenABEKeygenSetup> setup = this->prepareKeygen(mpkID, mskID);
+    result = this->generateDecryptionKeyPrepared(setup.get(), keyInput, keyID, decKey, 1);
+    ASSERT(result == OpenABE_NOERROR, result);
+
+    // Add the decryption key to the keystore
+    this->getKeystore()->addKey(keyID, decKey, KEY_TYPE_SECRET);
+  } catch (OpenABE_ERROR &err) {
+    result = err;
+  }
+
+  return result;
+}
+
+///
+/// @class  OpenABECPWatersKeygenSetup
+///
+/// @brief  Key-independent part of a CP-Waters key generation.
+///
+
+class OpenABECPWatersKeygenSetup : public OpenABEKeygenSetup {
+public:
+  using OpenABEKeygenSetup::OpenABEKeygenSetup;
+  shared_ptr<G2FixedBase> g2, g2a;
+  // g2^alpha, shared by every key
+  G2 g2alpha;
+};
+
+/*!
+ * Load the master keys and compute the part of the key generation that
+ * does not depend on the user: the fixed-base tables of g2 and g2^a and
+ * the term g2^alpha.
+ *
+ * @param   Parameters ID for the public master parameters.
+ * @param   Parameters ID for the master secret parameters.
+ * @return  The key generation setup. Throws an OpenABE_ERROR on failure.
+ */
+
+unique_ptr<OpenABEKeygenSetup>
+OpenABEContextCPWaters::prepareKeygen(const string &mpkID, const string &mskID) {
+  // Load the master secret and public key
+  shared_ptr<OpenABEKey> MPK = this->getKeystore()->getPublicKey(mpkID);
+  shared_ptr<OpenABEKey> MSK = this->getKeystore()->getSecretKey(mskID);
+  if (MPK == nullptr || MSK == nullptr) {
+    throw OpenABE_ERROR_INVALID_PARAMS;
+  }
+  // retrieve the hash function key prefix
+  OpenABEByteString *k = MPK->getByteString("k");
+  ASSERT_NOTNULL(k);
+
+  unique_ptr<OpenABECPWatersKeygenSetup> setup(
+      new OpenABECPWatersKeygenSetup(this->getPairing(), *k));
+  setup->g2 = MPK->getG2FixedBase("g2");
+  setup->g2a = MSK->getG2FixedBase("g2a");
+  setup->g2alpha = *setup->g2 * *MSK->getZP("alpha");
+
+  return unique_ptr<OpenABEKeygenSetup>(setup.release());
+}
+
+/*!
+ * Generate a decryption key for an attribute list using a prepared setup.
+ * The key is returned and not added to the keystore. With more than one
+ * thread, the attribute components are computed in parallel.
+ *
+ * @param   Key generation setup returned by prepareKeygen.
+ * @param   The attribute list.
+ * @param   Identifier of the key.
+ * @param   The generated key.
+ * @param   Number of threads (0 for automatic).
+ * @return  An error code or OpenABE_NOERROR.
+ */
+
+OpenABE_ERROR
+OpenABEContextCPWaters::generateDecryptionKeyPrepared(OpenABEKeygenSetup *keygenSetup,
+                                  OpenABEFunctionInput* keyInput, const string &keyID,
+                                  shared_ptr<OpenABEKey>& decKey, unsigned int numThreads) {
+  OpenABE_ERROR result = OpenABE_NOERROR;
   OpenABEAttributeList* attrList = nullptr;
-  OpenABEByteString *k = nullptr;
 
   try {
+    OpenABE_initializeThreadContext();
+    OpenABECPWatersKeygenSetup *setup = dynamic_cast<OpenABECPWatersKeygenSetup *>(keygenSetup);
+    ASSERT_NOTNULL(setup);
     // Ensure that the given input is a OpenABEAttributeList
     if ((attrList = dynamic_cast<OpenABEAttributeList*>(keyInput)) == nullptr) {
       OpenABE_LOG_AND_THROW("Decryption key input must be an Attribute List",
                         OpenABE_ERROR_INVALID_INPUT);
     }
 
-    // Load the master secret and public key
-    shared_ptr<OpenABEKey> MPK = this->getKeystore()->getPublicKey(mpkID);
-    shared_ptr<OpenABEKey> MSK = this->getKeystore()->getSecretKey(mskID);
-    if (MPK == nullptr || MSK == nullptr) {
-      throw OpenABE_ERROR_INVALID_PARAMS;
-    }
-    // retrieve the hash function key prefix
-    k = MPK->getByteString("k");
     // Create a new OpenABEKey object for the decryption key
-    decKey.reset( new OpenABEKey(this->algID, keyID));
+    decKey.reset(new OpenABEKey(this->algID, keyID));
 
     // Add the attribute list to the key
     decKey->setComponent("input", attrList);
 
     // Select a random element t \in ZP
     ZP t = this->getPairing()->randomZP();
-    ZP alpha = *MSK->getZP("alpha");
 
     // K = g2^\alpha * (g2^{a})^t
-    G2 K = (*MPK->getG2("g2") * alpha) + (*MSK->getG2("g2a") * t);
+    G2 K = setup->g2alpha + (*setup->g2a * t);
     decKey->setComponent("K", &K);
 
     // L = g2^t
-    G2 L = *MPK->getG2("g2") * t;
+    G2 L = *setup->g2 * t;
     decKey->setComponent("L", &L);
 
     // For each attribute in the attribute list
-    string attr, attr_deckey;
+    // compute KX_{attribute} = hash_to_G1(attribute)^t
     const vector<string> *attrStrings = attrList->getAttributeList();
-    for (auto it = attrStrings->begin(); it != attrStrings->end(); ++it) {
-      // Compute KX_{attribute} = hash_to_G1(attribute)^t
-      attr = *it;
-      G1 kx = this->getPairing()->hashToG1(*k, attr) * t;
-      attr_deckey = OpenABEHashKey(attr);
-      decKey->setComponent(OpenABEMakeElementLabel("KX", attr_deckey), &kx);
+    vector<G1> kx(attrStrings->size());
+    this->parallelKeygenRows(attrStrings->size(), numThreads, [&](size_t i) {
+      kx[i] = setup->hashAttribute(attrStrings->at(i)) * t;
+    });
+    for (size_t i = 0; i < attrStrings->size(); i++) {
+      string attr_deckey = OpenABEHashKey(attrStrings->at(i));
+      decKey->setComponent(OpenABEMakeElementLabel("KX", attr_deckey), &kx[i]);
     }
-
-    // Add the decryption key to the keystore
-    this->getKeystore()->addKey(keyID, decKey, KEY_TYPE_SECRET);
-
-    result = OpenABE_NOERROR;
   } catch (OpenABE_ERROR &err) {
+    decKey = nullptr;
     result = err;
   }
 
@@ -222,63 +293,183 @@ OpenABEContextCPWaters::encryptKEM(const string &mpkID, const OpenABEFunctionInp
                                uint32_t keyByteLen, const std::shared_ptr<OpenABESymKey> &key,
                                OpenABECiphertext& ciphertext) {
   OpenABE_ERROR result = OpenABE_ERROR_ENCRYPTION_ERROR;
-  OpenABEByteString *k = nullptr;
 
   try {
+    OpenABE_initializeThreadContext();
     ASSERT_NOTNULL(key);
+    unique_ptr<OpenABEEncryptionSetup> setup = this->prepareEncryption(mpkID, encryptInput);
+    result = this->encryptKEMPrepared(setup.get(), keyByteLen, key, ciphertext);
+  } catch (OpenABE_ERROR &err) {
+    result = err;
+  }
 
-    // Ensure that the given input is a OpenABEPolicy
-    const OpenABEPolicy *policy = dynamic_cast<const OpenABEPolicy *>(encryptInput);
-    if (policy == nullptr) {
-      OpenABE_LOG_AND_THROW("Encryption input must be a Policy",
-                        OpenABE_ERROR_INVALID_INPUT);
-    }
-    // Load the master public key
-    shared_ptr<OpenABEKey> MPK = this->getKeystore()->getPublicKey(mpkID);
-    if (MPK == nullptr) {
-      throw OpenABE_ERROR_INVALID_PARAMS;
-    }
-    // retrieve the hash function key prefix
-    k = MPK->getByteString("k");
+  return result;
+}
 
-    // Select s and compute C = e(g1, g2)^\(alpha*s)
-    ZP s = this->getPairing()->randomZP();
-    GT C = MPK->getGT("A")->exp(s);
+///
+/// @class  OpenABECPWatersEncryptionSetup
+///
+/// @brief  Policy-dependent part of a CP-Waters encryption.
+///
+
+class OpenABECPWatersEncryptionSetup : public OpenABEEncryptionSetup {
+public:
+  const OpenABEPolicy *policy;
+  OpenABEByteString policyBytes;
+  // share-generating matrix of the policy
+  shared_ptr<const OpenABELSSSMatrix> matrix;
+  GT A;
+  shared_ptr<G1FixedBase> g1, g1a;
+  shared_ptr<G2FixedBase> g2;
+  // hash_to_G1 of every attribute of the policy, keyed by its complete label
+  shared_ptr<const OpenABEHashedAttributes> hashedAttributes;
+  // precomputed randomness for this MPK (if enabled)
+  shared_ptr<OpenABEPrecomputePool> pool;
+};
+
+/*!
+ * Compute the part of the encryption that only depends on the policy and
+ * the master public key: the serialized policy, the fixed-base tables of
+ * the MPK generators, the share-generating matrix of the policy and the
+ * hash of every policy attribute into G1. When the input is an
+ * OpenABECompiledPolicy, the matrix and hashed attributes come from it.
+ *
+ * @param   Parameters ID for the public master parameters.
+ * @param   Function input for the encryption (a policy).
+ * @return  The encryption setup. Throws an OpenABE_ERROR on failure.
+ */
+
+unique_ptr<OpenABEEncryptionSetup>
+OpenABEContextCPWaters::prepareEncryption(const string &mpkID, const OpenABEFunctionInput* encryptInput) {
+  // Ensure that the given input is a OpenABEPolicy
+  const OpenABEPolicy *policy = dynamic_cast<const OpenABEPolicy *>(encryptInput);
+  if (policy == nullptr) {
+    OpenABE_LOG_AND_THROW("Encryption input must be a Policy",
+                      OpenABE_ERROR_INVALID_INPUT);
+  }
+  // Load the master public key
+  shared_ptr<OpenABEKey> MPK = this->getKeystore()->getPublicKey(mpkID);
+  if (MPK == nullptr) {
+    throw OpenABE_ERROR_INVALID_PARAMS;
+  }
+  // retrieve the hash function key prefix
+  OpenABEByteString *k = MPK->getByteString("k");
+  ASSERT_NOTNULL(k);
+
+  unique_ptr<OpenABECPWatersEncryptionSetup> setup(new OpenABECPWatersEncryptionSetup);
+  setup->policy = policy;
+  setup->A = *MPK->getGT("A");
+  // fixed-base tables for the MPK generators (built on first use)
+  setup->g1 = MPK->getG1FixedBase("g1");
+  setup->g1a = MPK->getG1FixedBase("g1a");
+  setup->g2 = MPK->getG2FixedBase("g2");
+  setup->pool = this->getPrecomputePool(mpkID);
+
+  // A compiled policy already has its matrix and caches the hashed
+  // attributes per MPK; otherwise compile and hash them now.
+  const OpenABECompiledPolicy *compiled = dynamic_cast<const OpenABECompiledPolicy *>(policy);
+  if (compiled != nullptr) {
+    setup->policyBytes = compiled->getPolicyBytes();
+    setup->matrix = compiled->getMatrix();
+    setup->hashedAttributes = compiled->getHashedAttributes(this->getPairing(), *k);
+  } else {
+    setup->policyBytes = policy->toCompactString();
+    setup->matrix = make_shared<const OpenABELSSSMatrix>(policy);
+    setup->hashedAttributes = OpenABE_hashPolicyAttributes(this->getPairing(), *k,
+                                                           setup->matrix->getRowLabels());
+  }
+
+  return unique_ptr<OpenABEEncryptionSetup>(setup.release());
+}
+
+/*!
+ * Generate and encrypt a symmetric key using a prepared policy. Only the
+ * per-ciphertext randomness is computed here, and the setup is not
+ * modified, so several threads can encrypt with the same setup.
+ *
+ * With a precompute pool the expensive parts come from the pool: s with
+ * A^s and g1^s, g2^ri with hash_to_G1(attribute)^-ri for known attributes,
+ * and g1a^l for a random l. In the last case C[i] is computed from l
+ * instead of the share, and the correction share - l is stored as E[i]
+ * (Hohenberger-Waters online/offline encryption).
+ *
+ * @param   Encryption setup returned by prepareEncryption.
+ * @param   Length of the symmetric key in bytes.
+ * @param   Symmetric key to be returned.
+ * @param   ABE ciphertext.
+ * @return  An error code or OpenABE_NOERROR.
+ */
+
+OpenABE_ERROR
+OpenABEContextCPWaters::encryptKEMPrepared(const OpenABEEncryptionSetup *setup, uint32_t keyByteLen,
+                               const std::shared_ptr<OpenABESymKey> &key,
+                               OpenABECiphertext& ciphertext) {
+  OpenABE_ERROR result = OpenABE_ERROR_ENCRYPTION_ERROR;
+
+  try {
+    OpenABE_initializeThreadContext();
+    ASSERT_NOTNULL(key);
+    const OpenABECPWatersEncryptionSetup *cpSetup =
+        dynamic_cast<const OpenABECPWatersEncryptionSetup *>(setup);
+    ASSERT_NOTNULL(cpSetup);
+
+    OpenABEPrecomputePool *pool = cpSetup->pool.get();
+    OpenABEPrecomputedSession session;
+    if (pool == nullptr || !pool->takeSession(session)) {
+      // Select s and compute C = e(g1, g2)^\(alpha*s) and Cprime = g1^s
+      session.s = this->getPairing()->randomZP();
+      session.C = cpSetup->A.exp(session.s);
+      session.Cprime = *cpSetup->g1 * session.s;
+    }
 
     // Use the Linear Secret Sharing Scheme (LSSS) to compute an enumerated list
-    // of all attributes and corresponding secret shares of s.
+    // of all attributes and corresponding secret shares of s (one product of
+    // the compiled matrix with a random vector).
     OpenABELSSS lsss;
-    lsss.shareSecret(policy, s);
-
-    // Allocate the ciphertext object and add the policy and key length
-    OpenABEByteString pol;
-    pol = policy->toCompactString();
-    ciphertext.setComponent("policy", &pol);
+    lsss.shareSecret(*cpSetup->matrix, session.s);
 
-    // Compute Cprime = g1^s
-    G1 Cprime = *MPK->getG1("g1") * s;
-    ciphertext.setComponent("Cprime", &Cprime);
+    // Add the policy to the ciphertext
+    ciphertext.setComponent("policy", &cpSetup->policyBytes);
+    ciphertext.setComponent("Cprime", &session.Cprime);
 
     // For each element of the LSSS
-    ZP ri;
     string attr_key;
+    OpenABEPrecomputedAttribute row;
+    OpenABEPrecomputedShare share;
     OpenABELSSSRowMap lsssRows = lsss.getRows();
     for (auto it = lsssRows.begin(); it != lsssRows.end(); ++it) {
-      // Pick a random value ri.
-      ri = this->getPairing()->randomZP();
-      // Compute D[i] = g2^{ri}
-      G2 Di = *MPK->getG2("g2") * ri;
+      const string label = it->second.label();
+      auto hG1 = cpSetup->hashedAttributes->find(label);
+      if (hG1 == cpSetup->hashedAttributes->end()) {
+        throw OpenABE_ERROR_INVALID_POLICY;
+      }
+      // Pick a random value ri and compute D[i] = g2^{ri} and hash_to_G1(attribute)^{-ri}
+      if (pool == nullptr || !pool->takeAttribute(label, row)) {
+        row.r = this->getPairing()->randomZP();
+        row.D = *cpSetup->g2 * row.r;
+        row.hashNeg = hG1->second * (-row.r);
+        if (pool != nullptr) {
+          pool->addAttribute(label, hG1->second);
+        }
+      }
       attr_key = OpenABEHashKey(it->first);
-      ciphertext.setComponent(OpenABEMakeElementLabel("D", attr_key), &Di);
+      ciphertext.setComponent(OpenABEMakeElementLabel("D", attr_key), &row.D);
 
       // Compute C[i] = g1a^{share_i} * hash_to_G1(attribute)^{-r}
-      G1 hG1 = this->getPairing()->hashToG1(*k, it->second.label());
-      G1 Ci = (*MPK->getG1("g1a") * it->second.element()) + (hG1 * (-ri));
-      ciphertext.setComponent(OpenABEMakeElementLabel("C", attr_key), &Ci);
+      if (pool != nullptr && pool->takeShare(share)) {
+        // C[i] = g1a^{l} * hash_to_G1(attribute)^{-r}, E[i] = share_i - l
+        G1 Ci = share.g1aLambda + row.hashNeg;
+        ciphertext.setComponent(OpenABEMakeElementLabel("C", attr_key), &Ci);
+        OpenABEByteString Ei = (it->second.element() - share.lambda).getByteString();
+        ciphertext.setComponent(OpenABEMakeElementLabel("E", attr_key), &Ei);
+      } else {
+        G1 Ci = (*cpSetup->g1a * it->second.element()) + row.hashNeg;
+        ciphertext.setComponent(OpenABEMakeElementLabel("C", attr_key), &Ci);
+      }
     }
 
     // Hash C to obtain the symmetric key result.
-    key->hashToSymmetricKey(C, keyByteLen);
+    key->hashToSymmetricKey(session.C, keyByteLen);
     ciphertext.setSchemeType(this->algID);
 
     result = OpenABE_NOERROR;
@@ -305,13 +496,13 @@ OpenABEContextCPWaters::decryptKEM(const string &mpkID, const string &keyID,
                                OpenABECiphertext& ciphertext, uint32_t keyByteLen,
                                const std::shared_ptr<OpenABESymKey> &key) {
   OpenABE_ERROR result = OpenABE_ERROR_UNKNOWN;
-  ZP coeff;
   G1 prod1;
   G1 *Kx, *Cx;
   G2 *Dx;
   GT prodT;
 
   try {
+    OpenABE_initializeThreadContext();
     ASSERT_NOTNULL(key);
     // Load the given decryption key
     shared_ptr<OpenABEKey> decKey = this->getKeystore()->getSecretKey(keyID);
@@ -322,14 +513,13 @@ OpenABEContextCPWaters::decryptKEM(const string &mpkID, const string &keyID,
     OpenABEByteString *policy_str = ciphertext.getByteString("policy");
     ASSERT_NOTNULL(policy_str);
 
-    unique_ptr<OpenABEPolicy> policy = createPolicyTree(policy_str->toString());
-
-    // Initialize an LSSS structure. Given an attribute list and policy
-    // it will identify the necessary solution and return the appropriate
-    // components of the access/policy and secret key along with coefficients.
-    // If the policy is not satisfied, it throws an error.
-    OpenABELSSS lsss;
-    if (!lsss.recoverCoefficients(policy.get(), attrList)) {
+    // Given an attribute list and policy, identify the rows needed to
+    // recover the secret along with their coefficients. They only depend on
+    // the policy and the attribute set, so they come from the
+    // reconstruction cache when this pair was seen before.
+    shared_ptr<const OpenABELSSSRowMap> coefficients =
+        OpenABE_recoverCoefficients(policy_str->toString(), attrList);
+    if (coefficients == nullptr) {
       // Policy not satisfied, could not recover LSSS coefficients.
       throw OpenABE_ERROR_DECRYPTION_FAILED;
     }
@@ -337,26 +527,45 @@ OpenABEContextCPWaters::decryptKEM(const string &mpkID, const string &keyID,
     // Compute prod1  = prod_{attr_i \in S} C[attr_i]^{coefficient[attr_i]}
     //         prodT = prod_{attr_i \in S} e(KX[attr_i]^{coefficient[attr_i]},
     //         D[attr_i])
-    vector<G1> g1s;
-    vector<G2> g2s;
+    vector<OpenABEDecryptionRow> rows;
     string attr_key, attr_deckey;
-    OpenABELSSSRowMap lsssRows = lsss.getRows();
+    const OpenABELSSSRowMap &lsssRows = *coefficients;
+    // sum of coefficient * E[i] over the rows that carry a correction
+    ZP correction = this->getPairing()->initZP();
+    bool corrected = false;
 
     for (auto it = lsssRows.begin(); it != lsssRows.end(); ++it) {
-      coeff = it->second.element();
       attr_key = OpenABEHashKey(it->first);
       attr_deckey = OpenABEHashKey(it->second.label());
       Kx = decKey->getG1(OpenABEMakeElementLabel("KX", attr_deckey));
+      ASSERT_NOTNULL(Kx);
       Cx = ciphertext.getG1(OpenABEMakeElementLabel("C", attr_key));
       ASSERT_NOTNULL(Cx);
       Dx = ciphertext.getG2(OpenABEMakeElementLabel("D", attr_key));
       ASSERT_NOTNULL(Dx);
-      prod1 += (*Cx * coeff);
-      g1s.push_back(*Kx * coeff);
-      g2s.push_back(*Dx);
+      rows.push_back({it->second.element(), Cx, Kx, Dx});
+
+      string e_key = OpenABEMakeElementLabel("E", attr_key);
+      if (ciphertext.hasComponent(e_key)) {
+        OpenABEByteString *Ex = ciphertext.getByteString(e_key);
+        ASSERT_NOTNULL(Ex);
+        if (Ex->size() > 0) {
+          ZP delta(Ex->getInternalPtr(), Ex->size(), this->getPairing()->order);
+          correction = correction + (it->second.element() * delta);
+          corrected = true;
+        }
+      }
     }
 
-    this->getPairing()->multi_pairing(prodT, g1s, g2s);
+    this->evaluateDecryptionRows(rows, prod1, prodT);
+    if (corrected) {
+      // C[i] was built from g1a^{l}: add back g1a^{sum(coefficient * (share - l))}
+      shared_ptr<OpenABEKey> MPK = this->getKeystore()->getPublicKey(mpkID);
+      ASSERT_NOTNULL(MPK);
+      G1 *g1a = MPK->getG1("g1a");
+      ASSERT_NOTNULL(g1a);
+      prod1 = prod1 + (*g1a * correction);
+    }
     G1 *Cprime = ciphertext.getG1("Cprime");
     G2 *K = decKey->getG2("K");
     G2 *L = decKey->getG2("L");
@@ -376,3 +585,126 @@ OpenABEContextCPWaters::decryptKEM(const string &mpkID, const string &keyID,
   return result;
 }
 
+
+/*!
+ * Build and start a precompute pool for an MPK.
+ *
+ * @param   The master public key.
+ * @param   Depth and refill rate of the pool.
+ * @return  The running pool. Throws an OpenABE_ERROR on failure.
+ */
+
+shared_ptr<OpenABEPrecomputePool>
+OpenABEContextCPWaters::createPrecomputePool(const shared_ptr<OpenABEKey> &MPK,
+                                             const OpenABEPrecomputeSettings &settings) {
+  GT *A = MPK->getGT("A");
+  ASSERT_NOTNULL(A);
+  shared_ptr<OpenABEPrecomputePool> pool = make_shared<OpenABEPrecomputePool>(
+      *A, MPK->getG1FixedBase("g1"), MPK->getG1FixedBase("g1a"),
+      MPK->getG2FixedBase("g2"), this->getPairing()->order, settings);
+  pool->start();
+  return pool;
+}
+
+/*!
+ * Start online/offline encryption for an MPK: a background thread keeps a
+ * pool of precomputed randomness filled, and encryptKEM takes from it.
+ * Enabling it again replaces the pool. If the MPK under this identifier
+ * is later replaced (generateParams, loadMasterPublicParams), the pool is
+ * rebuilt for the new key with the same settings on its next use.
+ *
+ * @param   Parameters ID for the public master parameters.
+ * @param   Depth and refill rate of the pool.
+ * @return  An error code or OpenABE_NOERROR.
+ */
+
+OpenABE_ERROR
+OpenABEContextCPWaters::enablePrecomputation(const string &mpkID,
+                                             const OpenABEPrecomputeSettings &settings) {
+  OpenABE_ERROR result = OpenABE_NOERROR;
+
+  try {
+    shared_ptr<OpenABEKey> MPK = this->getKeystore()->getPublicKey(mpkID);
+    if (MPK == nullptr) {
+      throw OpenABE_ERROR_INVALID_PARAMS;
+    }
+    shared_ptr<OpenABEPrecomputePool> pool = this->createPrecomputePool(MPK, settings);
+
+    shared_ptr<OpenABEPrecomputePool> old;
+    {
+      lock_guard<mutex> guard(this->poolLock);
+      PrecomputeEntry &entry = this->pools[mpkID];
+      old = entry.pool;
+      entry.mpk = MPK;
+      entry.settings = settings;
+      entry.pool = pool;
+    }
+    if (old != nullptr) {
+      old->stop();
+    }
+  } catch (OpenABE_ERROR &err) {
+    result = err;
+  }
+
+  return result;
+}
+
+/*!
+ * Stop online/offline encryption for an MPK and drop its pool.
+ *
+ * @param   Parameters ID for the public master parameters.
+ * @return  An error code or OpenABE_NOERROR.
+ */
+
+OpenABE_ERROR
+OpenABEContextCPWaters::disablePrecomputation(const string &mpkID) {
+  shared_ptr<OpenABEPrecomputePool> pool;
+  {
+    lock_guard<mutex> guard(this->poolLock);
+    auto it = this->pools.find(mpkID);
+    if (it == this->pools.end()) {
+      return OpenABE_ERROR_INVALID_PARAMS;
+    }
+    pool = it->second.pool;
+    this->pools.erase(it);
+  }
+  pool->stop();
+  return OpenABE_NOERROR;
+}
+
+/*!
+ * Return the precompute pool of an MPK, e.g. to read its counters. The
+ * values in a pool belong to the MPK object it was built from: if the key
+ * under this identifier has been replaced since, the pool is rebuilt for
+ * the current key (or dropped if the key was deleted).
+ *
+ * @param   Parameters ID for the public master parameters.
+ * @return  The pool, or nullptr if precomputation is not enabled.
+ */
+
+shared_ptr<OpenABEPrecomputePool>
+OpenABEContextCPWaters::getPrecomputePool(const string &mpkID) {
+  shared_ptr<OpenABEKey> MPK = this->getKeystore()->getPublicKey(mpkID);
+  shared_ptr<OpenABEPrecomputePool> pool, old;
+  {
+    lock_guard<mutex> guard(this->poolLock);
+    auto it = this->pools.find(mpkID);
+    if (it == this->pools.end()) {
+      return nullptr;
+    }
+    PrecomputeEntry &entry = it->second;
+    if (MPK != nullptr && entry.mpk.lock() == MPK) {
+      return entry.pool;
+    }
+    old = entry.pool;
+    if (MPK == nullptr) {
+      this->pools.erase(it);
+    } else {
+      pool = this->createPrecomputePool(MPK, entry.settings);
+      entry.mpk = MPK;
+      entry.pool = pool;
+    }
+  }
+  old->stop();
+  return pool;
+}
@@ -55,11 +55,42 @@ public:
                                   const std::string &mpkID, const std::string &mskID,
                                   const std::string &gpkID, const std::string &GID);
 
+  std::unique_ptr<OpenABEKeygenSetup> prepareKeygen(const std::string &mpkID, const std::string &mskID);
+
+  OpenABE_ERROR generateDecryptionKeyPrepared(OpenABEKeygenSetup *setup, OpenABEFunctionInput* keyInput,
+                                  const std::string &keyID, std::shared_ptr<OpenABEKey>& decKey,
+                                  unsigned int numThreads);
+
   OpenABE_ERROR encryptKEM(const std::string &mpkID, const OpenABEFunctionInput* encryptInput,
                        uint32_t keyByteLen, const std::shared_ptr<OpenABESymKey>& key, OpenABECiphertext& ciphertext);
 
+  std::unique_ptr<OpenABEEncryptionSetup> prepareEncryption(const std::string &mpkID,
+                       const OpenABEFunctionInput* encryptInput);
+
+  OpenABE_ERROR encryptKEMPrepared(const OpenABEEncryptionSetup *setup, uint32_t keyByteLen,
+                       const std::shared_ptr<OpenABESymKey>& key, OpenABECiphertext& ciphertext);
+
   OpenABE_ERROR decryptKEM(const std::string &mpkID, const std::string &keyID, OpenABECiphertext& ciphertext,
                        uint32_t keyByteLen, const std::shared_ptr<OpenABESymKey>& key);
+
+  OpenABE_ERROR enablePrecomputation(const std::string &mpkID, const OpenABEPrecomputeSettings &settings);
+  OpenABE_ERROR disablePrecomputation(const std::string &mpkID);
+  std::shared_ptr<OpenABEPrecomputePool> getPrecomputePool(const std::string &mpkID);
+
+private:
+  // a pool together with the MPK object it was built from, so that a pool
+  // for a replaced MPK is detected and rebuilt
+  struct PrecomputeEntry {
+    std::weak_ptr<OpenABEKey> mpk;
+    OpenABEPrecomputeSettings settings;
+    std::shared_ptr<OpenABEPrecomputePool> pool;
+  };
+
+  std::shared_ptr<OpenABEPrecomputePool> createPrecomputePool(const std::shared_ptr<OpenABEKey> &MPK,
+                                                              const OpenABEPrecomputeSettings &settings);
+
+  std::mutex poolLock;
+  std::map<std::string, PrecomputeEntry> pools;
 };
 
 
@@ -83,6 +83,7 @@ OpenABEContextKPGPSW::generateParams(const string &mpkID, const string &mskID) {
   OpenABEByteString k;
 
   try {
+    OpenABE_initializeThreadContext();
     // Instantiate a OpenABE pairing object with the given parameters
     this->initializeCurve();
 
@@ -111,6 +112,7 @@ OpenABEContextKPGPSW::generateParams(const string &mpkID, const string &mskID) {
     MPK->setComponent("g2", &g2);
     MPK->setComponent("Y", &Y);
     MPK->setComponent("k", &k);
+    MPK->precomputeGTFixedBase();
     // MSK = {y}
     MSK->setComponent("y", &y);
 
@@ -143,25 +145,97 @@ OpenABEContextKPGPSW::generateDecryptionKey(
     const string &mskID, const string &gpkID = "", const string &GID = "") {
   OpenABE_ERROR result = OpenABE_NOERROR;
   shared_ptr<OpenABEKey> decKey = nullptr;
+
+  try {
+    OpenABE_initializeThreadContext();
+    unique_ptr<OpenABEKeygenSetup> setup = this->prepareKeygen(mpkID, mskID);
+    result = this->generateDecryptionKeyPrepared(setup.get(), keyInput, keyID, decKey, 1);
+    ASSERT(result == OpenABE_NOERROR, result);
+
+    // Add the decryption key to the keystore
+    this->getKeystore()->addKey(keyID, decKey, KEY_TYPE_SECRET);
+  } catch (OpenABE_ERROR &err) {
+    result = err;
+  }
+
+  return result;
+}
+
+///
+/// @class  OpenABEKPGPSWKeygenSetup
+///
+/// @brief  Key-independent part of a KP-GPSW key generation.
+///
+
+class OpenABEKPGPSWKeygenSetup : public OpenABEKeygenSetup {
+public:
+  using OpenABEKeygenSetup::OpenABEKeygenSetup;
+  shared_ptr<G1FixedBase> g1;
+  shared_ptr<G2FixedBase> g2;
+  ZP y;
+};
+
+/*!
+ * Load the master keys and the fixed-base tables of the MPK generators,
+ * which every key of a batch shares.
+ *
+ * @param   Parameters ID for the public master parameters.
+ * @param   Parameters ID for the master secret parameters.
+ * @return  The key generation setup. Throws an OpenABE_ERROR on failure.
+ */
+
+unique_ptr<OpenABEKeygenSetup>
+OpenABEContextKPGPSW::prepareKeygen(const string &mpkID, const string &mskID) {
+  // Load the master secret and public key
+  shared_ptr<OpenABEKey> MPK = this->getKeystore()->getPublicKey(mpkID);
+  shared_ptr<OpenABEKey> MSK = this->getKeystore()->getSecretKey(mskID);
+  if (MPK == nullptr || MSK == nullptr) {
+    throw OpenABE_ERROR_INVALID_PARAMS;
+  }
+  // retrieve the hash function key prefix
+  OpenABEByteString *k = MPK->getByteString("k");
+  ASSERT_NOTNULL(k);
+
+  unique_ptr<OpenABEKPGPSWKeygenSetup> setup(
+      new OpenABEKPGPSWKeygenSetup(this->getPairing(), *k));
+  // fixed-base tables for the MPK generators (built on first use)
+  setup->g1 = MPK->getG1FixedBase("g1");
+  setup->g2 = MPK->getG2FixedBase("g2");
+  setup->y = *MSK->getZP("y");
+
+  return unique_ptr<OpenABEKeygenSetup>(setup.release());
+}
+
+/*!
+ * Generate a decryption key for a policy using a prepared setup. The key
+ * is returned and not added to the keystore. With more than one thread,
+ * the rows of a large policy are computed in parallel.
+ *
+ * @param   Key generation setup returned by prepareKeygen.
+ * @param   The policy.
+ * @param   Identifier of the key.
+ * @param   The generated key.
+ * @param   Number of threads (0 for automatic).
+ * @return  An error code or OpenABE_NOERROR.
+ */
+
+OpenABE_ERROR
+OpenABEContextKPGPSW::generateDecryptionKeyPrepared(OpenABEKeygenSetup *keygenSetup,
+                                  OpenABEFunctionInput *keyInput, const string &keyID,
+                                  shared_ptr<OpenABEKey>& decKey, unsigned int numThreads) {
+  OpenABE_ERROR result = OpenABE_NOERROR;
   OpenABEPolicy *policy = nullptr;
-  OpenABEByteString *k = nullptr;
 
   try {
+    OpenABE_initializeThreadContext();
+    OpenABEKPGPSWKeygenSetup *setup = dynamic_cast<OpenABEKPGPSWKeygenSetup *>(keygenSetup);
+    ASSERT_NOTNULL(setup);
     // Ensure that the given input is a OpenABEPolicy
     if ((policy = dynamic_cast<OpenABEPolicy *>(keyInput)) == nullptr) {
       OpenABE_LOG_AND_THROW("Encryption input must be a Policy",
                         OpenABE_ERROR_INVALID_INPUT);
     }
 
-    // Load the master secret and public key
-    shared_ptr<OpenABEKey> MPK = this->getKeystore()->getPublicKey(mpkID);
-    shared_ptr<OpenABEKey> MSK = this->getKeystore()->getSecretKey(mskID);
-    if (MPK == nullptr || MSK == nullptr) {
-      throw OpenABE_ERROR_INVALID_PARAMS;
-    }
-    // retrieve the hash function key prefix
-    k = MPK->getByteString("k");
-
     // Create a new OpenABEKey object for the decryption key
     decKey.reset(new OpenABEKey(this->algID, keyID));
 
@@ -169,31 +243,35 @@ OpenABEContextKPGPSW::generateDecryptionKey(
     OpenABEByteString pol;
     pol = policy->toCompactString();
     decKey->setComponent("input", &pol);
-    ZP y = *(MSK->getZP("y"));
 
     OpenABELSSS lsss;
     // Share the secret y over the policy tree
-    lsss.shareSecret(policy, y);
+    lsss.shareSecret(policy, setup->y);
 
     // For each element/share of the policy tree
-    string attr_deckey;
-    OpenABELSSSRowMap lsssRows = lsss.getRows();
+    OpenABELSSSRowMap& lsssRows = lsss.getRows();
+    vector<const OpenABELSSSRowMap::value_type *> rows;
     for (auto it = lsssRows.begin(); it != lsssRows.end(); ++it) {
-      // Pick a random value ri in ZP
-      ZP ri = this->getPairing()->randomZP();
+      rows.push_back(&(*it));
+    }
+    // Pick a random value ri in ZP for every row
+    vector<ZP> r = this->getPairing()->randomZPs(rows.size());
+    vector<G1> D(rows.size());
+    vector<G2> d(rows.size());
+    this->parallelKeygenRows(rows.size(), numThreads, [&](size_t i) {
       // Di = g ^ \share(attr) * H(attr)^ri
-      G1 Di = (*MPK->getG1("g1") * it->second.element()) +
-              (this->getPairing()->hashToG1(*k, it->second.label()) * ri);
+      D[i] = (*setup->g1 * rows[i]->second.element()) +
+             (setup->hashAttribute(rows[i]->second.label()) * r[i]);
       // di = g ^ ri
-      G2 di = *MPK->getG2("g2") * ri;
-      attr_deckey = OpenABEHashKey(it->first);
-      decKey->setComponent(OpenABEMakeElementLabel("D", attr_deckey), &Di);
-      decKey->setComponent(OpenABEMakeElementLabel("d", attr_deckey), &di);
+      d[i] = *setup->g2 * r[i];
+    });
+    for (size_t i = 0; i < rows.size(); i++) {
+      string attr_deckey = OpenABEHashKey(rows[i]->first);
+      decKey->setComponent(OpenABEMakeElementLabel("D", attr_deckey), &D[i]);
+      decKey->setComponent(OpenABEMakeElementLabel("d", attr_deckey), &d[i]);
     }
-
-    // Add the decryption key to the keystore
-    this->getKeystore()->addKey(keyID, decKey, KEY_TYPE_SECRET);
   } catch (OpenABE_ERROR &err) {
+    decKey = nullptr;
     result = err;
   }
 
@@ -216,46 +294,120 @@ OpenABEContextKPGPSW::encryptKEM(const string &mpkID,
                                  const std::shared_ptr<OpenABESymKey> &key,
                                  OpenABECiphertext &ciphertext) {
   OpenABE_ERROR result = OpenABE_ERROR_ENCRYPTION_ERROR;
+
+  try {
+    OpenABE_initializeThreadContext();
+    ASSERT_NOTNULL(key);
+    unique_ptr<OpenABEEncryptionSetup> setup = this->prepareEncryption(mpkID, encryptInput);
+    result = this->encryptKEMPrepared(setup.get(), keyByteLen, key, ciphertext);
+  } catch (OpenABE_ERROR &err) {
+    result = err;
+  }
+
+  return result;
+}
+
+///
+/// @class  OpenABEKPGPSWEncryptionSetup
+///
+/// @brief  Attribute-dependent part of a KP-GPSW encryption.
+///
+
+class OpenABEKPGPSWEncryptionSetup : public OpenABEEncryptionSetup {
+public:
+  const OpenABEAttributeList *attrList;
+  GT Y;
+  shared_ptr<G2FixedBase> g2;
+  // (ciphertext label, hash_to_G1(attribute)) for every attribute
+  vector<pair<string, G1>> hashedAttributes;
+};
+
+/*!
+ * Compute the part of the encryption that only depends on the attribute
+ * list and the master public key: the fixed-base table of g2 and the hash
+ * of every attribute into G1.
+ *
+ * @param   Parameters ID for the public master parameters.
+ * @param   Function input for the encryption: OpenABEAttributeList
+ * @return  The encryption setup. Throws an OpenABE_ERROR on failure.
+ */
+
+unique_ptr<OpenABEEncryptionSetup>
+OpenABEContextKPGPSW::prepareEncryption(const string &mpkID,
+                                        const OpenABEFunctionInput *encryptInput) {
   shared_ptr<OpenABEKey> MPK = nullptr;
-  OpenABEByteString *k = nullptr;
+
+  // Ensure that the given input is a OpenABEAttributeList
+  const OpenABEAttributeList *attrList =
+      dynamic_cast<const OpenABEAttributeList *>(encryptInput);
+  if (attrList == nullptr) {
+    OpenABE_LOG_AND_THROW("Encryption input must be a Policy",
+                      OpenABE_ERROR_INVALID_INPUT);
+  }
+  // Load the master public key
+  if ((MPK = this->getKeystore()->getPublicKey(mpkID)) == nullptr) {
+    OpenABE_LOG_AND_THROW("Could not get master public params",
+                      OpenABE_ERROR_INVALID_PARAMS);
+  }
+  // Retrieve the hash function key prefix
+  OpenABEByteString *k = MPK->getByteString("k");
+  ASSERT_NOTNULL(k);
+
+  unique_ptr<OpenABEKPGPSWEncryptionSetup> setup(new OpenABEKPGPSWEncryptionSetup);
+  setup->attrList = attrList;
+  setup->Y = *MPK->getGT("Y");
+  setup->g2 = MPK->getG2FixedBase("g2");
+
+  const vector<string> *attrStrings = attrList->getAttributeList();
+  for (auto it = attrStrings->begin(); it != attrStrings->end(); ++it) {
+    setup->hashedAttributes.emplace_back(OpenABEMakeElementLabel("C", OpenABEHashKey(*it)),
+                                         this->getPairing()->hashToG1(*k, *it));
+  }
+
+  return unique_ptr<OpenABEEncryptionSetup>(setup.release());
+}
+
+/*!
+ * Generate and encrypt a symmetric key using a prepared attribute list.
+ * The setup is not modified, so several threads can encrypt with it.
+ *
+ * @param   Encryption setup returned by prepareEncryption.
+ * @param   Length of the symmetric key in bytes.
+ * @param   Symmetric key to be returned.
+ * @param   ABE ciphertext.
+ * @return  An error code or OpenABE_NOERROR.
+ */
+
+OpenABE_ERROR
+OpenABEContextKPGPSW::encryptKEMPrepared(const OpenABEEncryptionSetup *setup,
+                                         uint32_t keyByteLen,
+                                         const std::shared_ptr<OpenABESymKey> &key,
+                                         OpenABECiphertext &ciphertext) {
+  OpenABE_ERROR result = OpenABE_ERROR_ENCRYPTION_ERROR;
 
   try {
+    OpenABE_initializeThreadContext();
     ASSERT_NOTNULL(key);
+    const OpenABEKPGPSWEncryptionSetup *kpSetup =
+        dynamic_cast<const OpenABEKPGPSWEncryptionSetup *>(setup);
+    ASSERT_NOTNULL(kpSetup);
 
-    // Ensure that the given input is a OpenABEAttributeList
-    const OpenABEAttributeList *attrList =
-        dynamic_cast<const OpenABEAttributeList *>(encryptInput);
-    if (attrList == nullptr) {
-      OpenABE_LOG_AND_THROW("Encryption input must be a Policy",
-                        OpenABE_ERROR_INVALID_INPUT);
-    }
-    // Load the master public key
-    if ((MPK = this->getKeystore()->getPublicKey(mpkID)) == nullptr) {
-      OpenABE_LOG_AND_THROW("Could not get master public params",
-                        OpenABE_ERROR_INVALID_PARAMS);
-    }
-    // Retrieve the hash function key prefix
-    k = MPK->getByteString("k");
     // Choose random t \in ZP
     ZP t = this->getPairing()->randomZP();
     // Compute Y^t => e(g1, g2)^(y*t). Note: this is hashed into a key later due
     // to KEM
-    GT Cpr1 = MPK->getGT("Y")->exp(t);
+    GT Cpr1 = kpSetup->Y.exp(t);
     // Compute g2 ^ t
-    G2 Cpr2 = *MPK->getG2("g2") * t;
+    G2 Cpr2 = *kpSetup->g2 * t;
     ciphertext.setComponent("Cpr2", &Cpr2);
 
-    string attr, attr_key;
-    const vector<string> *attrStrings = attrList->getAttributeList();
-    for (auto it = attrStrings->begin(); it != attrStrings->end(); ++it) {
+    for (auto it = kpSetup->hashedAttributes.begin(); it != kpSetup->hashedAttributes.end(); ++it) {
       // For each attribute in input, compute H(attribute) ^ t
-      attr = *it;
-      G1 hG1 = this->getPairing()->hashToG1(*k, attr) * t;
-      attr_key = OpenABEHashKey(attr);
-      ciphertext.setComponent(OpenABEMakeElementLabel("C", attr_key), &hG1);
+      G1 hG1 = it->second * t;
+      ciphertext.setComponent(it->first, &hG1);
     }
     // Set the attribute list in the policy
-    ciphertext.setComponent("attributes", attrList);
+    ciphertext.setComponent("attributes", kpSetup->attrList);
 
     // Hash Cpr1 to obtain the encapsulation key.
     key->hashToSymmetricKey(Cpr1, keyByteLen);
@@ -288,6 +440,7 @@ OpenABEContextKPGPSW::decryptKEM(const string &mpkID, const string &keyID,
   OpenABE_ERROR result = OpenABE_ERROR_UNKNOWN;
 
   try {
+    OpenABE_initializeThreadContext();
     ASSERT_NOTNULL(key);
     // Load the given decryption key
     shared_ptr<OpenABEKey> decKey = this->getKeystore()->getSecretKey(keyID);
@@ -296,49 +449,45 @@ OpenABEContextKPGPSW::decryptKEM(const string &mpkID, const string &keyID,
     // Obtain the attribute list from the decryption key
     OpenABEByteString *policy_str = decKey->getByteString("input");
     ASSERT_NOTNULL(policy_str);
-    unique_ptr<OpenABEPolicy> policy = createPolicyTree(policy_str->toString());
 
     // Obtain the attribute list from the decryption key
     OpenABEAttributeList *attrList =
         (OpenABEAttributeList *)ciphertext.getComponent("attributes");
     ASSERT_NOTNULL(attrList);
 
-    // Initialize an LSSS structure. Given an attribute list and policy
-    // it will identify the necessary solution and return the appropriate
-    // components of the access/policy and secret key along with coefficients.
-    // If the policy is not satisfied, it throws an error.
-    OpenABELSSS lsss;
-    if (!lsss.recoverCoefficients(policy.get(), attrList)) {
+    // Given an attribute list and policy, identify the rows needed to
+    // recover the secret along with their coefficients (from the
+    // reconstruction cache when this pair was seen before).
+    shared_ptr<const OpenABELSSSRowMap> coefficients =
+        OpenABE_recoverCoefficients(policy_str->toString(), attrList);
+    if (coefficients == nullptr) {
       // Policy not satisfied, could not recover LSSS coefficients.
       throw OpenABE_ERROR_DECRYPTION_FAILED;
     }
 
-    ZP coeff;
     G1 prod1;
     G1 *Ci, *Di;
     G2 *di;
     GT prodT;
-    vector<G1> g1s;
-    vector<G2> g2s;
+    vector<OpenABEDecryptionRow> rows;
     // Get coefficients for satisfiable attributes
-    OpenABELSSSRowMap lsssRows = lsss.getRows();
+    const OpenABELSSSRowMap &lsssRows = *coefficients;
     string attr_key, attr_deckey;
     for (auto it = lsssRows.begin(); it != lsssRows.end(); ++it) {
-      coeff = it->second.element();
       attr_key = OpenABEHashKey(it->second.label());
       Ci = ciphertext.getG1(OpenABEMakeElementLabel("C", attr_key));
+      ASSERT_NOTNULL(Ci);
       attr_deckey = OpenABEHashKey(it->first);
 
       di = decKey->getG2(OpenABEMakeElementLabel("d", attr_deckey));
-      // prod1 => prod{i \in S} D_i ^ coeff_i
+      ASSERT_NOTNULL(di);
       Di = decKey->getG1(OpenABEMakeElementLabel("D", attr_deckey));
-      prod1 += (*Di * coeff);
+      ASSERT_NOTNULL(Di);
+      // prod1 => prod{i \in S} D_i ^ coeff_i
       // prodT => prod{i \in S} e(d_i, C_i)
-      g1s.push_back(*Ci *coeff);
-      g2s.push_back(*di);
+      rows.push_back({it->second.element(), Di, Ci, di});
     }
-    // prodT => prod{i \in S} e(d_i, C_i)
-    this->getPairing()->multi_pairing(prodT, g1s, g2s);
+    this->evaluateDecryptionRows(rows, prod1, prodT);
     G2 *Cpr2 = ciphertext.getG2("Cpr2");
     ASSERT_NOTNULL(Cpr2);
     GT A = this->getPairing()->pairing(prod1, *Cpr2) / prodT;
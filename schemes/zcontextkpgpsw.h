@@ -58,9 +58,21 @@ public:
                                   const std::string &mpkID, const std::string &mskID,
                                   const std::string &gpkID, const std::string &GID);
 
+  std::unique_ptr<OpenABEKeygenSetup> prepareKeygen(const std::string &mpkID, const std::string &mskID);
+
+  OpenABE_ERROR generateDecryptionKeyPrepared(OpenABEKeygenSetup *setup, OpenABEFunctionInput *keyInput,
+                                  const std::string &keyID, std::shared_ptr<OpenABEKey>& decKey,
+                                  unsigned int numThreads);
+
   OpenABE_ERROR encryptKEM(const std::string &mpkID, const OpenABEFunctionInput *encryptInput,
                        uint32_t keyByteLen, const std::shared_ptr<OpenABESymKey>& key, OpenABECiphertext &ciphertext);
 
+  std::unique_ptr<OpenABEEncryptionSetup> prepareEncryption(const std::string &mpkID,
+                       const OpenABEFunctionInput *encryptInput);
+
+  OpenABE_ERROR encryptKEMPrepared(const OpenABEEncryptionSetup *setup, uint32_t keyByteLen,
+                       const std::shared_ptr<OpenABESymKey>& key, OpenABECiphertext &ciphertext);
+
   OpenABE_ERROR decryptKEM(const std::string &mpkID, const std::string &keyID, OpenABECiphertext &ciphertext,
                        uint32_t keyByteLen, const std::shared_ptr<OpenABESymKey>& key);
 };
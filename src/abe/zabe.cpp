@@ -35,7 +35,9 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <atomic>
 #include <iostream>
+#include <mutex>
 #include <string>
 
 #include <abe_lsss.h>
@@ -48,7 +50,9 @@ using namespace std;
  ********************************************************************************/
 
 // flag for the library initialization state
-OpenABE_STATE gLibraryState = OpenABE_STATE_UNINITIALIZED;
+static atomic<OpenABE_STATE> gLibraryState(OpenABE_STATE_UNINITIALIZED);
+// serializes library initialization and shutdown
+static mutex gLibraryLock;
 
 
 /********************************************************************************
@@ -66,12 +70,17 @@ static OpenABE_ERROR
 OpenABE_initialize() {
   OpenABE_ERROR result = OpenABE_ERROR_LIBRARY_NOT_INITIALIZED;
 
+  lock_guard<mutex> guard(gLibraryLock);
   // If the library is in a pre-initialized state, we can initialize it and go.
   // Otherwise return an error.
-  if (gLibraryState == OpenABE_STATE_UNINITIALIZED) {
+  if (gLibraryState.load() == OpenABE_STATE_UNINITIALIZED) {
 
     // Initialize the pairing library
     result = zMathInitLibrary();
+    if (result != OpenABE_NOERROR) {
+      return result;
+    }
+    OpenABE_setMainThreadContext(true);
   
     // Set the error file to stderr.
     // gErrorLog = new zErrorLog();
@@ -96,9 +105,18 @@ OpenABE_initialize() {
 static OpenABE_ERROR
 OpenABE_shutdown() {
   OpenABE_ERROR result = OpenABE_NOERROR;
+  lock_guard<mutex> guard(gLibraryLock);
+
+  // Stop the worker threads and release cached group elements before
+  // RELIC goes away
+  OpenABEWorkerPool::getInstance().shutdown();
+  OpenABECompiledPolicyCache::getInstance().clear();
+  OpenABEReconstructionCache::getInstance().clear();
+  OpenABEHashToG1Cache::getInstance().clear();
 
   // Shut down the pairing library
   result = zMathShutdownLibrary();
+  OpenABE_setMainThreadContext(false);
 
   gLibraryState = OpenABE_STATE_UNINITIALIZED;
 
@@ -106,9 +124,12 @@ OpenABE_shutdown() {
 }
 
 void AssertLibInit() {
-  if (gLibraryState == OpenABE_STATE_UNINITIALIZED) {
+  if (gLibraryState.load() == OpenABE_STATE_UNINITIALIZED) {
     throw runtime_error(OpenABE_errorToString(OpenABE_ERROR_LIBRARY_NOT_INITIALIZED));
   }
+  // threads other than the one that initialized the library get their
+  // own RELIC context on first use
+  OpenABE_initializeThreadContext();
 }
 
 /*!
@@ -139,15 +160,18 @@ void ShutdownOpenABE() {
 
 void OpenABEStateContext::initializeThread() {
   if (!isInitialized_) {
-    // Initialize the pairing library
-    zMathInitLibrary();
+    // Set up the RELIC context of this thread (no-op if it has one)
+    ownsContext_ = OpenABE_initializeThreadContext();
   }
 }
 
 void OpenABEStateContext::shutdownThread() {
   if (isInitialized_) {
-    // check whether we have called init already
-    zMathInitLibrary();
+    // only release a context that initializeThread() created
+    if (ownsContext_) {
+      OpenABE_shutdownThreadContext();
+      ownsContext_ = false;
+    }
     // reset the initialization state
     isInitialized_ = false;
   }
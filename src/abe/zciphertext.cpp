@@ -56,6 +56,7 @@ OpenABECiphertext::OpenABECiphertext() : OpenABEContainer() {
   this->libraryVersion = OpenABE_LIBRARY_VERSION;
   this->uid.fillBuffer(0, UID_LEN);
   this->uid_set_extern = false;
+  this->lazyDecoding = true;
 }
 
 OpenABECiphertext::OpenABECiphertext(std::shared_ptr<BPGroup> group)
@@ -64,6 +65,7 @@ OpenABECiphertext::OpenABECiphertext(std::shared_ptr<BPGroup> group)
   this->libraryVersion = OpenABE_LIBRARY_VERSION;
   this->uid.fillBuffer(0, UID_LEN);
   this->uid_set_extern = false;
+  this->lazyDecoding = true;
 }
 
 OpenABECiphertext::OpenABECiphertext(const OpenABEByteString &uid) : OpenABEContainer() {
@@ -77,6 +79,7 @@ OpenABECiphertext::OpenABECiphertext(const OpenABEByteString &uid) : OpenABECont
     this->uid.fillBuffer(0, UID_LEN);
     this->uid_set_extern = false;
   }
+  this->lazyDecoding = true;
 }
 
 /*!
@@ -115,6 +118,10 @@ void OpenABECiphertext::exportToBytes(OpenABEByteString &output) {
  *
  */
 void OpenABECiphertext::loadFromBytes(OpenABEByteString &input) {
+  if (OpenABEFlatCiphertextReader::isFlatFormat(input)) {
+    this->loadFromFlatBytes(input);
+    return;
+  }
   size_t hdrLen = UID_LEN + 2*sizeof(uint8_t); // 1 byte for library version, 1 byte for algorithm ID
   if (input.size() < hdrLen) {
     cerr << "------> Invalid input size for OpenABECiphertext " << input.size() << endl;
@@ -151,6 +158,37 @@ void OpenABECiphertext::loadFromBytes(OpenABEByteString &input) {
   }
 }
 
+/*!
+ * Export routine for the OpenABECiphertext class in the flat layout.
+ *
+ */
+void OpenABECiphertext::exportToFlatBytes(OpenABEByteString &output) {
+  this->decodeAllComponents();
+  OpenABE_exportFlatContainer(this->libraryVersion, this->algorithmID,
+                              this->uid, this->val, output);
+}
+
+/*!
+ * Import routine for the OpenABECiphertext class in the flat layout.
+ *
+ */
+void OpenABECiphertext::loadFromFlatBytes(span<const uint8_t> input) {
+  // one copy of the blob, shared by all components and by copies of this ciphertext
+  shared_ptr<OpenABEByteString> buffer = make_shared<OpenABEByteString>();
+  buffer->appendArray(const_cast<uint8_t*>(input.data()), input.size());
+  OpenABEFlatCiphertextReader reader(*buffer);
+  this->libraryVersion = reader.getLibraryVersion();
+  this->algorithmID = OpenABE_getSchemeID(reader.getAlgorithmID());
+  this->uid.clear();
+  this->uid.appendArray(const_cast<uint8_t*>(reader.getUID().data()), UID_LEN);
+
+  for (size_t i = 0; i < reader.numComponents(); i++) {
+    // components point into the copy and are decoded from it on first access
+    this->replaceComponent(string(reader.getName(i)),
+                           new OpenABEFlatElement(reader.getType(i), reader.getData(i), buffer));
+  }
+}
+
 /*!
  * Export routine for the OpenABECiphertext class (sames as before but without header).
  *
@@ -0,0 +1,427 @@
+/// 
+/// Copyright (c) 2018 Zeutro, LLC. All rights reserved.
+/// 
+/// This file is part of Zeutro's OpenABE.
+/// 
+/// OpenABE is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU Affero General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+/// 
+/// OpenABE is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU Affero General Public License for more details.
+/// 
+/// You should have received a copy of the GNU Affero General Public
+/// License along with OpenABE. If not, see <http://www.gnu.org/licenses/>.
+/// 
+/// You can be released from the requirements of the GNU Affero General
+/// Public License and obtain additional features by purchasing a
+/// commercial license. Buying such a license is mandatory if you
+/// engage in commercial activities involving OpenABE that do not
+/// comply with the open source requirements of the GNU Affero General
+/// Public License. For more information on commerical licenses,
+/// visit <http://www.zeutro.com>.
+///
+///
+/// \file   zcompiledpolicy.cpp
+///
+/// \brief  Implementation of compiled policies and the compiled policy cache.
+///
+
+#include <iostream>
+#include <string>
+
+#include <abe_lsss.h>
+
+using namespace std;
+
+/********************************************************************************
+ * Implementation of the OpenABECompiledPolicy class
+ ********************************************************************************/
+
+/*!
+ * Constructor for the OpenABECompiledPolicy class. Copies the policy tree
+ * and compiles its share-generating matrix once.
+ *
+ * @param[in]   the parsed policy.
+ */
+OpenABECompiledPolicy::OpenABECompiledPolicy(const OpenABEPolicy &policy)
+    : OpenABEPolicy(policy) {
+  this->m_PolicyBytes = this->toCompactString();
+  this->m_Matrix = make_shared<const OpenABELSSSMatrix>(this);
+}
+
+/*!
+ * Destructor for the OpenABECompiledPolicy class.
+ *
+ */
+OpenABECompiledPolicy::~OpenABECompiledPolicy() {}
+
+/*!
+ * Return a private copy of the policy tree. Coefficient recovery marks
+ * the nodes of the tree it runs on, so decryption must not use the
+ * shared tree directly.
+ *
+ * @return      a copy of the policy.
+ */
+unique_ptr<OpenABEPolicy>
+OpenABECompiledPolicy::copyPolicyTree() const {
+  return unique_ptr<OpenABEPolicy>(new OpenABEPolicy(*this));
+}
+
+/*!
+ * Return the hash_to_G1 points of the policy attributes for the given
+ * MPK hash key. They are computed on the first call for each key.
+ *
+ * @param[in]   the pairing used to hash.
+ * @param[in]   the hash key ("k") of the master public key.
+ * @return      the points keyed by attribute label.
+ */
+shared_ptr<const OpenABEHashedAttributes>
+OpenABECompiledPolicy::getHashedAttributes(OpenABEPairing *pairing, OpenABEByteString &hashKey) const {
+  ASSERT_NOTNULL(pairing);
+  lock_guard<mutex> lock(this->m_Lock);
+
+  string key = hashKey.toString();
+  auto it = this->m_HashedAttributes.find(key);
+  if (it != this->m_HashedAttributes.end()) {
+    return it->second;
+  }
+
+  shared_ptr<const OpenABEHashedAttributes> points =
+      OpenABE_hashPolicyAttributes(pairing, hashKey, this->getRows());
+  this->m_HashedAttributes[key] = points;
+  return points;
+}
+
+/********************************************************************************
+ * Implementation of the OpenABECompiledPolicyCache class
+ ********************************************************************************/
+
+/*!
+ * Constructor for the OpenABECompiledPolicyCache class.
+ *
+ */
+OpenABECompiledPolicyCache::OpenABECompiledPolicyCache()
+    : m_Capacity(DEFAULT_COMPILED_POLICY_CACHE_SIZE) {}
+
+/*!
+ * Return the process-wide compiled policy cache.
+ *
+ */
+OpenABECompiledPolicyCache&
+OpenABECompiledPolicyCache::getInstance() {
+  static OpenABECompiledPolicyCache instance;
+  return instance;
+}
+
+/*!
+ * Look up the compiled form of a policy, parsing and compiling it on a
+ * miss. The least recently used policy is evicted when the cache is full.
+ *
+ * @param[in]   the policy string.
+ * @return      the compiled policy, or nullptr if the policy does not parse.
+ */
+shared_ptr<const OpenABECompiledPolicy>
+OpenABECompiledPolicyCache::get(const string &policyStr) {
+  {
+    lock_guard<mutex> lock(this->m_Lock);
+    auto it = this->m_Index.find(policyStr);
+    if (it != this->m_Index.end()) {
+      this->m_Entries.splice(this->m_Entries.begin(), this->m_Entries, it->second);
+      return it->second->second;
+    }
+  }
+
+  // parse outside of the lock so that misses do not block lookups
+  unique_ptr<OpenABEPolicy> policy = createPolicyTree(policyStr);
+  if (policy == nullptr) {
+    return nullptr;
+  }
+  shared_ptr<const OpenABECompiledPolicy> compiled =
+      make_shared<const OpenABECompiledPolicy>(*policy);
+
+  lock_guard<mutex> lock(this->m_Lock);
+  auto it = this->m_Index.find(policyStr);
+  if (it != this->m_Index.end()) {
+    // another thread compiled it in the meantime
+    this->m_Entries.splice(this->m_Entries.begin(), this->m_Entries, it->second);
+    return it->second->second;
+  }
+  if (this->m_Capacity == 0) {
+    return compiled;
+  }
+  this->m_Entries.emplace_front(policyStr, compiled);
+  this->m_Index[policyStr] = this->m_Entries.begin();
+  this->evict();
+  return compiled;
+}
+
+/*!
+ * Set the maximum number of policies kept (0 disables caching).
+ *
+ * @param[in]   the new capacity.
+ */
+void
+OpenABECompiledPolicyCache::setCapacity(size_t capacity) {
+  lock_guard<mutex> lock(this->m_Lock);
+  this->m_Capacity = capacity;
+  this->evict();
+}
+
+/*!
+ * Drop the least recently used policies until the cache fits its
+ * capacity. The caller must hold the cache lock.
+ *
+ */
+void
+OpenABECompiledPolicyCache::evict() {
+  while (this->m_Entries.size() > this->m_Capacity) {
+    this->m_Index.erase(this->m_Entries.back().first);
+    this->m_Entries.pop_back();
+  }
+}
+
+size_t
+OpenABECompiledPolicyCache::size() {
+  lock_guard<mutex> lock(this->m_Lock);
+  return this->m_Entries.size();
+}
+
+void
+OpenABECompiledPolicyCache::clear() {
+  lock_guard<mutex> lock(this->m_Lock);
+  this->m_Index.clear();
+  this->m_Entries.clear();
+}
+
+/********************************************************************************
+ * Implementation of the OpenABEReconstructionCache class
+ ********************************************************************************/
+
+/*!
+ * Constructor for the OpenABEReconstructionCache class.
+ *
+ */
+OpenABEReconstructionCache::OpenABEReconstructionCache()
+    : m_MaxBytes(DEFAULT_RECONSTRUCTION_CACHE_BYTES), m_Bytes(0),
+      m_Hits(0), m_Misses(0), m_Evictions(0) {}
+
+/*!
+ * Return the process-wide reconstruction coefficient cache.
+ *
+ */
+OpenABEReconstructionCache&
+OpenABEReconstructionCache::getInstance() {
+  static OpenABEReconstructionCache instance;
+  return instance;
+}
+
+/*!
+ * Fingerprint a (policy, attribute set) pair: SHA-256 of the policy string
+ * followed by SHA-256 of the sorted attribute IDs. The IDs are what
+ * coefficient recovery matches leaves against, so lists holding the same
+ * attributes in any order get the same key.
+ *
+ * @param[in]   the policy string.
+ * @param[in]   the attribute list.
+ * @return      the cache key (64 bytes).
+ */
+string
+OpenABEReconstructionCache::makeKey(const string &policyStr, const OpenABEAttributeList &attrList) {
+  OpenABEByteString policyBytes, attrBytes, policyHash, attrHash;
+  policyBytes = policyStr;
+  policyBytes.hashToBytes(policyHash);
+
+  const vector<uint32_t> &ids = attrList.getAttributeIds();
+  attrBytes.appendArray((uint8_t *) ids.data(), ids.size() * sizeof(uint32_t));
+  attrBytes.hashToBytes(attrHash);
+
+  return policyHash.toString() + attrHash.toString();
+}
+
+/*!
+ * Approximate memory used by one entry: the key, the map nodes with their
+ * labels and elements, and the list/index bookkeeping.
+ *
+ * @param[in]   the cache key.
+ * @param[in]   the coefficients.
+ * @return      size in bytes.
+ */
+size_t
+OpenABEReconstructionCache::entrySize(const string &key, const OpenABELSSSRowMap &coefficients) {
+  size_t size = 2 * key.size() + sizeof(Entry) + sizeof(OpenABELSSSRowMap) + 4 * sizeof(void *);
+  for (auto& row : coefficients) {
+    size += sizeof(OpenABELSSSRowMap::value_type) + 4 * sizeof(void *) +
+            row.first.size() + row.second.label().size() + row.second.prefix().size();
+  }
+  return size;
+}
+
+/*!
+ * Look up the coefficients of a (policy, attribute set) pair and mark
+ * them as recently used.
+ *
+ * @param[in]   the cache key from makeKey().
+ * @return      the coefficients keyed by unique row label, or nullptr on a miss.
+ */
+shared_ptr<const OpenABELSSSRowMap>
+OpenABEReconstructionCache::lookup(const string &key) {
+  lock_guard<mutex> lock(this->m_Lock);
+  auto it = this->m_Index.find(key);
+  if (it == this->m_Index.end()) {
+    this->m_Misses++;
+    return nullptr;
+  }
+  this->m_Entries.splice(this->m_Entries.begin(), this->m_Entries, it->second);
+  this->m_Hits++;
+  return it->second->coefficients;
+}
+
+/*!
+ * Add the coefficients of a (policy, attribute set) pair, evicting the
+ * least recently used entries if the byte budget is exceeded.
+ *
+ * @param[in]   the cache key from makeKey().
+ * @param[in]   the coefficients keyed by unique row label.
+ */
+void
+OpenABEReconstructionCache::insert(const string &key,
+                                   const shared_ptr<const OpenABELSSSRowMap> &coefficients) {
+  ASSERT_NOTNULL(coefficients);
+  size_t size = entrySize(key, *coefficients);
+  lock_guard<mutex> lock(this->m_Lock);
+  if (size > this->m_MaxBytes || this->m_Index.count(key) != 0) {
+    return;
+  }
+  this->m_Entries.push_front(Entry{key, coefficients, size});
+  this->m_Index[key] = this->m_Entries.begin();
+  this->m_Bytes += size;
+  this->evict();
+}
+
+/*!
+ * Drop the least recently used entries until the cache fits its budget.
+ * The caller must hold the cache lock.
+ *
+ */
+void
+OpenABEReconstructionCache::evict() {
+  while (this->m_Bytes > this->m_MaxBytes && !this->m_Entries.empty()) {
+    const Entry &entry = this->m_Entries.back();
+    this->m_Bytes -= entry.size;
+    this->m_Index.erase(entry.key);
+    this->m_Entries.pop_back();
+    this->m_Evictions++;
+  }
+}
+
+/*!
+ * Set the memory budget of the cache (0 disables caching).
+ *
+ * @param[in]   the budget in bytes.
+ */
+void
+OpenABEReconstructionCache::setMaxBytes(size_t maxBytes) {
+  lock_guard<mutex> lock(this->m_Lock);
+  this->m_MaxBytes = maxBytes;
+  this->evict();
+}
+
+OpenABECacheStats
+OpenABEReconstructionCache::getStats() {
+  lock_guard<mutex> lock(this->m_Lock);
+  OpenABECacheStats stats;
+  stats.hits      = this->m_Hits;
+  stats.misses    = this->m_Misses;
+  stats.evictions = this->m_Evictions;
+  stats.entries   = this->m_Entries.size();
+  stats.bytes     = this->m_Bytes;
+  stats.maxBytes  = this->m_MaxBytes;
+  return stats;
+}
+
+void
+OpenABEReconstructionCache::resetStats() {
+  this->m_Hits = 0;
+  this->m_Misses = 0;
+  this->m_Evictions = 0;
+}
+
+void
+OpenABEReconstructionCache::clear() {
+  lock_guard<mutex> lock(this->m_Lock);
+  this->m_Index.clear();
+  this->m_Entries.clear();
+  this->m_Bytes = 0;
+}
+
+/*!
+ * Return the compiled form of a policy from the process-wide cache.
+ *
+ * @param[in]   the policy string.
+ * @return      the compiled policy, or nullptr if the policy does not parse.
+ */
+shared_ptr<const OpenABECompiledPolicy>
+OpenABE_getCompiledPolicy(const string &policyStr) {
+  return OpenABECompiledPolicyCache::getInstance().get(policyStr);
+}
+
+/*!
+ * Hash the attribute of every LSSS row into G1 (once per distinct attribute).
+ *
+ * @param[in]   the pairing used to hash.
+ * @param[in]   the hash key ("k") of the master public key.
+ * @param[in]   the (unique row label, attribute label) pairs.
+ * @return      the points keyed by attribute label.
+ */
+shared_ptr<const OpenABEHashedAttributes>
+OpenABE_hashPolicyAttributes(OpenABEPairing *pairing, OpenABEByteString &hashKey,
+                             const vector<pair<string, string>> &rows) {
+  shared_ptr<OpenABEHashedAttributes> points = make_shared<OpenABEHashedAttributes>();
+  for (auto& row : rows) {
+    if (points->find(row.second) == points->end()) {
+      (*points)[row.second] = pairing->hashToG1(hashKey, row.second);
+    }
+  }
+  return points;
+}
+
+/*!
+ * Recover the LSSS coefficients for a policy and an attribute list through
+ * the reconstruction cache. On a miss the coefficients are recovered on a
+ * copy of the compiled policy tree and cached.
+ *
+ * @param[in]   the policy string.
+ * @param[in]   the attribute list.
+ * @return      the coefficients keyed by unique row label, or nullptr if
+ *              the attributes do not satisfy the policy. Throws
+ *              OpenABE_ERROR_INVALID_POLICY if the policy does not parse.
+ */
+shared_ptr<const OpenABELSSSRowMap>
+OpenABE_recoverCoefficients(const string &policyStr, OpenABEAttributeList *attrList) {
+  ASSERT_NOTNULL(attrList);
+  OpenABEReconstructionCache &cache = OpenABEReconstructionCache::getInstance();
+  const string key = OpenABEReconstructionCache::makeKey(policyStr, *attrList);
+  shared_ptr<const OpenABELSSSRowMap> coefficients = cache.lookup(key);
+  if (coefficients != nullptr) {
+    return coefficients;
+  }
+
+  // The compiled policy is shared, so recover the coefficients on a copy
+  // of its tree (recovery marks the nodes).
+  shared_ptr<const OpenABECompiledPolicy> compiled = OpenABE_getCompiledPolicy(policyStr);
+  if (compiled == nullptr) {
+    throw OpenABE_ERROR_INVALID_POLICY;
+  }
+  unique_ptr<OpenABEPolicy> policy = compiled->copyPolicyTree();
+  OpenABELSSS lsss;
+  if (!lsss.recoverCoefficients(policy.get(), attrList)) {
+    return nullptr;
+  }
+  coefficients = make_shared<const OpenABELSSSRowMap>(std::move(lsss.getRows()));
+  cache.insert(key, coefficients);
+  return coefficients;
+}
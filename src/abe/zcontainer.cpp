@@ -38,6 +38,7 @@
 #include <stdlib.h>
 #include <iostream>
 #include <fstream>
+#include <mutex>
 #include <string>
 
 #include "abe/zcontainer.h"
@@ -55,10 +56,12 @@ using namespace std;
 
 OpenABEContainer::OpenABEContainer() : ZObject() { 
   this->group = make_shared<BPGroup>();
+  this->lazyDecoding = false;
 }
 
 OpenABEContainer::OpenABEContainer(std::shared_ptr<BPGroup> group) : ZObject() {
   this->group = group;
+  this->lazyDecoding = false;
 }
 
 /*!
@@ -95,16 +98,75 @@ void OpenABEContainer::setComponent(const string &name, const ZObject *component
  */
 
 ZObject *OpenABEContainer::getComponent(const string &name) {
-  ZObject *result = this->val[name];
+  unique_lock<mutex> guard(this->decodeLock.lock, defer_lock);
+  if (this->lazyDecoding) {
+    guard.lock();
+  }
+  auto it = this->val.find(name);
+  ZObject *result = (it != this->val.end()) ? it->second : nullptr;
 
   if (result == nullptr) {
     cerr << "OpenABEContainer::getComponent: missing '" << name << "'" << endl;
     throw OpenABE_ERROR_ELEMENT_NOT_FOUND;
   }
 
+  OpenABELazyElement *lazy = dynamic_cast<OpenABELazyElement*>(result);
+  if (lazy != nullptr) {
+    // first access: decode the element and drop its bytes
+    result = lazy->decodeInPlace(this->group.get());
+    if (result == nullptr) {
+      OpenABEByteString value;
+      lazy->serialize(value);
+      result = this->decodeElement(value);
+    }
+    if (result == nullptr) {
+      throw OpenABE_ERROR_ELEMENT_NOT_FOUND;
+    }
+    it->second = result;
+    delete lazy;
+  }
+
   return result;
 }
 
+/*!
+ * Store a serialized component. It is decoded right away, or on first
+ * access if lazy decoding is enabled for this container.
+ *
+ * @param Name of the component
+ * @param Serialized component (starting with its element type)
+ */
+
+void OpenABEContainer::setSerializedComponent(const string &name, const OpenABEByteString &value) {
+  if (this->lazyDecoding) {
+    this->replaceComponent(name, new OpenABELazyElement(value));
+  } else {
+    OpenABEByteString bytes = value;
+    this->deserializeElement(name, bytes);
+  }
+}
+
+/*!
+ * Decode every component that is still held as bytes.
+ *
+ */
+
+void OpenABEContainer::decodeAllComponents() {
+  for (const string &name : this->getKeys()) {
+    this->getComponent(name);
+  }
+}
+
+void OpenABEContainer::replaceComponent(const string &name, ZObject *component) {
+  auto it = this->val.find(name);
+  if (it != this->val.end()) {
+    delete it->second;
+    it->second = component;
+  } else {
+    this->val[name] = component;
+  }
+}
+
 OpenABE_ERROR
 OpenABEContainer::deleteComponent(const string name) {
   map<string, ZObject *>::iterator iter1 = this->val.find(name);
@@ -144,6 +206,20 @@ void OpenABEContainer::serialize(OpenABEByteString &result) const {
 }
 
 void OpenABEContainer::deserializeElement(std::string key, OpenABEByteString &value) {
+  ZObject *component = this->decodeElement(value);
+  if (component != nullptr) {
+    this->replaceComponent(key, component);
+  }
+}
+
+/*!
+ * Decode a serialized element into a newly allocated object.
+ *
+ * @param Serialized element (starting with its element type)
+ * @return The element, or nullptr for types that are not stored
+ */
+
+ZObject* OpenABEContainer::decodeElement(OpenABEByteString &value) {
   if (value.size() == 0) {
     throw OpenABE_ERROR_INVALID_INPUT;
   }
@@ -152,7 +228,7 @@ void OpenABEContainer::deserializeElement(std::string key, OpenABEByteString &va
   if (type == OpenABE_ELEMENT_INT) {
     unique_ptr<OpenABEUInteger> i(new OpenABEUInteger(0));
     i->deserialize(value);
-    this->setComponent(key, i.get());
+    return i.release();
   } else if (type >= OpenABE_ELEMENT_ZP && type <= OpenABE_ELEMENT_GT) {
     ASSERT(this->group != nullptr, OpenABE_ERROR_INVALID_GROUP_PARAMS);
     std::shared_ptr<BPGroup> bp = dynamic_pointer_cast<BPGroup>(group);
@@ -161,38 +237,38 @@ void OpenABEContainer::deserializeElement(std::string key, OpenABEByteString &va
       unique_ptr<ZP> s(new ZP);
       s->setOrder(bp->order);
       s->deserialize(value);
-      this->setComponent(key, s.get());
+      return s.release();
     } else if (type == OpenABE_ELEMENT_G1) {
       unique_ptr<G1> g(new G1());
       g->deserialize(value);
-      this->setComponent(key, g.get());
+      return g.release();
     } else if (type == OpenABE_ELEMENT_G2) {
       unique_ptr<G2> g(new G2());
       g->deserialize(value);
-      this->setComponent(key, g.get());
+      return g.release();
     } else {
       unique_ptr<GT> g(new GT());
       g->deserialize(value);
-      this->setComponent(key, g.get());
+      return g.release();
     }
   } else if (type == OpenABE_ELEMENT_BYTESTRING) {
     unique_ptr<OpenABEByteString> b(new OpenABEByteString);
     b->deserialize(value);
-    this->setComponent(key, b.get());
+    return b.release();
   } else if (type == OpenABE_ELEMENT_POLICY) {
     const string b = value.toString();
     unique_ptr<OpenABEPolicy> p = createPolicyTree(b);
     if (p == nullptr) {
       throw OpenABE_ERROR_INVALID_POLICY_TREE;
     }
-    this->setComponent(key, p.get());
+    return p.release();
   } else if (type == OpenABE_ELEMENT_ATTRIBUTES) {
     const string b = value.toString();
     unique_ptr<OpenABEAttributeList> a = createAttributeList(b);
     if (a == nullptr) {
       throw OpenABE_ERROR_INVALID_ATTRIBUTE_LIST;
     }
-    this->setComponent(key, a.get());
+    return a.release();
   } else if (type == OpenABE_ELEMENT_ZP_t || type == OpenABE_ELEMENT_G_t) {
     ASSERT(this->group != nullptr, OpenABE_ERROR_INVALID_GROUP_PARAMS);
     std::shared_ptr<BPGroup> ec = dynamic_pointer_cast<BPGroup>(group);
@@ -202,7 +278,7 @@ void OpenABEContainer::deserializeElement(std::string key, OpenABEByteString &va
     throw OpenABE_INVALID_INPUT_TYPE;
   }
 
-  return;
+  return nullptr;
 }
 
 void OpenABEContainer::deserialize(OpenABEByteString &blob) {
@@ -213,7 +289,12 @@ void OpenABEContainer::deserialize(OpenABEByteString &blob) {
   do {
     key = result.smartUnpack(&index);
     value = result.smartUnpack(&index);
-    this->deserializeElement(key.toString(), value);
+    if (this->lazyDecoding && value.size() > 0 &&
+        value.at(0) != OpenABE_ELEMENT_ZP_t && value.at(0) != OpenABE_ELEMENT_G_t) {
+      this->replaceComponent(key.toString(), new OpenABELazyElement(value));
+    } else {
+      this->deserializeElement(key.toString(), value);
+    }
   } while (index < result.size());
   return;
 }
@@ -234,32 +315,51 @@ std::vector<std::string> OpenABEContainer::getKeys() {
   return keyList;
 }
 
+/*!
+ * Compare two containers component by component, in key order, stopping
+ * at the first difference. Components that are still held as bytes (lazy
+ * decoding) are compared in serialized form, so a freshly computed
+ * container can be checked against a loaded one without decoding it.
+ */
 bool operator==(const OpenABEContainer &c1, const OpenABEContainer &c2) {
-  // check that the 'keys' of the containers are equal
-  std::vector<std::string> keyList1 = const_cast<OpenABEContainer &>(c1).getKeys();
-  std::vector<std::string> keyList2 = const_cast<OpenABEContainer &>(c2).getKeys();
-  std::vector<std::string> keyList3(keyList1.size() + keyList2.size());
-  std::vector<std::string>::iterator iter =
-      std::set_difference(keyList1.begin(), keyList1.end(), keyList2.begin(),
-                          keyList2.end(), keyList3.begin());
-  size_t keydiff = iter->size();
-  if (keydiff > 0) {
+  if (&c1 == &c2) {
+    return true;
+  }
+  if (c1.val.size() != c2.val.size()) {
     return false;
   }
 
-  // check that 'values' of container are equal
-  for (std::vector<std::string>::iterator it = keyList1.begin();
-       it != keyList1.end(); ++it) {
-    ZObject *lhs = const_cast<OpenABEContainer &>(c1).getComponent(*it);
-    ZObject *rhs = const_cast<OpenABEContainer &>(c2).getComponent(*it);
-    if (lhs->isEqual(rhs)) {
-      continue;
-    } else {
-      keydiff++;
-    }
+  OpenABEContainer &lhs = const_cast<OpenABEContainer &>(c1);
+  OpenABEContainer &rhs = const_cast<OpenABEContainer &>(c2);
+  unique_lock<mutex> guard1(lhs.decodeLock.lock, defer_lock);
+  unique_lock<mutex> guard2(rhs.decodeLock.lock, defer_lock);
+  if (lhs.lazyDecoding && rhs.lazyDecoding) {
+    std::lock(guard1, guard2);
+  } else if (lhs.lazyDecoding) {
+    guard1.lock();
+  } else if (rhs.lazyDecoding) {
+    guard2.lock();
   }
 
-  if (keydiff > 0)
-    return false;
+  OpenABEByteString bytes1, bytes2;
+  auto it1 = c1.val.begin();
+  auto it2 = c2.val.begin();
+  for (; it1 != c1.val.end(); ++it1, ++it2) {
+    if (it1->first != it2->first) {
+      return false;
+    }
+    if (dynamic_cast<OpenABELazyElement *>(it1->second) != nullptr ||
+        dynamic_cast<OpenABELazyElement *>(it2->second) != nullptr) {
+      bytes1.clear();
+      bytes2.clear();
+      it1->second->serialize(bytes1);
+      it2->second->serialize(bytes2);
+      if (bytes1 != bytes2) {
+        return false;
+      }
+    } else if (!it1->second->isEqual(it2->second)) {
+      return false;
+    }
+  }
   return true;
 }
@@ -49,7 +49,7 @@ using namespace std;
  * Constructor for the OpenABEContextABE base class.
  *
  */
-OpenABEContextABE::OpenABEContextABE() : OpenABEContext() {}
+OpenABEContextABE::OpenABEContextABE() : OpenABEContext(), m_DecryptionThreads(1) {}
 
 /*!
  * Destructor for the OpenABEContextABE base class.
@@ -57,6 +57,134 @@ OpenABEContextABE::OpenABEContextABE() : OpenABEContext() {}
  */
 OpenABEContextABE::~OpenABEContextABE() {}
 
+/*!
+ * Combine the satisfied rows of a decryption:
+ *   prod1 = sum_i coeff_i * sumTerm_i
+ *   prodT = prod_i e(coeff_i * pairingG1_i, pairingG2_i)
+ * The rows are split into contiguous chunks, one per decryption thread.
+ * Each worker computes the G1 sum of its chunk as a single multi-scalar
+ * multiplication, and does the scalar multiplications and the
+ * multi-pairing of its chunk. Rows whose coefficient is 0 are skipped and
+ * coefficients of +-1 are applied by (negated) addition. The partial
+ * results are then combined. RELIC does not export the Miller loop
+ * without the final exponentiation, so each chunk pays for one final
+ * exponentiation of its own instead of sharing a single one.
+ *
+ * @param[in]   the satisfied rows.
+ * @param[out]  sum in G1.
+ * @param[out]  product of pairings in GT.
+ */
+void
+OpenABEContextABE::evaluateDecryptionRows(const vector<OpenABEDecryptionRow> &rows, G1 &prod1, GT &prodT) {
+  const size_t numRows = rows.size();
+  if (numRows == 0) {
+    throw OpenABE_ERROR_INVALID_LENGTH;
+  }
+  size_t maxChunks = (numRows + OpenABE_MIN_DECRYPTION_ROWS_PER_THREAD - 1) /
+                     OpenABE_MIN_DECRYPTION_ROWS_PER_THREAD;
+  const size_t numChunks = OpenABE_getWorkerCount(this->m_DecryptionThreads, maxChunks);
+  const size_t chunkSize = (numRows + numChunks - 1) / numChunks;
+
+  vector<G1> sums(numChunks);
+  vector<GT> products(numChunks);
+  OpenABEPairing *pairing = this->getPairing();
+
+  OpenABE_parallelFor(numChunks, numChunks, [&](size_t c) {
+    const size_t begin = c * chunkSize;
+    const size_t end = min(numRows, begin + chunkSize);
+    vector<G1> sumTerms, g1s;
+    vector<G2> g2s;
+    vector<ZP> coeffs;
+    G1 trivialSum;
+    for (size_t i = begin; i < end; i++) {
+      const OpenABEDecryptionRow &row = rows[i];
+      // Lagrange coefficients of AND/OR trees are often 0 or +-1: skip
+      // or negate those instead of doing a scalar multiplication
+      if (row.coeff.isZero()) {
+        continue;
+      } else if (row.coeff.isOne()) {
+        trivialSum += *row.sumTerm;
+        g1s.push_back(*row.pairingG1);
+      } else if (row.coeff.isMinusOne()) {
+        trivialSum += -(*row.sumTerm);
+        g1s.push_back(-(*row.pairingG1));
+      } else {
+        sumTerms.push_back(*row.sumTerm);
+        coeffs.push_back(row.coeff);
+        g1s.push_back(*row.pairingG1 * row.coeff);
+      }
+      g2s.push_back(*row.pairingG2);
+    }
+    // one multi-scalar multiplication for the non-trivial coefficients
+    sums[c] = G1::multiExp(sumTerms, coeffs) + trivialSum;
+    if (!g1s.empty()) {
+      pairing->multi_pairing(products[c], g1s, g2s);
+    }
+  });
+
+  prod1 = sums[0];
+  prodT = products[0];
+  for (size_t c = 1; c < numChunks; c++) {
+    prod1 += sums[c];
+    prodT *= products[c];
+  }
+}
+
+/*!
+ * Run row(i) for every row of a key being generated. The rows are split
+ * into contiguous chunks of at least OpenABE_MIN_KEYGEN_ROWS_PER_THREAD
+ * rows, one per thread, so small keys stay on the calling thread.
+ *
+ * @param[in]   number of rows.
+ * @param[in]   number of threads (0 for automatic).
+ * @param[in]   the computation of one row.
+ */
+void
+OpenABEContextABE::parallelKeygenRows(size_t numRows, unsigned int numThreads,
+                                      const function<void(size_t)> &row) {
+  size_t maxChunks = (numRows + OpenABE_MIN_KEYGEN_ROWS_PER_THREAD - 1) /
+                     OpenABE_MIN_KEYGEN_ROWS_PER_THREAD;
+  const size_t numChunks = OpenABE_getWorkerCount(numThreads, maxChunks);
+  const size_t chunkSize = (numRows + numChunks - 1) / numChunks;
+
+  OpenABE_parallelFor(numChunks, numChunks, [&](size_t c) {
+    const size_t end = min(numRows, (c + 1) * chunkSize);
+    for (size_t i = c * chunkSize; i < end; i++) {
+      row(i);
+    }
+  });
+}
+
+/********************************************************************************
+ * Implementation of the OpenABEKeygenSetup class
+ ********************************************************************************/
+
+OpenABEKeygenSetup::OpenABEKeygenSetup(OpenABEPairing *pairing, const OpenABEByteString &hashKey)
+  : pairing(pairing), hashKey(hashKey) {}
+
+/*!
+ * Hash an attribute to G1 under the MPK hash key. The first request for an
+ * attribute computes the point and later requests reuse it. Two threads
+ * that miss at the same time both compute the point, which is harmless.
+ *
+ * @param[in]   the attribute.
+ * @return      hash_to_G1(attribute).
+ */
+G1
+OpenABEKeygenSetup::hashAttribute(const string &attribute) {
+  {
+    lock_guard<mutex> guard(this->hashLock);
+    auto it = this->hashedAttributes.find(attribute);
+    if (it != this->hashedAttributes.end()) {
+      return it->second;
+    }
+  }
+  G1 point = this->pairing->hashToG1(this->hashKey, attribute);
+  lock_guard<mutex> guard(this->hashLock);
+  this->hashedAttributes.emplace(attribute, point);
+  return point;
+}
+
 /*!
  * Initialize the pairing structure in underlying pairing library
  *
@@ -97,6 +225,7 @@ OpenABEContextSchemeCPA::OpenABEContextSchemeCPA(unique_ptr<OpenABEContextABE> k
     throw OpenABE_ERROR_INVALID_INPUT;
   }
   this->m_KEM_ = move(kem_);
+  this->m_PayloadMode = OpenABE_PAYLOAD_AES_CTR;
 }
 
 /*!
@@ -212,6 +341,10 @@ OpenABEContextSchemeCPA::loadKey(const string &ID, OpenABEByteString &keyBlob,
   // now, we can load the key
   KEY->setGroup(this->m_KEM_->getPairing()->getGroup());
   KEY->loadKeyFromBytes(outputKeyBytes);
+  if (keyType == KEY_TYPE_PUBLIC) {
+    // the GT element of the MPK is a fixed base for every encryption
+    KEY->precomputeGTFixedBase();
+  }
   this->m_KEM_->getKeystore()->addKey(ID, KEY, keyType);
 
   return OpenABE_NOERROR;
@@ -294,6 +427,54 @@ OpenABEContextSchemeCPA::keygen(OpenABEFunctionInput* keyInput, const string &ke
                                              gpkID, GID);
 }
 
+/*!
+ * Generate decryption keys for many users under the same master key. The
+ * KEM loads the MPK/MSK and computes the key-independent terms once, and
+ * attributes shared by several users are hashed only once. Users are
+ * spread over up to numThreads threads; a batch with a single key uses the
+ * threads for the rows of that key instead. Each key is exported as soon
+ * as it is generated and is not added to the keystore.
+ *
+ * @param[in]   functional inputs of the keys (attribute lists or policies).
+ * @param[in]   identifiers of the keys, one per input.
+ * @param[in]   parameter ID of the master public key.
+ * @param[in]   parameter ID of the master secret key.
+ * @param[out]  the exported keys, one per input in the same order.
+ * @param[in]   number of threads to use (0 selects the hardware concurrency).
+ * @return      An error code or OpenABE_NOERROR.
+ */
+OpenABE_ERROR
+OpenABEContextSchemeCPA::keygenBatch(const vector<OpenABEFunctionInput*>& keyInputs,
+                                     const vector<string>& keyIDs, const string &mpkID,
+                                     const string &mskID, vector<OpenABEByteString>& keyBlobs,
+                                     unsigned int numThreads) {
+  OpenABE_ERROR result = OpenABE_NOERROR;
+
+  try {
+    OpenABE_initializeThreadContext();
+    ASSERT(keyInputs.size() == keyIDs.size(), OpenABE_ERROR_INVALID_LENGTH);
+    unique_ptr<OpenABEKeygenSetup> setup = this->m_KEM_->prepareKeygen(mpkID, mskID);
+    ASSERT(setup != nullptr, OpenABE_ERROR_NOT_IMPLEMENTED);
+
+    keyBlobs.clear();
+    keyBlobs.resize(keyInputs.size());
+    unsigned int keyThreads = (keyInputs.size() == 1) ? numThreads : 1;
+    OpenABE_parallelFor(keyInputs.size(), numThreads, [&](size_t i) {
+      shared_ptr<OpenABEKey> decKey = nullptr;
+      OpenABE_ERROR err = this->m_KEM_->generateDecryptionKeyPrepared(setup.get(),
+                              keyInputs[i], keyIDs[i], decKey, keyThreads);
+      ASSERT(err == OpenABE_NOERROR, err);
+      err = decKey->exportKeyToBytes(keyBlobs[i]);
+      ASSERT(err == OpenABE_NOERROR, err);
+    });
+  } catch (OpenABE_ERROR &error) {
+    keyBlobs.clear();
+    result = error;
+  }
+
+  return result;
+}
+
 /*!
  * Generate and encrypt a symmetric key using the key encapsulation mode
  * of the underlying KEM scheme. Use the symmetric key with PRNG to encrypt
@@ -311,32 +492,151 @@ OpenABEContextSchemeCPA::encrypt(const string &mpkID, const OpenABEFunctionInput
                           OpenABEByteString& plaintext, OpenABECiphertext& ciphertext) {
   OpenABE_ERROR result = OpenABE_NOERROR;
   shared_ptr<OpenABESymKey> K(new OpenABESymKey);
-  unique_ptr<OpenABEByteString> ct = nullptr;
 
   try {
+    OpenABE_initializeThreadContext();
     // generate Key Encapsulation for access structure under MPK
     result = this->m_KEM_->encryptKEM(mpkID, encryptInput,
                                       DEFAULT_SYM_KEY_BYTES, K, ciphertext);
     ASSERT(result == OpenABE_NOERROR, result);
 
-    // generate a hash of encMessage->size() size and xor it with encMessage
-    OpenABEByteString mask_K = this->m_KEM_->getPairing()->hashFromBytes(
-        K->getKeyBytes(), plaintext.size(), SCHEME_HASH_FUNCTION);
+    result = this->encryptPayload(K, plaintext, ciphertext);
+  } catch (OpenABE_ERROR &error) {
+    result = error;
+  }
 
-    ct = make_unique<OpenABEByteString>(plaintext);
-    *ct ^= mask_K;
-    ciphertext.setComponent("_ED", ct.get()); // encryptedData
+  return result;
+}
 
-    // cout << "encryptedData: " << y->toHex() << endl;
-    mask_K.zeroize();
-    K->zeroize();
+/*!
+ * Encrypt a batch of plaintexts under the same policy (or attribute list).
+ * The KEM prepares the recipient state once (MPK tables, hashed attributes,
+ * serialized policy) and every plaintext then only pays for its own fresh
+ * randomness. The work is spread over up to numThreads threads, each with
+ * its own RELIC context; it stays on the calling thread when RELIC is not
+ * built for multithreading.
+ *
+ * @param[in]   master public key identifier in keystore for the recipient.
+ * @param[in]   functional input of the underlying KEM context (either attribute list or policy).
+ * @param[in]   the plaintexts.
+ * @param[out]  the ciphertexts, one per plaintext in the same order.
+ * @param[in]   number of threads to use (0 selects the hardware concurrency).
+ * @return  An error code or OpenABE_NOERROR.
+ */
+OpenABE_ERROR
+OpenABEContextSchemeCPA::encryptBatch(const string &mpkID, const OpenABEFunctionInput* encryptInput,
+                          vector<OpenABEByteString>& plaintexts,
+                          vector<unique_ptr<OpenABECiphertext>>& ciphertexts,
+                          unsigned int numThreads) {
+  OpenABE_ERROR result = OpenABE_NOERROR;
+
+  try {
+    OpenABE_initializeThreadContext();
+    unique_ptr<OpenABEEncryptionSetup> setup =
+        this->m_KEM_->prepareEncryption(mpkID, encryptInput);
+
+    ciphertexts.clear();
+    for (size_t i = 0; i < plaintexts.size(); i++) {
+      ciphertexts.push_back(make_unique<OpenABECiphertext>());
+    }
+
+    OpenABE_parallelFor(plaintexts.size(), numThreads, [&](size_t i) {
+      shared_ptr<OpenABESymKey> K(new OpenABESymKey);
+      OpenABE_ERROR err = this->m_KEM_->encryptKEMPrepared(setup.get(),
+                              DEFAULT_SYM_KEY_BYTES, K, *ciphertexts[i]);
+      ASSERT(err == OpenABE_NOERROR, err);
+      err = this->encryptPayload(K, plaintexts[i], *ciphertexts[i]);
+      ASSERT(err == OpenABE_NOERROR, err);
+    });
   } catch (OpenABE_ERROR &error) {
+    ciphertexts.clear();
     result = error;
   }
 
   return result;
 }
 
+/*!
+ * Mask the plaintext with a keystream derived from the encapsulated key
+ * and store it in the ciphertext along with the payload mode. The key is
+ * zeroized afterwards.
+ *
+ * @param[in]   the encapsulated symmetric key.
+ * @param[in]   the plaintext.
+ * @param[out]  the ciphertext holding the KEM components.
+ * @return  An error code or OpenABE_NOERROR.
+ */
+OpenABE_ERROR
+OpenABEContextSchemeCPA::encryptPayload(shared_ptr<OpenABESymKey>& K, OpenABEByteString& plaintext,
+                          OpenABECiphertext& ciphertext) {
+  OpenABEByteString ct, mode;
+
+  OpenABE_ERROR result = this->maskPayload(this->m_PayloadMode, K->getKeyBytes(), plaintext, ct);
+  K->zeroize();
+  if (result != OpenABE_NOERROR) {
+    return result;
+  }
+
+  ciphertext.setComponent("_ED", &ct); // encryptedData
+  if (this->m_PayloadMode != OpenABE_PAYLOAD_HASH) {
+    // legacy ciphertexts carry no mode and are decrypted with the hash mask
+    mode.push_back((uint8_t) this->m_PayloadMode);
+    ciphertext.setComponent("_PM", &mode); // payloadMode
+  }
+  return OpenABE_NOERROR;
+}
+
+/*!
+ * XOR the input with a keystream derived from the key. OpenABE_PAYLOAD_HASH
+ * is the original SHA-256 counter construction (hashFromBytes);
+ * OpenABE_PAYLOAD_AES_CTR runs AES-256-CTR over the input in fixed-size
+ * chunks. Each key masks a single payload, so CTR starts from a zero IV.
+ *
+ * @param[in]   the payload mode.
+ * @param[in]   the symmetric key.
+ * @param[in]   the input (plaintext or ciphertext).
+ * @param[out]  the masked output.
+ * @return  An error code or OpenABE_NOERROR.
+ */
+OpenABE_ERROR
+OpenABEContextSchemeCPA::maskPayload(OpenABE_PAYLOAD_MODE mode, OpenABEByteString& key,
+                          OpenABEByteString& input, OpenABEByteString& output) {
+  if (mode == OpenABE_PAYLOAD_HASH) {
+    // generate a hash of input.size() size and xor it with the input
+    OpenABEByteString mask_K = this->m_KEM_->getPairing()->hashFromBytes(
+        key, input.size(), SCHEME_HASH_FUNCTION);
+    output = input;
+    output ^= mask_K;
+    mask_K.zeroize();
+    return OpenABE_NOERROR;
+  } else if (mode != OpenABE_PAYLOAD_AES_CTR) {
+    return OpenABE_ERROR_INVALID_CIPHERTEXT_BODY;
+  }
+
+  uint8_t iv[AES_BLOCK_SIZE];
+  memset(iv, 0, AES_BLOCK_SIZE);
+  if (key.size() != DEFAULT_SYM_KEY_BYTES) {
+    return OpenABE_ERROR_INVALID_KEY;
+  }
+
+  EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+  MALLOC_CHECK_OUT_OF_MEMORY(ctx);
+  bool ok = (EVP_EncryptInit_ex(ctx, EVP_aes_256_ctr(), NULL, key.data(), iv) == 1);
+  output.resize(input.size());
+  for (size_t offset = 0; ok && offset < input.size(); offset += OpenABE_PAYLOAD_CHUNK_SIZE) {
+    int len = 0;
+    size_t chunk = min((size_t) OpenABE_PAYLOAD_CHUNK_SIZE, input.size() - offset);
+    ok = (EVP_EncryptUpdate(ctx, output.data() + offset, &len,
+                            input.data() + offset, chunk) == 1);
+  }
+  EVP_CIPHER_CTX_free(ctx);
+  if (!ok) {
+    output.clear();
+    return OpenABE_ERROR_ENCRYPTION_ERROR;
+  }
+  return OpenABE_NOERROR;
+}
+
  /*!
   * Decrypt a symmetric key using the key encapsulation mode
   * of the underlying scheme. Use the key with PRNG to decrypt
@@ -355,6 +655,7 @@ OpenABEContextSchemeCPA::decrypt(const string &mpkID, const string &keyID,
   shared_ptr<OpenABESymKey> K(new OpenABESymKey);
 
   try {
+    OpenABE_initializeThreadContext();
     result = this->m_KEM_->decryptKEM(mpkID, keyID, ciphertext, DEFAULT_SYM_KEY_BYTES, K);
     if (result != OpenABE_NOERROR) {
       throw result;
@@ -366,16 +667,21 @@ OpenABEContextSchemeCPA::decrypt(const string &mpkID, const string &keyID,
       throw OpenABE_ERROR_INVALID_INPUT;
     }
 
-    // generate a hash of encMessage->size() size and xor it with encMessage
-    OpenABEByteString mask_K = this->m_KEM_->getPairing()->hashFromBytes(
-        K->getKeyBytes(), encMessage->size(), SCHEME_HASH_FUNCTION);
-
-    // mask_K XOR *encMessage
-    plaintext = *encMessage;
-    plaintext ^= mask_K;
+    // ciphertexts without a payload mode were masked with the hash
+    OpenABE_PAYLOAD_MODE mode = OpenABE_PAYLOAD_HASH;
+    if (ciphertext.hasComponent("_PM")) {
+      OpenABEByteString *modeByte = ciphertext.getByteString("_PM"); // payloadMode
+      if (modeByte == nullptr || modeByte->size() != 1) {
+        throw OpenABE_ERROR_INVALID_CIPHERTEXT_BODY;
+      }
+      mode = (OpenABE_PAYLOAD_MODE) modeByte->at(0);
+    }
 
-    mask_K.zeroize();
+    result = this->maskPayload(mode, K->getKeyBytes(), *encMessage, plaintext);
     K->zeroize();
+    if (result != OpenABE_NOERROR) {
+      throw result;
+    }
   } catch (OpenABE_ERROR &error) {
     plaintext.clear();
     result = error;
@@ -383,3 +689,221 @@ OpenABEContextSchemeCPA::decrypt(const string &mpkID, const string &keyID,
 
   return result;
 }
+
+/*!
+ * Additional authenticated data of a stream: the serialized KEM header
+ * (the policy or attribute list, the KEM components and the IV), so the
+ * tag also covers the header the payload is sent with.
+ *
+ * @param[in]   the ciphertext header.
+ * @param[out]  the AAD.
+ */
+static void getStreamAuthData(OpenABECiphertext& ciphertext, OpenABEByteString& aad) {
+  aad.clear();
+  ciphertext.exportToBytesWithoutHeader(aad);
+}
+
+/*!
+ * Start a streaming encryption: encapsulate a fresh key for the policy
+ * (or attribute list) and set up AES-GCM with it. The ciphertext receives
+ * the KEM components and the IV; it can be written out before the
+ * payload. The stream state lives in the returned encryptor, so the
+ * context can be used for other streams at the same time. Memory use
+ * does not depend on the payload size.
+ *
+ * @param[in]   master public key identifier in keystore for the recipient.
+ * @param[in]   functional input of the underlying KEM context (either attribute list or policy).
+ * @param[out]  the ciphertext header.
+ * @param[out]  the stream that encrypts the payload.
+ * @return  An error code or OpenABE_NOERROR.
+ */
+OpenABE_ERROR
+OpenABEContextSchemeCPA::encryptInit(const string &mpkID, const OpenABEFunctionInput* encryptInput,
+                          OpenABECiphertext& ciphertext, unique_ptr<OpenABEStreamEncryptor>& encryptor) {
+  OpenABE_ERROR result = OpenABE_NOERROR;
+  shared_ptr<OpenABESymKey> K(new OpenABESymKey);
+  encryptor.reset();
+
+  try {
+    OpenABE_initializeThreadContext();
+    result = this->m_KEM_->encryptKEM(mpkID, encryptInput,
+                                      DEFAULT_SYM_KEY_BYTES, K, ciphertext);
+    ASSERT(result == OpenABE_NOERROR, result);
+
+    OpenABEByteString iv, aad;
+    unique_ptr<OpenABESymKeyAuthEncStream> stream(
+        new OpenABESymKeyAuthEncStream(DEFAULT_AES_SEC_LEVEL, K));
+    result = stream->encryptInit(iv);
+    ASSERT(result == OpenABE_NOERROR, result);
+    ciphertext.setComponent("_IV", &iv);
+    getStreamAuthData(ciphertext, aad);
+    stream->initAddAuthData(aad.getInternalPtr(), aad.size());
+    result = stream->setAddAuthData();
+    ASSERT(result == OpenABE_NOERROR, result);
+    encryptor.reset(new OpenABEStreamEncryptor(std::move(stream)));
+  } catch (OpenABE_ERROR &error) {
+    result = error;
+  }
+  // the cipher context keeps its own copy of the key schedule
+  K->zeroize();
+
+  return result;
+}
+
+/*!
+ * Start a streaming decryption: decapsulate the key from the ciphertext
+ * header and set up AES-GCM with it. Plaintext blocks returned by the
+ * decryptor must not be trusted until its finalize succeeds.
+ *
+ * @param[in]   master public key identifier of the sender (assumes it's already in keystore).
+ * @param[in]   key identifier of recipient (assumes it's already in keystore).
+ * @param[in]   the ciphertext header from encryptInit.
+ * @param[out]  the stream that decrypts the payload.
+ * @return  An error code or OpenABE_NOERROR.
+ */
+OpenABE_ERROR
+OpenABEContextSchemeCPA::decryptInit(const string &mpkID, const string &keyID,
+                          OpenABECiphertext& ciphertext, unique_ptr<OpenABEStreamDecryptor>& decryptor) {
+  OpenABE_ERROR result = OpenABE_NOERROR;
+  shared_ptr<OpenABESymKey> K(new OpenABESymKey);
+  decryptor.reset();
+
+  try {
+    OpenABE_initializeThreadContext();
+    // taken before decapsulation, while loaded components are still the
+    // bytes that were received
+    OpenABEByteString aad;
+    getStreamAuthData(ciphertext, aad);
+    result = this->m_KEM_->decryptKEM(mpkID, keyID, ciphertext, DEFAULT_SYM_KEY_BYTES, K);
+    ASSERT(result == OpenABE_NOERROR, result);
+
+    OpenABEByteString *iv = ciphertext.getByteString("_IV");
+    if (iv == nullptr || iv->size() != AES_BLOCK_SIZE) {
+      throw OpenABE_ERROR_INVALID_CIPHERTEXT_BODY;
+    }
+    // the tag trails the payload and is passed to finalize
+    OpenABEByteString noTag;
+    unique_ptr<OpenABESymKeyAuthEncStream> stream(
+        new OpenABESymKeyAuthEncStream(DEFAULT_AES_SEC_LEVEL, K));
+    result = stream->decryptInit(*iv, noTag);
+    ASSERT(result == OpenABE_NOERROR, result);
+    stream->initAddAuthData(aad.getInternalPtr(), aad.size());
+    result = stream->setAddAuthData();
+    ASSERT(result == OpenABE_NOERROR, result);
+    decryptor.reset(new OpenABEStreamDecryptor(std::move(stream)));
+  } catch (OpenABE_ERROR &error) {
+    result = error;
+  }
+  K->zeroize();
+
+  return result;
+}
+
+/********************************************************************************
+ * Implementation of the OpenABEStreamEncryptor class
+ ********************************************************************************/
+
+/*!
+ * Encrypt the next block of the stream.
+ *
+ * @param[in]   the plaintext block (any size).
+ * @param[out]  the ciphertext block is appended here.
+ * @return  An error code or OpenABE_NOERROR.
+ */
+OpenABE_ERROR
+OpenABEStreamEncryptor::update(OpenABEByteString& plaintextBlock,
+                               OpenABEByteString& ciphertextBlock) {
+  OpenABE_ERROR result = OpenABE_NOERROR;
+
+  try {
+    /* make sure the stream was not finalized already */
+    ASSERT_NOTNULL(this->m_Stream.get());
+    if (plaintextBlock.size() > 0) {
+      result = this->m_Stream->encryptUpdate(plaintextBlock, ciphertextBlock);
+    }
+  } catch (OpenABE_ERROR &error) {
+    result = error;
+  }
+
+  return result;
+}
+
+/*!
+ * Finish the stream and return the authentication tag.
+ *
+ * @param[out]  the authentication tag.
+ * @return  An error code or OpenABE_NOERROR.
+ */
+OpenABE_ERROR
+OpenABEStreamEncryptor::finalize(OpenABEByteString& tag) {
+  OpenABE_ERROR result = OpenABE_NOERROR;
+
+  try {
+    /* make sure the stream was not finalized already */
+    ASSERT_NOTNULL(this->m_Stream.get());
+    // GCM writes no final block, so the ciphertext is not needed here
+    OpenABEByteString lastBlock;
+    tag.clear();
+    result = this->m_Stream->encryptFinalize(lastBlock, tag);
+    ASSERT(result == OpenABE_NOERROR, result);
+  } catch (OpenABE_ERROR &error) {
+    result = error;
+  }
+  this->m_Stream.reset();
+
+  return result;
+}
+
+/********************************************************************************
+ * Implementation of the OpenABEStreamDecryptor class
+ ********************************************************************************/
+
+/*!
+ * Decrypt the next block of the stream.
+ *
+ * @param[in]   the ciphertext block (any size).
+ * @param[out]  the plaintext block is appended here.
+ * @return  An error code or OpenABE_NOERROR.
+ */
+OpenABE_ERROR
+OpenABEStreamDecryptor::update(OpenABEByteString& ciphertextBlock,
+                               OpenABEByteString& plaintextBlock) {
+  OpenABE_ERROR result = OpenABE_NOERROR;
+
+  try {
+    /* make sure the stream was not finalized already */
+    ASSERT_NOTNULL(this->m_Stream.get());
+    if (ciphertextBlock.size() > 0) {
+      result = this->m_Stream->decryptUpdate(ciphertextBlock, plaintextBlock);
+    }
+  } catch (OpenABE_ERROR &error) {
+    result = error;
+  }
+
+  return result;
+}
+
+/*!
+ * Finish the stream by verifying the authentication tag.
+ *
+ * @param[in]   the tag returned by OpenABEStreamEncryptor::finalize.
+ * @return  OpenABE_NOERROR if the header and the whole payload are
+ *          authentic, otherwise OpenABE_ERROR_DECRYPTION_FAILED (or
+ *          another error code).
+ */
+OpenABE_ERROR
+OpenABEStreamDecryptor::finalize(OpenABEByteString& tag) {
+  OpenABE_ERROR result = OpenABE_NOERROR;
+
+  try {
+    /* make sure the stream was not finalized already */
+    ASSERT_NOTNULL(this->m_Stream.get());
+    OpenABEByteString lastBlock;
+    result = this->m_Stream->decryptFinalize(lastBlock, tag);
+  } catch (OpenABE_ERROR &error) {
+    result = error;
+  }
+  this->m_Stream.reset();
+
+  return result;
+}
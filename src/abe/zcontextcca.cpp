@@ -221,6 +221,7 @@ OpenABEContextGenericCCA::encryptKEM(const string &mpkID, const OpenABEFunctionI
   OpenABE_ERROR result = OpenABE_NOERROR;
   OpenABEByteString r, K, u, nonceU, concat;
   try {
+    OpenABE_initializeThreadContext();
     ASSERT_NOTNULL(encryptInput);
     ASSERT_NOTNULL(key);
 
@@ -278,6 +279,7 @@ OpenABEContextGenericCCA::decryptKEM(const string &mpkID, const string &keyID,
   OpenABEByteString u, nonceU, concat;
 
   try {
+    OpenABE_initializeThreadContext();
     // fully decrypt the ciphertext and recover 'r' and 'M'
     ASSERT_NOTNULL(key);
     result = this->abeSchemeContext->decrypt(mpkID, keyID, M, ciphertext);
@@ -501,6 +503,7 @@ OpenABEContextSchemeCCA::encrypt(const string &mpkID,
   OpenABEByteString ctHdr, symkeyBytes, iv, ct, tag;
 
   try {
+    OpenABE_initializeThreadContext();
     // make sure plaintext size > 0
     ASSERT(plaintext.size() > 0, OpenABE_ERROR_NO_PLAINTEXT_SPECIFIED);
 
@@ -554,6 +557,7 @@ OpenABEContextSchemeCCA::decrypt(const string &mpkID, const string &keyID,
   unique_ptr<OpenABESymKeyAuthEnc> authEnc = nullptr;
 
   try {
+    OpenABE_initializeThreadContext();
     iv = ciphertext2.getByteString("IV");
     ASSERT_NOTNULL(iv);
     ct = ciphertext2.getByteString("CT");
@@ -770,6 +774,7 @@ OpenABEContextSchemeCCAWithATZN::encrypt(const string &mpkID,
   OpenABEByteString ctBlob, ctHash, symkeyBytes;
 
   try {
+    OpenABE_initializeThreadContext();
     ASSERT_NOTNULL(encryptInput);
 
     result =
@@ -815,6 +820,7 @@ OpenABEContextSchemeCCAWithATZN::decrypt(const string &mpkID, const string &keyI
   OpenABEByteString ctBlob, ctHash, symkeyBytes;
 
   try {
+    OpenABE_initializeThreadContext();
     // decrypt part 1 of the ciphertext (corresponds to ABE portion)
     result = this->m_KEM_->decryptKEM(mpkID, keyID, ciphertext,
                                       DEFAULT_SYM_KEY_BYTES, symkey);
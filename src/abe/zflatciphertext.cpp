@@ -0,0 +1,358 @@
+/// 
+/// Copyright (c) 2018 Zeutro, LLC. All rights reserved.
+/// 
+/// This file is part of Zeutro's OpenABE.
+/// 
+/// OpenABE is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU Affero General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+/// 
+/// OpenABE is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU Affero General Public License for more details.
+/// 
+/// You should have received a copy of the GNU Affero General Public
+/// License along with OpenABE. If not, see <http://www.gnu.org/licenses/>.
+/// 
+/// You can be released from the requirements of the GNU Affero General
+/// Public License and obtain additional features by purchasing a
+/// commercial license. Buying such a license is mandatory if you
+/// engage in commercial activities involving OpenABE that do not
+/// comply with the open source requirements of the GNU Affero General
+/// Public License. For more information on commerical licenses,
+/// visit <http://www.zeutro.com>.
+///
+/// \file   zflatciphertext.cpp
+///
+/// \brief  Writer and zero-copy reader for the flat ciphertext layout.
+///
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <abe_lsss.h>
+#include <abe/zflatciphertext.h>
+
+using namespace std;
+
+static void putUint16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)(v >> 8);
+  p[1] = (uint8_t)v;
+}
+
+static void putUint32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+}
+
+static uint16_t getUint16(const uint8_t *p) {
+  return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t getUint32(const uint8_t *p) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+         ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+/*!
+ * Raw points are fixed width for a given curve and compression setting
+ * (one byte for the point at infinity); a GT slot only has to be non-empty.
+ *
+ */
+static void checkSlotSize(uint8_t type, span<const uint8_t> data) {
+  size_t width = 0;
+  if (type == OpenABE_ELEMENT_G1) {
+    width = G1::getDefaultSize();
+  } else if (type == OpenABE_ELEMENT_G2) {
+    width = G2::getDefaultSize();
+  }
+  ASSERT(data.size() > 0 && (width == 0 || data.size() == 1 || data.size() == width),
+         OpenABE_ERROR_DESERIALIZATION_FAILED);
+}
+
+/*!
+ * Read a ZP slot and reduce it modulo the group order.
+ *
+ */
+static void readZP(ZP &z, span<const uint8_t> data, const bignum_t order) {
+  ASSERT(data.size() > 0 && data.size() <= UINT16_MAX, OpenABE_ERROR_DESERIALIZATION_FAILED);
+  z.setOrder(order);
+  zmbignum_fromBin(z.m_ZP, data.data(), data.size());
+  if (zmbignum_cmp(z.m_ZP, z.order) != BN_CMP_LT) {
+    zmbignum_mod(z.m_ZP, z.order);
+  }
+}
+
+/*!
+ * Writes the components of a container in the flat layout described in
+ * zflatciphertext.h. Group elements are stored as raw bytes, everything
+ * else in its tagged serialized form.
+ *
+ * @param[in]   library version of the header.
+ * @param[in]   algorithm ID of the header.
+ * @param[in]   UID of the ciphertext (UID_LEN bytes).
+ * @param[in]   the components, in name order.
+ * @param[out]  the flat blob.
+ */
+void OpenABE_exportFlatContainer(uint8_t libraryVersion, uint8_t algorithmID,
+                                 const OpenABEByteString &uid,
+                                 const map<string, ZObject*> &components,
+                                 OpenABEByteString &output) {
+  ASSERT(uid.size() == UID_LEN, OpenABE_ERROR_INVALID_CIPHERTEXT_HEADER);
+  vector<uint8_t> types;
+  vector<OpenABEByteString> slots(components.size());
+  size_t namesLen = 0, dataLen = 0, i = 0;
+  types.reserve(components.size());
+
+  for (auto it = components.begin(); it != components.end(); ++it, i++) {
+    ASSERT(it->first.size() <= UINT16_MAX, OpenABE_ERROR_SERIALIZATION_FAILED);
+    OpenABEByteString &slot = slots[i];
+    uint8_t *bytes = nullptr;
+    int len = 0;
+    if (ZP *z = dynamic_cast<ZP*>(it->second)) {
+      types.push_back(OpenABE_ELEMENT_ZP);
+      slot = z->getByteString();
+    } else if (G1 *g = dynamic_cast<G1*>(it->second)) {
+      types.push_back(OpenABE_ELEMENT_G1);
+      bytes = g->getBytes(&len);
+    } else if (G2 *g = dynamic_cast<G2*>(it->second)) {
+      types.push_back(OpenABE_ELEMENT_G2);
+      bytes = g->getBytes(&len);
+    } else if (GT *g = dynamic_cast<GT*>(it->second)) {
+      types.push_back(OpenABE_ELEMENT_GT);
+      bytes = g->getBytes(&len);
+    } else {
+      it->second->serialize(slot);
+      ASSERT(slot.size() > 0, OpenABE_ERROR_SERIALIZATION_FAILED);
+      types.push_back(slot.at(0));
+    }
+    if (bytes != nullptr) {
+      slot.appendArray(bytes, len);
+      free(bytes);
+    }
+    namesLen += it->first.size();
+    dataLen += slot.size();
+  }
+
+  size_t tableLen = components.size() * OpenABE_FLAT_CT_ENTRY_LEN;
+  size_t total = OpenABE_FLAT_CT_HEADER_LEN + tableLen + namesLen + dataLen;
+  ASSERT(total <= UINT32_MAX, OpenABE_ERROR_SERIALIZATION_FAILED);
+  output.clear();
+  output.resize(total, 0);
+  uint8_t *out = output.data();
+
+  memcpy(out, OpenABE_FLAT_CT_MAGIC, OpenABE_FLAT_CT_MAGIC_LEN);
+  out[OpenABE_FLAT_CT_MAGIC_LEN] = OpenABE_FLAT_CT_VERSION;
+  out[OpenABE_FLAT_CT_MAGIC_LEN + 1] = libraryVersion;
+  out[OpenABE_FLAT_CT_MAGIC_LEN + 2] = algorithmID;
+  memcpy(out + OpenABE_FLAT_CT_MAGIC_LEN + 4, uid.data(), UID_LEN);
+  putUint32(out + OpenABE_FLAT_CT_HEADER_LEN - 4, components.size());
+
+  size_t nameOffset = OpenABE_FLAT_CT_HEADER_LEN + tableLen;
+  size_t dataOffset = nameOffset + namesLen;
+  i = 0;
+  for (auto it = components.begin(); it != components.end(); ++it, i++) {
+    uint8_t *e = out + OpenABE_FLAT_CT_HEADER_LEN + i * OpenABE_FLAT_CT_ENTRY_LEN;
+    e[0] = types[i];
+    putUint16(e + 2, it->first.size());
+    putUint32(e + 4, nameOffset);
+    putUint32(e + 8, dataOffset);
+    putUint32(e + 12, slots[i].size());
+    memcpy(out + nameOffset, it->first.data(), it->first.size());
+    if (slots[i].size() > 0) {
+      memcpy(out + dataOffset, slots[i].data(), slots[i].size());
+    }
+    nameOffset += it->first.size();
+    dataOffset += slots[i].size();
+  }
+}
+
+/********************************************************************************
+ * Implementation of the OpenABEFlatCiphertextReader class
+ ********************************************************************************/
+
+/*!
+ * Checks the header and every table entry against the size of the input,
+ * and that the names are strictly increasing. No element is decoded and
+ * nothing is copied.
+ *
+ * @param[in]   the flat ciphertext.
+ */
+OpenABEFlatCiphertextReader::OpenABEFlatCiphertextReader(span<const uint8_t> input)
+    : m_Input(input), m_Count(0) {
+  if (!isFlatFormat(input) || this->getFormatVersion() != OpenABE_FLAT_CT_VERSION) {
+    throw OpenABE_ERROR_INVALID_CIPHERTEXT_HEADER;
+  }
+  ASSERT(this->getLibraryVersion() <= OpenABE_LIBRARY_VERSION, OpenABE_ERROR_INVALID_LIBVERSION);
+
+  size_t count = getUint32(input.data() + OpenABE_FLAT_CT_HEADER_LEN - 4);
+  ASSERT(count <= (input.size() - OpenABE_FLAT_CT_HEADER_LEN) / OpenABE_FLAT_CT_ENTRY_LEN,
+         OpenABE_ERROR_INVALID_CIPHERTEXT_BODY);
+  this->m_Count = count;
+
+  for (size_t i = 0; i < count; i++) {
+    const uint8_t *e = this->entry(i);
+    size_t nameLen = getUint16(e + 2), nameOffset = getUint32(e + 4);
+    size_t dataOffset = getUint32(e + 8), dataLen = getUint32(e + 12);
+    ASSERT(nameOffset <= input.size() && nameLen <= input.size() - nameOffset,
+           OpenABE_ERROR_INVALID_CIPHERTEXT_BODY);
+    ASSERT(dataOffset <= input.size() && dataLen <= input.size() - dataOffset,
+           OpenABE_ERROR_INVALID_CIPHERTEXT_BODY);
+    ASSERT(i == 0 || this->getName(i - 1) < this->getName(i),
+           OpenABE_ERROR_INVALID_CIPHERTEXT_BODY);
+  }
+}
+
+bool OpenABEFlatCiphertextReader::isFlatFormat(span<const uint8_t> input) {
+  return input.size() >= OpenABE_FLAT_CT_HEADER_LEN &&
+         memcmp(input.data(), OpenABE_FLAT_CT_MAGIC, OpenABE_FLAT_CT_MAGIC_LEN) == 0;
+}
+
+string_view OpenABEFlatCiphertextReader::getName(size_t i) const {
+  const uint8_t *e = this->entry(i);
+  return string_view((const char *)this->m_Input.data() + getUint32(e + 4), getUint16(e + 2));
+}
+
+uint8_t OpenABEFlatCiphertextReader::getType(size_t i) const {
+  return this->entry(i)[0];
+}
+
+span<const uint8_t> OpenABEFlatCiphertextReader::getData(size_t i) const {
+  const uint8_t *e = this->entry(i);
+  return this->m_Input.subspan(getUint32(e + 8), getUint32(e + 12));
+}
+
+/*!
+ * Binary search over the sorted component table.
+ *
+ * @return the index of the component, or numComponents() if missing.
+ */
+size_t OpenABEFlatCiphertextReader::find(string_view name) const {
+  size_t lo = 0, hi = this->m_Count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    int cmp = this->getName(mid).compare(name);
+    if (cmp == 0) {
+      return mid;
+    } else if (cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return this->m_Count;
+}
+
+bool OpenABEFlatCiphertextReader::hasComponent(string_view name) const {
+  return this->find(name) < this->m_Count;
+}
+
+span<const uint8_t>
+OpenABEFlatCiphertextReader::getRawComponent(string_view name, uint8_t *type) const {
+  size_t i = this->find(name);
+  if (i == this->m_Count) {
+    cerr << "OpenABEFlatCiphertextReader: missing '" << name << "'" << endl;
+    throw OpenABE_ERROR_ELEMENT_NOT_FOUND;
+  }
+  if (type != nullptr) {
+    *type = this->getType(i);
+  }
+  return this->getData(i);
+}
+
+ZP OpenABEFlatCiphertextReader::getZP(string_view name, const bignum_t order) const {
+  uint8_t type = 0;
+  span<const uint8_t> data = this->getRawComponent(name, &type);
+  ASSERT(type == OpenABE_ELEMENT_ZP, OpenABE_ERROR_DESERIALIZATION_FAILED);
+  ZP z;
+  readZP(z, data, order);
+  return z;
+}
+
+G1 OpenABEFlatCiphertextReader::getG1(string_view name) const {
+  uint8_t type = 0;
+  span<const uint8_t> data = this->getRawComponent(name, &type);
+  ASSERT(type == OpenABE_ELEMENT_G1, OpenABE_ERROR_DESERIALIZATION_FAILED);
+  checkSlotSize(type, data);
+  return G1(const_cast<uint8_t*>(data.data()), data.size());
+}
+
+G2 OpenABEFlatCiphertextReader::getG2(string_view name) const {
+  uint8_t type = 0;
+  span<const uint8_t> data = this->getRawComponent(name, &type);
+  ASSERT(type == OpenABE_ELEMENT_G2, OpenABE_ERROR_DESERIALIZATION_FAILED);
+  checkSlotSize(type, data);
+  return G2(const_cast<uint8_t*>(data.data()), data.size());
+}
+
+GT OpenABEFlatCiphertextReader::getGT(string_view name) const {
+  uint8_t type = 0;
+  span<const uint8_t> data = this->getRawComponent(name, &type);
+  ASSERT(type == OpenABE_ELEMENT_GT, OpenABE_ERROR_DESERIALIZATION_FAILED);
+  checkSlotSize(type, data);
+  GT g;
+  gt_read_bin(g.m_GT, data.data(), data.size());
+  return g;
+}
+
+/********************************************************************************
+ * Implementation of the OpenABEFlatElement class
+ ********************************************************************************/
+
+/*!
+ * Tagged serialization of the component, as the container would produce
+ * it, so flat and smartPack ciphertexts compare and re-export alike.
+ *
+ * @param[out]  the serialized component.
+ */
+void OpenABEFlatElement::serialize(OpenABEByteString &result) const {
+  result.clear();
+  if (this->m_Type == OpenABE_ELEMENT_ZP) {
+    ASSERT(this->m_Data.size() <= UINT16_MAX, OpenABE_ERROR_INVALID_CIPHERTEXT_BODY);
+    result.push_back(this->m_Type);
+    result.pack16bits((uint16_t)this->m_Data.size());
+    result.appendArray(const_cast<uint8_t*>(this->m_Data.data()), this->m_Data.size());
+  } else if (this->m_Type == OpenABE_ELEMENT_G1 || this->m_Type == OpenABE_ELEMENT_G2 ||
+             this->m_Type == OpenABE_ELEMENT_GT) {
+    OpenABEByteString raw;
+    raw.appendArray(const_cast<uint8_t*>(this->m_Data.data()), this->m_Data.size());
+    result.push_back(this->m_Type);
+    result.smartPack(raw);
+  } else {
+    result.appendArray(const_cast<uint8_t*>(this->m_Data.data()), this->m_Data.size());
+  }
+}
+
+/*!
+ * Decode a group element straight from its slot.
+ *
+ * @param[in]   the group of the container (for the order of ZP elements).
+ * @return      the element, or nullptr for components that are kept in
+ *              their tagged serialization.
+ */
+ZObject* OpenABEFlatElement::decodeInPlace(const BPGroup *group) const {
+  uint8_t *data = const_cast<uint8_t*>(this->m_Data.data());
+  if (this->m_Type == OpenABE_ELEMENT_ZP) {
+    ASSERT(group != nullptr, OpenABE_ERROR_INVALID_GROUP_PARAMS);
+    unique_ptr<ZP> z(new ZP);
+    readZP(*z, this->m_Data, group->order);
+    return z.release();
+  } else if (this->m_Type == OpenABE_ELEMENT_G1) {
+    checkSlotSize(this->m_Type, this->m_Data);
+    return new G1(data, this->m_Data.size());
+  } else if (this->m_Type == OpenABE_ELEMENT_G2) {
+    checkSlotSize(this->m_Type, this->m_Data);
+    return new G2(data, this->m_Data.size());
+  } else if (this->m_Type == OpenABE_ELEMENT_GT) {
+    checkSlotSize(this->m_Type, this->m_Data);
+    unique_ptr<GT> g(new GT);
+    gt_read_bin(g->m_GT, data, this->m_Data.size());
+    return g.release();
+  }
+  return nullptr;
+}
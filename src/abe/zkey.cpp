@@ -127,18 +127,76 @@ OpenABEKey::exportKeyToBytes(OpenABEByteString &output) const {
 
 OpenABE_ERROR
 OpenABEKey::loadKeyFromBytes(OpenABEByteString &input) {
+  this->clearFixedBase();
   this->deserialize(input);
   return OpenABE_NOERROR;
 }
 
+/*!
+ * Obtain the fixed-base table for a G1 component of the key. The table is
+ * built on first use and shared by all subsequent callers.
+ *
+ * @param[in] name  - label of the G1 component (e.g., "g1", "g1a")
+ * @return          - the precomputed table
+ */
+shared_ptr<G1FixedBase> OpenABEKey::getG1FixedBase(const string &name) {
+  lock_guard<mutex> guard(this->fixedBase.lock);
+  auto it = this->fixedBase.g1Tables.find(name);
+  if (it != this->fixedBase.g1Tables.end()) {
+    return it->second;
+  }
+
+  G1 *base = this->getG1(name);
+  ASSERT_NOTNULL(base);
+  shared_ptr<G1FixedBase> table = make_shared<G1FixedBase>(*base);
+  this->fixedBase.g1Tables[name] = table;
+  return table;
+}
+
+/*!
+ * Obtain the fixed-base table for a G2 component of the key. The table is
+ * built on first use and shared by all subsequent callers.
+ *
+ * @param[in] name  - label of the G2 component (e.g., "g2")
+ * @return          - the precomputed table
+ */
+shared_ptr<G2FixedBase> OpenABEKey::getG2FixedBase(const string &name) {
+  lock_guard<mutex> guard(this->fixedBase.lock);
+  auto it = this->fixedBase.g2Tables.find(name);
+  if (it != this->fixedBase.g2Tables.end()) {
+    return it->second;
+  }
+
+  G2 *base = this->getG2(name);
+  ASSERT_NOTNULL(base);
+  shared_ptr<G2FixedBase> table = make_shared<G2FixedBase>(*base);
+  this->fixedBase.g2Tables[name] = table;
+  return table;
+}
+
+/*!
+ * Attach a fixed-base exponentiation table to every GT component of the key
+ * (e.g., "A" or "Y" in a master public key). GT::exp() on these components
+ * then uses the table instead of a generic exponentiation.
+ *
+ */
+void OpenABEKey::precomputeGTFixedBase() {
+  for (auto it = this->val.begin(); it != this->val.end(); ++it) {
+    GT *gt = dynamic_cast<GT*>(it->second);
+    if (gt != nullptr && !gt->hasFixedBase()) {
+      gt->setFixedBase(make_shared<GTFixedBase>(*gt));
+    }
+  }
+}
+
 void getRandomBytes(uint8_t *buf, size_t buf_len) {
-  rand_bytes(buf, buf_len);
+  OpenABERandom::getInstance().getBytes(buf, buf_len);
 }
 
 void getRandomBytes(OpenABEByteString &buf, size_t buf_len) {
   buf.clear();
   buf.fillBuffer(0, buf_len);
-  rand_bytes(buf.getInternalPtr(), buf_len);
+  OpenABERandom::getInstance().getBytes(buf.getInternalPtr(), buf_len);
 }
 
 void generateSymmetricKey(std::string& key, uint32_t keyLen) {
@@ -33,6 +33,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <cstdint>
 #include <iostream>
 #include <algorithm>
 #include <fstream>
@@ -46,6 +47,78 @@ std::unique_ptr<OpenABEFunctionInput> getFunctionInput(OpenABEKey *key);
 
 using namespace std;
 
+static void collectLeafLabels(OpenABETreeNode *node, set<string>& labels) {
+    if (node->getNodeType() == GATE_TYPE_LEAF) {
+        labels.insert(node->getCompleteLabel());
+        return;
+    }
+    for (uint32_t i = 0; i < node->getNumSubnodes(); i++) {
+        collectLeafLabels(node->getSubnode(i), labels);
+    }
+}
+
+/*!
+ * Summarize a policy subtree as clauses: every attribute list that
+ * satisfies the subtree holds at least one attribute of each clause. An
+ * AND gate contributes the clauses of all its subnodes; any other gate
+ * contributes one clause with all leaves below it.
+ *
+ * @param[in]   root of the policy subtree.
+ * @return      the clauses of the subtree.
+ */
+OpenABEPolicyClauses getPolicyClauses(OpenABETreeNode *node) {
+    OpenABEPolicyClauses clauses;
+    if (node == nullptr) {
+        return clauses;
+    }
+    if (node->getNodeType() == GATE_TYPE_AND) {
+        for (uint32_t i = 0; i < node->getNumSubnodes(); i++) {
+            OpenABEPolicyClauses sub = getPolicyClauses(node->getSubnode(i));
+            clauses.insert(clauses.end(), sub.begin(), sub.end());
+        }
+    } else {
+        set<string> labels;
+        collectLeafLabels(node, labels);
+        if (!labels.empty()) {
+            clauses.push_back(move(labels));
+        }
+    }
+    return clauses;
+}
+
+static bool hitsEveryClause(const set<string>& attributes, const OpenABEPolicyClauses& clauses) {
+    for (auto& clause : clauses) {
+        bool hit = false;
+        for (auto& attr : clause) {
+            if (attributes.count(attr) != 0) {
+                hit = true;
+                break;
+            }
+        }
+        if (!hit) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void erasePosting(unordered_map<string, set<string>>& postings,
+                         const string& attr, const string& keyID) {
+    auto it = postings.find(attr);
+    if (it != postings.end()) {
+        it->second.erase(keyID);
+        if (it->second.empty()) {
+            postings.erase(it);
+        }
+    }
+}
+
+// identifies the function input of a user's key, to reject duplicates
+static string getKeySignature(const string& userId, OpenABEFunctionInputType type,
+                              const string& compactInput) {
+    return userId + '\0' + to_string(type) + '\0' + compactInput;
+}
+
 #if 1
 /********************************************************************************
  * Implementation of the OpenABEKeystoreManager class
@@ -81,7 +154,7 @@ OpenABEKeystoreManager::storeWithKeyIDCommand(const string& userId, const std::s
     assert(userId != "");
 
     if (keyMetadata_.count(keyID) != 0) {
-    	keyMetadata_.erase(keyID);
+        removeKeyMetadata(keyID);
     }
 
     key = this->parseKeyHeader(keyID, keyBlob, outputKeyBytes);
@@ -89,8 +162,6 @@ OpenABEKeystoreManager::storeWithKeyIDCommand(const string& userId, const std::s
         THROW_ERROR(OpenABE_ERROR_INVALID_INPUT);
     }
 
-    bool foundAnExistingKey = false;
-    string funcInputStr, funcInputStrNew;
     OpenABE_SCHEME schemeID = OpenABE_getSchemeID(key->getAlgorithmID());
     // create the group object based on curve ID.
     std::shared_ptr<BPGroup> group(new BPGroup());
@@ -101,19 +172,10 @@ OpenABEKeystoreManager::storeWithKeyIDCommand(const string& userId, const std::s
         key->loadKeyFromBytes(outputKeyBytes);
         // check if input
         unique_ptr<OpenABEFunctionInput> keyInput = getFunctionInput(key.get());
-        funcInputStrNew = keyInput->toCompactString();
-        // search existing metadata (if available)
-        for (auto it = keyMetadata_.begin(); it != keyMetadata_.end(); it++) {
-            funcInputStr = it->second->input->toCompactString();
-            if (funcInputStr.compare(funcInputStrNew) == 0 // same func input & type
-                    && keyInput->getFunctionType() == it->second->input->getFunctionType()
-                    && userId.compare(it->second->userId) == 0) {
-                foundAnExistingKey = true;
-                break;
-            }
-        }
-
-        if (foundAnExistingKey) {
+        // same func input & type already stored for this user
+        const string signature = getKeySignature(userId, keyInput->getFunctionType(),
+                                                 keyInput->toCompactString());
+        if (keySignatures_.count(signature) != 0) {
             // no need to add key
             return false;
         }
@@ -126,7 +188,8 @@ OpenABEKeystoreManager::storeWithKeyIDCommand(const string& userId, const std::s
         metadata->inputType = keyInput->getFunctionType();
         metadata->input = move(keyInput);
         metadata->isCached = canCacheKey;
-        keyMetadata_[keyID] = metadata;
+        metadata->signature = signature;
+        addKeyMetadata(keyID, metadata);
         return true;
     }
     return false;
@@ -154,6 +217,80 @@ OpenABEKeystoreManager::storeWithKeyPrefixCommand(const string& userId, const st
     return "";
 }
 
+/*!
+ * Store the metadata of a key and add the key to the search index of its
+ * user: attribute list keys under each of their attributes, policy keys
+ * under the attributes of their smallest clause.
+ *
+ * @param[in]   the key identifier.
+ * @param[in]   the key metadata (userId, inputType and input must be set).
+ */
+void
+OpenABEKeystoreManager::addKeyMetadata(const string& keyID, OpenABEMetadata metadata) {
+    ASSERT_NOTNULL(metadata->input.get());
+    OpenABEKeyIndex& index = keyIndex_[metadata->userId];
+    if (metadata->inputType == FUNC_ATTRLIST_INPUT) {
+        const vector<string> *attrs = ((OpenABEAttributeList *) metadata->input.get())->getAttributeList();
+        metadata->attributes = set<string>(attrs->begin(), attrs->end());
+        for (auto& attr : metadata->attributes) {
+            index.attrKeys[attr].insert(keyID);
+        }
+    } else if (metadata->inputType == FUNC_POLICY_INPUT) {
+        metadata->clauses = getPolicyClauses(((OpenABEPolicy *) metadata->input.get())->getRootNode());
+        if (metadata->clauses.empty()) {
+            index.unindexedPolicyKeys.insert(keyID);
+        } else {
+            auto smallest = min_element(metadata->clauses.begin(), metadata->clauses.end(),
+                [](const set<string>& a, const set<string>& b) { return a.size() < b.size(); });
+            for (auto& attr : *smallest) {
+                index.policyKeys[attr].insert(keyID);
+            }
+        }
+    }
+    if (metadata->signature.empty()) {
+        metadata->signature = getKeySignature(metadata->userId, metadata->inputType,
+                                              metadata->input->toCompactString());
+    }
+    keySignatures_[metadata->signature] = keyID;
+    keyMetadata_[keyID] = metadata;
+}
+
+/*!
+ * Remove the metadata of a key and drop it from the search index.
+ *
+ * @param[in]   the key identifier.
+ */
+void
+OpenABEKeystoreManager::removeKeyMetadata(const string& keyID) {
+    auto it = keyMetadata_.find(keyID);
+    if (it == keyMetadata_.end()) {
+        return;
+    }
+    OpenABEMetadata& metadata = it->second;
+    auto indexIt = keyIndex_.find(metadata->userId);
+    if (indexIt != keyIndex_.end()) {
+        OpenABEKeyIndex& index = indexIt->second;
+        for (auto& attr : metadata->attributes) {
+            erasePosting(index.attrKeys, attr, keyID);
+        }
+        for (auto& clause : metadata->clauses) {
+            for (auto& attr : clause) {
+                erasePosting(index.policyKeys, attr, keyID);
+            }
+        }
+        index.unindexedPolicyKeys.erase(keyID);
+        if (index.attrKeys.empty() && index.policyKeys.empty() &&
+            index.unindexedPolicyKeys.empty()) {
+            keyIndex_.erase(indexIt);
+        }
+    }
+    auto sigIt = keySignatures_.find(metadata->signature);
+    if (sigIt != keySignatures_.end() && sigIt->second == keyID) {
+        keySignatures_.erase(sigIt);
+    }
+    keyMetadata_.erase(it);
+}
+
 int OpenABEKeystoreManager::getUserKeyCount(const std::string& userId) {
     return keyCounter_[userId];
 }
@@ -228,6 +365,80 @@ OpenABEKeystoreManager::getKeyIds(const std::string& userId, uint64_t currentTim
     return keyList;
 }
 
+/*!
+ * Keys of a user that can possibly match the function input of a
+ * ciphertext, in key identifier order. For a ciphertext policy, the
+ * attribute list keys are looked up through the clause of the policy with
+ * the fewest keys, then checked against the other clauses. For a
+ * ciphertext attribute list, the policy keys indexed under one of its
+ * attributes are checked against all their clauses. Candidates still have
+ * to be tested with testAKey.
+ *
+ * @param[in]   the user identifier.
+ * @param[in]   the function input of the ciphertext.
+ * @return      the candidate key identifiers.
+ */
+vector<string>
+OpenABEKeystoreManager::findCandidateKeys(const string& userId, OpenABEFunctionInput *funcInput) {
+    set<string> candidates;
+    auto indexIt = keyIndex_.find(userId);
+    if (userId == "" || indexIt == keyIndex_.end()) {
+        return vector<string>();
+    }
+    OpenABEKeyIndex& index = indexIt->second;
+
+    if (funcInput->getFunctionType() == FUNC_POLICY_INPUT) {
+        OpenABEPolicyClauses clauses = getPolicyClauses(((OpenABEPolicy *) funcInput)->getRootNode());
+        if (clauses.empty()) {
+            // nothing to prune on
+            return filterKeys(userId, funcInput->getFunctionType());
+        }
+        size_t best = 0, bestCount = SIZE_MAX;
+        for (size_t i = 0; i < clauses.size(); i++) {
+            size_t count = 0;
+            for (auto& attr : clauses[i]) {
+                auto postings = index.attrKeys.find(attr);
+                if (postings != index.attrKeys.end()) {
+                    count += postings->second.size();
+                }
+            }
+            if (count < bestCount) {
+                best = i;
+                bestCount = count;
+            }
+        }
+        for (auto& attr : clauses[best]) {
+            auto postings = index.attrKeys.find(attr);
+            if (postings == index.attrKeys.end()) {
+                continue;
+            }
+            for (auto& keyID : postings->second) {
+                if (hitsEveryClause(keyMetadata_[keyID]->attributes, clauses)) {
+                    candidates.insert(keyID);
+                }
+            }
+        }
+    } else if (funcInput->getFunctionType() == FUNC_ATTRLIST_INPUT) {
+        const vector<string> *attrs = ((OpenABEAttributeList *) funcInput)->getAttributeList();
+        const set<string> attributes(attrs->begin(), attrs->end());
+        for (auto& attr : attributes) {
+            auto postings = index.policyKeys.find(attr);
+            if (postings == index.policyKeys.end()) {
+                continue;
+            }
+            for (auto& keyID : postings->second) {
+                if (hitsEveryClause(attributes, keyMetadata_[keyID]->clauses)) {
+                    candidates.insert(keyID);
+                }
+            }
+        }
+        candidates.insert(index.unindexedPolicyKeys.begin(), index.unindexedPolicyKeys.end());
+    } else {
+        return filterKeys(userId, funcInput->getFunctionType());
+    }
+    return vector<string>(candidates.begin(), candidates.end());
+}
+
 void
 OpenABEKeystoreManager::rankKeyAlgorithm(vector<string>& keyIDs, OpenABEKeyQuery* query) {
     /* do nothing for now */
@@ -290,6 +501,7 @@ OpenABEKeystoreManager::deleteKeyCommand(OpenABEKeyQuery* query) {
     for (size_t i = 0; i < keyList.size(); i++) {
         //cout << "Delete key with Id: " << keyList[i] << " for " << query->userId << endl;
         this->deleteKey(keyList[i]);
+        this->removeKeyMetadata(keyList[i]);
     }
     return keyList;
 }
@@ -299,8 +511,8 @@ OpenABEKeystoreManager::searchKey(OpenABEKeyQuery* query, OpenABEFunctionInput *
     ASSERT_NOTNULL(query);
     ASSERT_NOTNULL(funcInput);
     vector<KeyRef> satKeys;
-    // initial set of keys that are available that could satisfy the input ciphertext
-    vector<string> keyRefs = filterKeys(query->userId, funcInput->getFunctionType());
+    // initial set of keys that could satisfy the input ciphertext (from the index)
+    vector<string> keyRefs = findCandidateKeys(query->userId, funcInput);
     // rank/sort keys based on the contents of the query
     rankKeyAlgorithm(keyRefs, query);
     // test and evaluat each key
@@ -37,6 +37,8 @@
 #include <stdlib.h>
 #include <iostream>
 #include <fstream>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <assert.h>
 
@@ -66,26 +68,18 @@ OpenABEKeystore::OpenABEKeystore(): ZObject()
 
 OpenABEKeystore::~OpenABEKeystore()
 {
-  std::map<std::string, shared_ptr<OpenABEKey>>::iterator iter;
-  for (iter = this->pubKeys.begin(); iter != this->pubKeys.end(); ++iter) {
-      // delete iter->second;
-      shared_ptr<OpenABEKey> key = iter->second;
-      if (key != nullptr) {
-          key->zeroize(); // securely zeroize the keys
-          key.reset(); // deletes the managed object
-      }
-  }
-  this->pubKeys.clear();
-
-  for (iter = this->secKeys.begin(); iter != this->secKeys.end(); ++iter) {
-      // delete iter->second;
-      shared_ptr<OpenABEKey> key = iter->second;
-      if (key != nullptr) {
+  for (Shard& shard : this->shards) {
+    for (OpenABEKeyMap *keys : {&shard.pubKeys, &shard.secKeys}) {
+      for (auto iter = keys->begin(); iter != keys->end(); ++iter) {
+        shared_ptr<OpenABEKey> key = iter->second;
+        if (key != nullptr) {
           key->zeroize(); // securely zeroize the keys
           key.reset(); // deletes the managed object
+        }
       }
+      keys->clear();
+    }
   }
-  this->secKeys.clear();
 }
 
 /*!
@@ -98,13 +92,15 @@ OpenABEKeystore::~OpenABEKeystore()
 OpenABE_ERROR
 OpenABEKeystore::addKey(const string name, const shared_ptr<OpenABEKey>& component, zKeyType keyType)
 {
+    Shard& shard = this->getShard(name);
+    unique_lock<shared_mutex> guard(shard.lock);
     // Insert the key into the public or secret key maps
     if (keyType == KEY_TYPE_PUBLIC) {
         // Public key/parameter
-        this->pubKeys[name] = component;
+        shard.pubKeys[name] = component;
     } else if (keyType == KEY_TYPE_SECRET){
         // Secret key/parameter
-        this->secKeys[name] = component;
+        shard.secKeys[name] = component;
     }
     return OpenABE_NOERROR;
 }
@@ -119,17 +115,18 @@ OpenABEKeystore::addKey(const string name, const shared_ptr<OpenABEKey>& compone
 
 shared_ptr<OpenABEKey>
 OpenABEKeystore::getKey(const string keyID) {
-    shared_ptr<OpenABEKey> result = nullptr;
+    Shard& shard = this->getShard(keyID);
+    shared_lock<shared_mutex> guard(shard.lock);
 
     // Look in the public keys list
-    result = this->pubKeys[keyID];
-    if (result != nullptr) {
-        return result;
+    auto iter = shard.pubKeys.find(keyID);
+    if (iter != shard.pubKeys.end() && iter->second != nullptr) {
+        return iter->second;
     }
     // Look in the secret keys list
-    result = this->secKeys[keyID];
-    if (result != nullptr) {
-        return result;
+    iter = shard.secKeys.find(keyID);
+    if (iter != shard.secKeys.end()) {
+        return iter->second;
     }
     // Did not find the selected key
     return nullptr;
@@ -144,9 +141,9 @@ OpenABEKeystore::getKey(const string keyID) {
  */
 bool
 OpenABEKeystore::checkSecretKey(const string keyID) {
-    if(this->secKeys.count(keyID) != 0)
-        return true;
-    return false;
+    Shard& shard = this->getShard(keyID);
+    shared_lock<shared_mutex> guard(shard.lock);
+    return shard.secKeys.count(keyID) != 0;
 }
 
 
@@ -159,12 +156,13 @@ OpenABEKeystore::checkSecretKey(const string keyID) {
 
 shared_ptr<OpenABEKey>
 OpenABEKeystore::getPublicKey(const string keyID) {
-    shared_ptr<OpenABEKey> result;
+    Shard& shard = this->getShard(keyID);
+    shared_lock<shared_mutex> guard(shard.lock);
 
     // Look in the public keys list
-    result = this->pubKeys[keyID];
-    if (result != NULL) {
-        return result;
+    auto iter = shard.pubKeys.find(keyID);
+    if (iter != shard.pubKeys.end()) {
+        return iter->second;
     }
     // Did not find the selected key
     return nullptr;
@@ -179,12 +177,13 @@ OpenABEKeystore::getPublicKey(const string keyID) {
 
 shared_ptr<OpenABEKey>
 OpenABEKeystore::getSecretKey(const string keyID) {
-    shared_ptr<OpenABEKey> result;
+    Shard& shard = this->getShard(keyID);
+    shared_lock<shared_mutex> guard(shard.lock);
 
     // Look in the secret keys list
-    result = this->secKeys[keyID];
-    if (result != nullptr) {
-        return result;
+    auto iter = shard.secKeys.find(keyID);
+    if (iter != shard.secKeys.end()) {
+        return iter->second;
     }
     // Did not find the selected key
     return nullptr;
@@ -201,9 +200,11 @@ const vector<string>
 OpenABEKeystore::getSecretKeyIDs() const {
     vector<string> keyRefs;
 
-    std::map<std::string, shared_ptr<OpenABEKey>>::const_iterator iter;
-    for (iter = this->secKeys.begin(); iter != this->secKeys.end(); ++iter) {
-        keyRefs.push_back(iter->first);
+    for (const Shard& shard : this->shards) {
+        shared_lock<shared_mutex> guard(shard.lock);
+        for (auto iter = shard.secKeys.begin(); iter != shard.secKeys.end(); ++iter) {
+            keyRefs.push_back(iter->first);
+        }
     }
     // list will be empty if no secret keys in the keystore
     return keyRefs;
@@ -220,30 +221,24 @@ OpenABEKeystore::getSecretKeyIDs() const {
 
 OpenABE_ERROR
 OpenABEKeystore::deleteKey(const string keyID) {
-    // Find the key and destroy it
-    shared_ptr<OpenABEKey> key = this->getKey(keyID);
-    if (key != nullptr) {
-        key->zeroize();
-        bool foundInPubKey = false, foundInSecKey = false;
-        // Remove key/value from our internal store via the iterator
-        map<string, shared_ptr<OpenABEKey>>::iterator iter1 = this->pubKeys.find(keyID);
-        map<string, shared_ptr<OpenABEKey>>::iterator iter2 = this->secKeys.find(keyID);
-
-        if(iter1 != this->pubKeys.end()) {
-            this->pubKeys.erase(iter1);
-            foundInPubKey = true;
-        }
+    Shard& shard = this->getShard(keyID);
+    unique_lock<shared_mutex> guard(shard.lock);
 
-        if(iter2 != this->secKeys.end()) {
-            this->secKeys.erase(iter2);
-            foundInSecKey = true;
+    // Find the key and destroy it
+    auto iter1 = shard.pubKeys.find(keyID);
+    auto iter2 = shard.secKeys.find(keyID);
+    if(iter1 != shard.pubKeys.end()) {
+        if (iter1->second != nullptr) {
+            iter1->second->zeroize();
         }
+        shard.pubKeys.erase(iter1);
+    }
 
-        // make sure key existed in one of two lists
-        // otherwise return an invalid key error
-        if(!foundInPubKey && !foundInSecKey) {
-            return OpenABE_ERROR_INVALID_KEY;
+    if(iter2 != shard.secKeys.end()) {
+        if (iter2->second != nullptr) {
+            iter2->second->zeroize();
         }
+        shard.secKeys.erase(iter2);
     }
     return OpenABE_NOERROR;
 }
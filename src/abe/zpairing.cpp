@@ -143,6 +143,18 @@ OpenABEPairing::randomZP()
   return result;
 }
 
+/*!
+ * Generate count random elements in ZP in a single batch.
+ *
+ * @param[in]   number of elements.
+ * @return      the elements.
+ */
+vector<ZP>
+OpenABEPairing::randomZPs(size_t count)
+{
+  return OpenABE_randomZPs(count, this->order);
+}
+
 /*!
  * Generate and return a random group element in G1.
  *
@@ -178,11 +190,19 @@ OpenABEPairing::hashToG1(OpenABEByteString& keyPrefix, string msg)
   // append the message
   tmp += msg;
 
+  // the hash input identifies the point, so it doubles as the cache key
+  OpenABEHashToG1Cache& cache = OpenABEHashToG1Cache::getInstance();
+  string cacheKey((const char *)tmp.getInternalPtr(), tmp.size());
+  G1 g1;
+  if (cache.lookup(cacheKey, g1)) {
+    return g1;
+  }
+
   uint8_t digest[RLC_MD_LEN];
   _hash_to_bytes_(digest, tmp.getInternalPtr(), tmp.size());
 
-  G1 g1;
   g1_map(g1.m_G1, digest, RLC_MD_LEN);
+  cache.insert(cacheKey, g1);
   return g1;
 }
 
@@ -239,8 +259,8 @@ OpenABEPairing::hashFromBytes(OpenABEByteString &buf, uint32_t target_len, uint8
   int block_len = ceil(((double)target_len) / (uint32_t)RLC_MD_LEN);
   // set the hash_len
   int hash_len = block_len * RLC_MD_LEN;
-  uint8_t hash[hash_len+1];
-  memset(hash, 0, hash_len+1);
+  // on the heap: target_len can be as large as the payload
+  vector<uint8_t> hash(hash_len+1, 0);
 
   OpenABEByteString buf2 = buf;
   uint8_t count = 0;
@@ -248,7 +268,7 @@ OpenABEPairing::hashFromBytes(OpenABEByteString &buf, uint32_t target_len, uint8
   buf2.insertFirstByte(hash_prefix);
   buf2.insertFirstByte(count);
   uint8_t *ptr = buf2.getInternalPtr();
-  uint8_t *hash_ptr = hash;
+  uint8_t *hash_ptr = hash.data();
 
   for(int i = 0; i < block_len; i++) {
     // H(count || hash_prefix || buf)
@@ -259,7 +279,137 @@ OpenABEPairing::hashFromBytes(OpenABEByteString &buf, uint32_t target_len, uint8
   }
 
   OpenABEByteString b;
-  b.appendArray(hash, target_len);
+  b.appendArray(hash.data(), target_len);
   return b;
 }
 
+
+/********************************************************************************
+ * Implementation of the OpenABEHashToG1Cache class
+ ********************************************************************************/
+
+/*!
+ * Constructor for the OpenABEHashToG1Cache class.
+ *
+ */
+OpenABEHashToG1Cache::OpenABEHashToG1Cache()
+    : m_MaxBytes(DEFAULT_HASH_TO_G1_CACHE_BYTES), m_Bytes(0),
+      m_Hits(0), m_Misses(0), m_Evictions(0) {}
+
+/*!
+ * Return the process-wide hash_to_G1 cache.
+ *
+ */
+OpenABEHashToG1Cache&
+OpenABEHashToG1Cache::getInstance() {
+  static OpenABEHashToG1Cache instance;
+  return instance;
+}
+
+/*!
+ * Approximate memory used by one entry: the key, the point and the
+ * list/index bookkeeping.
+ *
+ * @param[in]   the cache key.
+ * @return      size in bytes.
+ */
+size_t
+OpenABEHashToG1Cache::entrySize(const string &key) {
+  return 2 * key.size() + sizeof(Entry) + 4 * sizeof(void *);
+}
+
+/*!
+ * Look up a point and mark it as recently used.
+ *
+ * @param[in]   the cache key (hash key prefix || attribute).
+ * @param[out]  the cached point.
+ * @return      true on a hit.
+ */
+bool
+OpenABEHashToG1Cache::lookup(const string &key, G1 &point) {
+  lock_guard<mutex> lock(this->m_Lock);
+  auto it = this->m_Index.find(key);
+  if (it == this->m_Index.end()) {
+    this->m_Misses++;
+    return false;
+  }
+  this->m_Entries.splice(this->m_Entries.begin(), this->m_Entries, it->second);
+  point = it->second->second;
+  this->m_Hits++;
+  return true;
+}
+
+/*!
+ * Add a point, evicting the least recently used entries if the byte
+ * budget is exceeded.
+ *
+ * @param[in]   the cache key (hash key prefix || attribute).
+ * @param[in]   the point.
+ */
+void
+OpenABEHashToG1Cache::insert(const string &key, const G1 &point) {
+  lock_guard<mutex> lock(this->m_Lock);
+  if (entrySize(key) > this->m_MaxBytes || this->m_Index.count(key) != 0) {
+    return;
+  }
+  this->m_Entries.emplace_front(key, point);
+  this->m_Index[key] = this->m_Entries.begin();
+  this->m_Bytes += entrySize(key);
+  this->evict();
+}
+
+/*!
+ * Drop the least recently used entries until the cache fits its budget.
+ * The caller must hold the cache lock.
+ *
+ */
+void
+OpenABEHashToG1Cache::evict() {
+  while (this->m_Bytes > this->m_MaxBytes && !this->m_Entries.empty()) {
+    const string &key = this->m_Entries.back().first;
+    this->m_Bytes -= entrySize(key);
+    this->m_Index.erase(key);
+    this->m_Entries.pop_back();
+    this->m_Evictions++;
+  }
+}
+
+/*!
+ * Set the memory budget of the cache (0 disables caching).
+ *
+ * @param[in]   the budget in bytes.
+ */
+void
+OpenABEHashToG1Cache::setMaxBytes(size_t maxBytes) {
+  lock_guard<mutex> lock(this->m_Lock);
+  this->m_MaxBytes = maxBytes;
+  this->evict();
+}
+
+OpenABECacheStats
+OpenABEHashToG1Cache::getStats() {
+  lock_guard<mutex> lock(this->m_Lock);
+  OpenABECacheStats stats;
+  stats.hits      = this->m_Hits;
+  stats.misses    = this->m_Misses;
+  stats.evictions = this->m_Evictions;
+  stats.entries   = this->m_Entries.size();
+  stats.bytes     = this->m_Bytes;
+  stats.maxBytes  = this->m_MaxBytes;
+  return stats;
+}
+
+void
+OpenABEHashToG1Cache::resetStats() {
+  this->m_Hits = 0;
+  this->m_Misses = 0;
+  this->m_Evictions = 0;
+}
+
+void
+OpenABEHashToG1Cache::clear() {
+  lock_guard<mutex> lock(this->m_Lock);
+  this->m_Index.clear();
+  this->m_Entries.clear();
+  this->m_Bytes = 0;
+}
@@ -0,0 +1,298 @@
+/// 
+/// Copyright (c) 2018 Zeutro, LLC. All rights reserved.
+/// 
+/// This file is part of Zeutro's OpenABE.
+/// 
+/// OpenABE is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU Affero General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+/// 
+/// OpenABE is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU Affero General Public License for more details.
+/// 
+/// You should have received a copy of the GNU Affero General Public
+/// License along with OpenABE. If not, see <http://www.gnu.org/licenses/>.
+/// 
+/// You can be released from the requirements of the GNU Affero General
+/// Public License and obtain additional features by purchasing a
+/// commercial license. Buying such a license is mandatory if you
+/// engage in commercial activities involving OpenABE that do not
+/// comply with the open source requirements of the GNU Affero General
+/// Public License. For more information on commerical licenses,
+/// visit <http://www.zeutro.com>.
+///
+/// \file   zprecompute.cpp
+///
+/// \brief  Implementation of the pool of precomputed encryption
+///         randomness used by online/offline encryption.
+///
+
+#include <chrono>
+#include <vector>
+
+#include <abe_lsss.h>
+
+using namespace std;
+
+/********************************************************************************
+ * Implementation of the OpenABEPrecomputePool class
+ ********************************************************************************/
+
+OpenABEPrecomputePool::OpenABEPrecomputePool(const GT &A,
+                                             const shared_ptr<G1FixedBase> &g1,
+                                             const shared_ptr<G1FixedBase> &g1a,
+                                             const shared_ptr<G2FixedBase> &g2,
+                                             bignum_t order,
+                                             const OpenABEPrecomputeSettings &settings)
+    : A(A), g1(g1), g1a(g1a), g2(g2), order(order), settings(settings) {
+  ASSERT_NOTNULL(g1.get());
+  ASSERT_NOTNULL(g1a.get());
+  ASSERT_NOTNULL(g2.get());
+  if (this->settings.refillBatch == 0) {
+    this->settings.refillBatch = 1;
+  }
+  this->stopping = false;
+  this->resetStats();
+}
+
+OpenABEPrecomputePool::~OpenABEPrecomputePool() {
+  this->stop();
+}
+
+/*!
+ * Start the background thread that keeps the pool filled. Without
+ * thread support in RELIC the pool is only filled by refill().
+ */
+void OpenABEPrecomputePool::start() {
+#if OpenABE_THREADS_SUPPORTED
+  lock_guard<mutex> guard(this->lock);
+  if (this->worker.joinable()) {
+    return;
+  }
+  this->stopping = false;
+  this->worker = thread(&OpenABEPrecomputePool::refillLoop, this);
+#endif
+}
+
+/*!
+ * Stop the background thread (if any). Tuples already in the pool stay
+ * available.
+ */
+void OpenABEPrecomputePool::stop() {
+  {
+    lock_guard<mutex> guard(this->lock);
+    this->stopping = true;
+  }
+  this->wake.notify_all();
+  if (this->worker.joinable()) {
+    this->worker.join();
+  }
+}
+
+ZP OpenABEPrecomputePool::randomZP() {
+  ZP result;
+  result.setRandom(this->order);
+  return result;
+}
+
+// caller holds the lock
+bool OpenABEPrecomputePool::needsRefill() {
+  if (this->sessions.size() < this->settings.sessionDepth ||
+      this->shares.size() < this->settings.shareDepth) {
+    return true;
+  }
+  for (auto &slot : this->attributes) {
+    if (slot.second.tuples.size() < this->settings.attributeDepth) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*!
+ * Compute up to maxTuples tuples for the parts of the pool that are below
+ * their depth, on the calling thread. The group operations run without
+ * holding the lock, so encryptions keep taking tuples meanwhile.
+ *
+ * @param[in]   maximum number of tuples to compute.
+ * @return      the number of tuples added.
+ */
+size_t OpenABEPrecomputePool::refill(size_t maxTuples) {
+  size_t needSessions, needShares;
+  vector<pair<string, G1>> needAttributes;
+  {
+    lock_guard<mutex> guard(this->lock);
+    size_t budget = maxTuples;
+    needSessions = min(budget, this->settings.sessionDepth - min(this->settings.sessionDepth, this->sessions.size()));
+    budget -= needSessions;
+    needShares = min(budget, this->settings.shareDepth - min(this->settings.shareDepth, this->shares.size()));
+    budget -= needShares;
+    for (auto &slot : this->attributes) {
+      size_t missing = this->settings.attributeDepth -
+                       min(this->settings.attributeDepth, slot.second.tuples.size());
+      for (size_t i = 0; i < missing && budget > 0; i++, budget--) {
+        needAttributes.push_back(make_pair(slot.first, slot.second.hashedPoint));
+      }
+    }
+  }
+
+  // draw the scalars for the whole batch in one pass
+  size_t needScalars = needSessions + needShares + needAttributes.size();
+  vector<ZP> scalars = OpenABE_randomZPs(needScalars, this->order.m_ZP);
+  size_t next = 0;
+  vector<OpenABEPrecomputedSession> newSessions;
+  for (size_t i = 0; i < needSessions; i++) {
+    ZP &s = scalars[next++];
+    newSessions.push_back({s, this->A.exp(s), *this->g1 * s});
+  }
+  vector<OpenABEPrecomputedShare> newShares;
+  for (size_t i = 0; i < needShares; i++) {
+    ZP &lambda = scalars[next++];
+    newShares.push_back({lambda, *this->g1a * lambda});
+  }
+  vector<OpenABEPrecomputedAttribute> newAttributes;
+  for (auto &attr : needAttributes) {
+    ZP &r = scalars[next++];
+    newAttributes.push_back({r, *this->g2 * r, attr.second * (-r)});
+  }
+
+  lock_guard<mutex> guard(this->lock);
+  for (auto &session : newSessions) {
+    this->sessions.push_back(session);
+  }
+  for (auto &share : newShares) {
+    this->shares.push_back(share);
+  }
+  for (size_t i = 0; i < newAttributes.size(); i++) {
+    // the attribute may have been evicted in the meantime
+    auto slot = this->attributes.find(needAttributes[i].first);
+    if (slot != this->attributes.end()) {
+      slot->second.tuples.push_back(newAttributes[i]);
+    }
+  }
+  size_t added = newSessions.size() + newShares.size() + newAttributes.size();
+  this->stats.produced += added;
+  return added;
+}
+
+void OpenABEPrecomputePool::refillLoop() {
+  OpenABEStateContext state;
+  while (true) {
+    {
+      unique_lock<mutex> guard(this->lock);
+      this->wake.wait(guard, [this]() { return this->stopping || this->needsRefill(); });
+      if (this->stopping) {
+        break;
+      }
+    }
+    size_t added = this->refill(this->settings.refillBatch);
+    if (added > 0 && this->settings.maxRefillRate > 0) {
+      // throttle to maxRefillRate tuples per second
+      auto pause = chrono::duration<double>(added / this->settings.maxRefillRate);
+      unique_lock<mutex> guard(this->lock);
+      this->wake.wait_for(guard, pause, [this]() { return this->stopping; });
+    }
+  }
+}
+
+/*!
+ * Take a precomputed session tuple.
+ *
+ * @param[out]  the tuple.
+ * @return      true on a hit, false if the pool was empty.
+ */
+bool OpenABEPrecomputePool::takeSession(OpenABEPrecomputedSession &session) {
+  lock_guard<mutex> guard(this->lock);
+  if (this->sessions.empty()) {
+    this->stats.sessionMisses++;
+    this->wake.notify_one();
+    return false;
+  }
+  session = this->sessions.front();
+  this->sessions.pop_front();
+  this->stats.sessionHits++;
+  this->wake.notify_one();
+  return true;
+}
+
+/*!
+ * Take a precomputed share tuple.
+ *
+ * @param[out]  the tuple.
+ * @return      true on a hit, false if the pool was empty.
+ */
+bool OpenABEPrecomputePool::takeShare(OpenABEPrecomputedShare &share) {
+  lock_guard<mutex> guard(this->lock);
+  if (this->shares.empty()) {
+    this->stats.shareMisses++;
+    this->wake.notify_one();
+    return false;
+  }
+  share = this->shares.front();
+  this->shares.pop_front();
+  this->stats.shareHits++;
+  this->wake.notify_one();
+  return true;
+}
+
+/*!
+ * Take a precomputed row tuple for an attribute.
+ *
+ * @param[in]   complete label of the attribute.
+ * @param[out]  the tuple.
+ * @return      true on a hit, false if the attribute is unknown or has
+ *              no tuple left.
+ */
+bool OpenABEPrecomputePool::takeAttribute(const string &label,
+                                          OpenABEPrecomputedAttribute &tuple) {
+  lock_guard<mutex> guard(this->lock);
+  auto slot = this->attributes.find(label);
+  if (slot == this->attributes.end() || slot->second.tuples.empty()) {
+    this->stats.attributeMisses++;
+    this->wake.notify_one();
+    return false;
+  }
+  tuple = slot->second.tuples.front();
+  slot->second.tuples.pop_front();
+  this->stats.attributeHits++;
+  this->wake.notify_one();
+  return true;
+}
+
+/*!
+ * Let the pool precompute row tuples for an attribute. Does nothing once
+ * maxAttributes attributes are known.
+ *
+ * @param[in]   complete label of the attribute.
+ * @param[in]   hash of the attribute into G1.
+ */
+void OpenABEPrecomputePool::addAttribute(const string &label, const G1 &hashedPoint) {
+  lock_guard<mutex> guard(this->lock);
+  if (this->attributes.size() >= this->settings.maxAttributes ||
+      this->attributes.count(label) > 0) {
+    return;
+  }
+  this->attributes[label].hashedPoint = hashedPoint;
+  this->wake.notify_one();
+}
+
+OpenABEPrecomputeStats OpenABEPrecomputePool::getStats() {
+  lock_guard<mutex> guard(this->lock);
+  OpenABEPrecomputeStats result = this->stats;
+  result.sessions = this->sessions.size();
+  result.shares = this->shares.size();
+  result.attributes = this->attributes.size();
+  result.attributeTuples = 0;
+  for (auto &slot : this->attributes) {
+    result.attributeTuples += slot.second.tuples.size();
+  }
+  return result;
+}
+
+void OpenABEPrecomputePool::resetStats() {
+  lock_guard<mutex> guard(this->lock);
+  this->stats = OpenABEPrecomputeStats();
+}
@@ -202,6 +202,7 @@ SymKeyEncHandler::SymKeyEncHandler(const shared_ptr<OpenABESymKey>& key,
 
 SymKeyEncHandler::~SymKeyEncHandler() {
   gcm_handler_.reset();
+  stream_handler_.reset();
 }
 
 void SymKeyEncHandler::setSKEHandler(const std::shared_ptr<OpenABESymKey>& key) {
@@ -218,6 +219,9 @@ void SymKeyEncHandler::setSKEHandler(const std::shared_ptr<OpenABESymKey>& key)
     case EncryptionMode::GCM:
       this->gcm_handler_ = std::make_unique<OpenABESymKeyAuthEnc>(DEFAULT_AES_SEC_LEVEL, keyBytes);
       break;
+    case EncryptionMode::STREAM_GCM:
+      this->stream_handler_ = std::make_unique<OpenABESymKeySegmentedAuthEnc>(DEFAULT_AES_SEC_LEVEL, keyBytes);
+      break;
     default:
       throw OpenABE_ERROR_UNKNOWN_SCHEME;
   }
@@ -248,12 +252,10 @@ OpenABE_ERROR SymKeyEncHandler::encrypt(OpenABEByteString& ciphertext,
   OpenABEByteString zciphertext;
   OpenABEByteString ziv, zct, ztag, aad;
 
-
-  string plain_str = const_cast<OpenABEByteString&>(plaintext).toString();
-
   switch (this->encryption_mode_) {
     case EncryptionMode::GCM:
       try {
+        string plain_str = const_cast<OpenABEByteString&>(plaintext).toString();
         // set the additional auth data (if set)
         if (this->authData_.size() > 0) {
           gcm_handler_->setAddAuthData(this->authData_);
@@ -278,6 +280,20 @@ OpenABE_ERROR SymKeyEncHandler::encrypt(OpenABEByteString& ciphertext,
       }
       break;
 
+    case EncryptionMode::STREAM_GCM:
+      // the "IV" slot holds the stream header and the ciphertext slot the
+      // concatenated segments (each with its own tag)
+      aad = this->authData_;
+      stream_handler_->setAddAuthData(aad);
+      ret = stream_handler_->encrypt(plaintext, ziv, zct);
+      if (ret != OpenABE_NOERROR) {
+        throw runtime_error(OpenABE_errorToString(ret));
+      }
+      zciphertext.smartPack(ziv);
+      zciphertext.smartPack(zct);
+      zciphertext.smartPack(aad);
+      break;
+
     default:
       throw OpenABE_ERROR_UNKNOWN_SCHEME;
   }
@@ -345,6 +361,23 @@ OpenABE_ERROR SymKeyEncHandler::decrypt(OpenABEByteString& plaintext,
       }
       break;
 
+    case EncryptionMode::STREAM_GCM:
+      try {
+        if (index < zciphertext.size()) {
+          aad = zciphertext.smartUnpack(&index);
+        }
+        aad = this->getAuthData(aad);
+        stream_handler_->setAddAuthData(aad);
+        if (!stream_handler_->decrypt(plaintext, ziv, zct)) {
+          throw OpenABE_ERROR_DECRYPTION_FAILED;
+        }
+        ret = OpenABE_NOERROR;
+      } catch(const OpenABE_ERROR& error) {
+        string msg = OpenABE_errorToString(error);
+        throw runtime_error(msg);
+      }
+      break;
+
     default:
       throw OpenABE_ERROR_UNKNOWN_SCHEME;
   }
@@ -352,6 +385,155 @@ OpenABE_ERROR SymKeyEncHandler::decrypt(OpenABEByteString& plaintext,
   return ret;
 }
 
+/*!
+ * Random access to a packed ciphertext, raw or Base64-encoded. Only the
+ * ranges that are read get decoded: Base64 maps every 4 characters to 3
+ * bytes, so a byte range is decoded from the character groups covering
+ * it. Raw input is read in place. A range returned by read() stays valid
+ * until the next read.
+ */
+class OpenABEPackedReader {
+public:
+  OpenABEPackedReader(const OpenABEByteString& input, bool b64) : m_Input(input), m_B64(b64) {
+    if (!b64) {
+      this->m_Size = input.size();
+      return;
+    }
+    // Base64Encode always pads to whole groups
+    if (input.size() % 4 != 0) {
+      throw OpenABE_ERROR_INVALID_INPUT;
+    }
+    size_t pad = 0;
+    while (pad < 2 && pad < input.size() && input[input.size() - 1 - pad] == '=') {
+      pad++;
+    }
+    this->m_Size = input.size() / 4 * 3 - pad;
+  }
+
+  size_t size() const { return this->m_Size; }
+
+  span<const uint8_t> read(size_t offset, size_t len) {
+    if (offset > this->m_Size || len > this->m_Size - offset) {
+      throw OpenABE_ERROR_INVALID_CIPHERTEXT_BODY;
+    }
+    if (!this->m_B64) {
+      return span<const uint8_t>(this->m_Input.data() + offset, len);
+    }
+    size_t firstGroup = offset / 3, lastGroup = (offset + len + 2) / 3;
+    size_t charEnd = min(lastGroup * 4, this->m_Input.size());
+    string chars((const char *) this->m_Input.data() + firstGroup * 4,
+                 charEnd - firstGroup * 4);
+    this->m_Scratch = Base64Decode(chars);
+    size_t skip = offset - firstGroup * 3;
+    if (this->m_Scratch.size() < skip + len) {
+      throw OpenABE_ERROR_INVALID_CIPHERTEXT_BODY;
+    }
+    return span<const uint8_t>(this->m_Scratch.data() + skip, len);
+  }
+
+  // locate the next smartPack'ed field without copying it
+  void unpack(size_t& pos, size_t& offset, size_t& len) {
+    uint8_t type = this->read(pos, 1)[0];
+    size_t width = (type == PACK_8) ? 1 : (type == PACK_16) ? 2 : (type == PACK_32) ? 4 : 0;
+    if (width == 0) {
+      throw OpenABE_ERROR_INVALID_CIPHERTEXT_BODY;
+    }
+    span<const uint8_t> field = this->read(pos + 1, width);
+    len = 0;
+    for (size_t i = 0; i < width; i++) {
+      len = (len << 8) | field[i];
+    }
+    offset = pos + 1 + width;
+    this->read(offset, 0);
+    if (len > this->m_Size - offset) {
+      throw OpenABE_ERROR_INVALID_CIPHERTEXT_BODY;
+    }
+    pos = offset + len;
+  }
+
+private:
+  const OpenABEByteString& m_Input;
+  bool m_B64;
+  size_t m_Size;
+  OpenABEByteString m_Scratch;
+};
+
+/*!
+ * Decrypt a single segment of a STREAM_GCM ciphertext without touching the
+ * other segments, e.g. to serve a range read. Only the stream header, the
+ * length of the body, the AAD and the requested segment are read; with
+ * Base64 framing only those ranges are decoded.
+ *
+ * @param[out]  the plaintext of the segment.
+ * @param[in]   the full ciphertext.
+ * @param[in]   index of the segment.
+ * @return      OpenABE_NOERROR or an error code.
+ */
+OpenABE_ERROR SymKeyEncHandler::decryptSegment(OpenABEByteString& plaintext,
+                                               const OpenABEByteString& ciphertext,
+                                               size_t index) {
+  OpenABEByteString header, aad;
+  span<const uint8_t> segment;
+  uint32_t segmentSize = 0;
+  size_t pos = 0, offset = 0, len = 0, bodyOffset = 0, bodyLen = 0, count = 0;
+
+  if (encryption_mode_ != EncryptionMode::STREAM_GCM) {
+    return OpenABE_ERROR_UNKNOWN_SCHEME;
+  }
+
+  try {
+    OpenABEPackedReader reader(ciphertext, this->b64_encode_);
+    reader.unpack(pos, offset, len);
+    span<const uint8_t> field = reader.read(offset, len);
+    header.appendArray(const_cast<uint8_t*>(field.data()), field.size());
+    if (!OpenABESymKeySegmentedAuthEnc::parseHeader(header, segmentSize)) {
+      return OpenABE_ERROR_INVALID_CIPHERTEXT_HEADER;
+    }
+
+    reader.unpack(pos, bodyOffset, bodyLen);
+    if (pos < reader.size()) {
+      reader.unpack(pos, offset, len);
+      field = reader.read(offset, len);
+      aad.appendArray(const_cast<uint8_t*>(field.data()), field.size());
+    }
+    aad = this->getAuthData(aad);
+
+    count = OpenABESymKeySegmentedAuthEnc::getSegmentCount(bodyLen, segmentSize);
+    if (index >= count) {
+      return OpenABE_ERROR_INDEX_OUT_OF_BOUNDS;
+    }
+    size_t sealed = (size_t) segmentSize + AES_BLOCK_SIZE;
+    size_t segmentOffset = index * sealed;
+    segment = reader.read(bodyOffset + segmentOffset, min(sealed, bodyLen - segmentOffset));
+
+    stream_handler_->setAddAuthData(aad);
+    if (!stream_handler_->decryptSegment(plaintext, header, segment,
+                                         (uint32_t) index, (index + 1 == count))) {
+      return OpenABE_ERROR_DECRYPTION_FAILED;
+    }
+  } catch (const OpenABE_ERROR& error) {
+    return error;
+  }
+  return OpenABE_NOERROR;
+}
+
+/*!
+ * Pick the additional authenticated data for a decryption: the data set
+ * on this handler must match the data carried in the ciphertext (if any).
+ *
+ * @param[in]   the AAD stored in the ciphertext.
+ * @return      the AAD to authenticate against.
+ */
+OpenABEByteString SymKeyEncHandler::getAuthData(const OpenABEByteString& aad) {
+  if (this->authData_.size() > 0) {
+    if (aad.size() != 0 && aad != this->authData_) {
+      throw OpenABE_ERROR_DECRYPTION_FAILED;
+    }
+    return this->authData_;
+  }
+  return aad;
+}
+
 std::string SymKeyEncHandler::encrypt(const std::string& plaintext) {
   OpenABEByteString zplaintext, zciphertext;
   try
@@ -41,6 +41,8 @@
 #include <string>
 #include <sstream>
 #include <cmath>
+#include <algorithm>
+#include <atomic>
 
 #include "abe/zsymkey.h"
 #include "abe/zkdf.h"
@@ -502,16 +504,15 @@ OpenABE_ERROR OpenABESymKeyAuthEncStream::encryptUpdate(OpenABEByteString& plain
      * non-aligned block sizes) */
     ASSERT(pt_len > 0, OpenABE_ERROR_INVALID_INPUT);
 
-    /* perform encryption update on the given plaintext */
-    uint8_t ct[pt_len + 1];
-    memset(ct, 0, pt_len);
-    EVP_EncryptUpdate(this->ctx, ct, &ct_len, pt_ptr, pt_len);
+    /* perform encryption update on the given plaintext, writing straight
+     * into the output buffer (blocks can be large) */
+    const size_t offset = ciphertext.size();
+    ciphertext.resize(offset + pt_len);
+    EVP_EncryptUpdate(this->ctx, ciphertext.data() + offset, &ct_len, pt_ptr, pt_len);
     /* make sure we are not writing more than we've allocated */
     ASSERT(pt_len == ct_len, OpenABE_ERROR_INVALID_INPUT);
     /* keep track of the total ciphertext length so far*/
     this->total_ct_len += ct_len;
-    /* return back to user */
-    ciphertext.appendArray(ct, ct_len);
     /* increment number of encrypt updates the user has performed */
     this->updateEncCount++;
   }
@@ -523,16 +524,15 @@ OpenABE_ERROR OpenABESymKeyAuthEncStream::encryptFinalize(OpenABEByteString& cip
                                                   OpenABEByteString& tag) {
   OpenABE_ERROR result = OpenABE_NOERROR;
 
-  if (this->init_enc_set && this->updateEncCount > 0) {
-    /* finalize: computes authentication tag*/
-    uint8_t *ct_ptr = ciphertext.getInternalPtr();
-    /* make sure 'ct' size is the same as our internal size counter */
-    ASSERT(ciphertext.size() == this->total_ct_len, OpenABE_ERROR_INVALID_INPUT);
-    /* now we can finalize encryption */
-    EVP_EncryptFinal_ex(this->ctx, ct_ptr, (int *)&this->total_ct_len);
+  if (this->init_enc_set) {
+    /* finalize: computes authentication tag. GCM does not hold back any
+     * bytes, so the caller does not need to keep the ciphertext around */
+    uint8_t final_block[AES_BLOCK_SIZE];
+    int final_len = 0;
+    EVP_EncryptFinal_ex(this->ctx, final_block, &final_len);
     // For AES-GCM, the 'len' should be '0' because there is no extra bytes used
     // for padding.
-    ASSERT(this->total_ct_len == 0, OpenABE_ERROR_UNEXPECTED_EXTRA_BYTES);
+    ASSERT(final_len == 0, OpenABE_ERROR_UNEXPECTED_EXTRA_BYTES);
 
     /* retrieve the tag */
     int tag_len = AES_BLOCK_SIZE;
@@ -582,9 +582,12 @@ OpenABE_ERROR OpenABESymKeyAuthEncStream::decryptInit(OpenABEByteString& iv,
 
       /* set the tag BEFORE any calls to decrypt update
       NOTE: the tag isn't checked until decrypt finalize (i.e., once we've
-      obtained all the blocks) */
-      EVP_CIPHER_CTX_ctrl(this->ctx, EVP_CTRL_GCM_SET_TAG, tag.size(),
-                          tag.getInternalPtr());
+      obtained all the blocks). An empty tag means that it is passed to
+      decryptFinalize instead (e.g., when it trails the ciphertext) */
+      if (tag.size() > 0) {
+        EVP_CIPHER_CTX_ctrl(this->ctx, EVP_CTRL_GCM_SET_TAG, tag.size(),
+                            tag.getInternalPtr());
+      }
       this->init_dec_set = true;
       this->updateDecCount = 0;
     }
@@ -607,13 +610,11 @@ OpenABE_ERROR OpenABESymKeyAuthEncStream::decryptUpdate(OpenABEByteString& ciphe
       uint8_t *ct_ptr = ciphertextBlock.getInternalPtr();
       int pt_len = 0;
 
-      uint8_t pt[ct_len + 1];
-      memset(pt, 0, ct_len + 1);
-      /* decrypt and store plaintext in pt buffer */
-      EVP_DecryptUpdate(this->ctx, pt, &pt_len, ct_ptr, ct_len);
+      /* decrypt straight into the given plaintext buffer */
+      const size_t offset = plaintext.size();
+      plaintext.resize(offset + ct_len);
+      EVP_DecryptUpdate(this->ctx, plaintext.data() + offset, &pt_len, ct_ptr, ct_len);
       ASSERT(pt_len == ct_len, OpenABE_ERROR_BUFFER_TOO_SMALL);
-      /* add pt block to the given plaintext buffer */
-      plaintext.appendArray(pt, (uint32_t)pt_len);
       this->updateDecCount++;
     }
   } catch (OpenABE_ERROR &error) {
@@ -623,15 +624,37 @@ OpenABE_ERROR OpenABESymKeyAuthEncStream::decryptUpdate(OpenABEByteString& ciphe
   return result;
 }
 
+/*!
+ * Finalize decryption with a tag that was not available at decryptInit.
+ *
+ * @param[out]  unused (kept for symmetry with decryptFinalize).
+ * @param[in]   the authentication tag.
+ * @return      OpenABE_NOERROR, or OpenABE_ERROR_DECRYPTION_FAILED if the
+ *              tag does not verify.
+ */
+OpenABE_ERROR OpenABESymKeyAuthEncStream::decryptFinalize(OpenABEByteString& plaintext,
+                                                  OpenABEByteString& tag) {
+  if (!this->init_dec_set) {
+    return OpenABE_ERROR_INVALID_INPUT;
+  }
+  if (tag.size() != AES_BLOCK_SIZE) {
+    return OpenABE_ERROR_INVALID_TAG_LENGTH;
+  }
+  EVP_CIPHER_CTX_ctrl(this->ctx, EVP_CTRL_GCM_SET_TAG, tag.size(),
+                      tag.getInternalPtr());
+  return this->decryptFinalize(plaintext);
+}
+
 OpenABE_ERROR OpenABESymKeyAuthEncStream::decryptFinalize(OpenABEByteString& plaintext) {
   OpenABE_ERROR result = OpenABE_NOERROR;
 
   try {
-    if (this->init_dec_set && this->updateDecCount > 0) {
-      /* finalize decryption */
-      int pt_len = plaintext.size();
+    if (this->init_dec_set) {
+      /* finalize decryption (GCM does not output any bytes here) */
+      uint8_t final_block[AES_BLOCK_SIZE];
+      int pt_len = 0;
       int retValue =
-          EVP_DecryptFinal_ex(this->ctx, plaintext.getInternalPtr(), &pt_len);
+          EVP_DecryptFinal_ex(this->ctx, final_block, &pt_len);
       /* clear memory before the check */
       EVP_CIPHER_CTX_free(this->ctx);
       this->ctx = NULL;
@@ -659,3 +682,270 @@ OpenABE_ERROR OpenABESymKeyAuthEncStream::decryptFinalize(OpenABEByteString& pla
 
   return result;
 }
+
+
+/********************************************************************************
+ * Implementation of the OpenABESymKeySegmentedAuthEnc class
+ ********************************************************************************/
+
+OpenABESymKeySegmentedAuthEnc::OpenABESymKeySegmentedAuthEnc(int securitylevel,
+                                                             OpenABEByteString& zkey,
+                                                             uint32_t segmentSize)
+    : ZObject() {
+  this->cipher = NULL;
+  if (securitylevel == DEFAULT_AES_SEC_LEVEL) {
+    this->cipher = (EVP_CIPHER *)EVP_aes_256_gcm();
+  }
+  if (segmentSize == 0 || segmentSize > OpenABE_STREAM_MAX_SEGMENT) {
+    throw OpenABE_ERROR_INVALID_PARAMS;
+  }
+  this->key = zkey;
+  this->segment_size = segmentSize;
+}
+
+OpenABESymKeySegmentedAuthEnc::~OpenABESymKeySegmentedAuthEnc() {
+  this->key.zeroize();
+}
+
+void OpenABESymKeySegmentedAuthEnc::setAddAuthData(OpenABEByteString &aad) {
+  this->aad = aad;
+}
+
+/*!
+ * Number of segments in a ciphertext body of the given length. Every
+ * segment but the last holds segmentSize bytes plus a tag.
+ *
+ * @param[in]   length of the ciphertext body in bytes.
+ * @param[in]   segment size in bytes.
+ * @return      the number of segments (0 for an empty body).
+ */
+size_t OpenABESymKeySegmentedAuthEnc::getSegmentCount(size_t ciphertextLen,
+                                                      uint32_t segmentSize) {
+  size_t sealed = (size_t) segmentSize + AES_BLOCK_SIZE;
+  return (ciphertextLen + sealed - 1) / sealed;
+}
+
+void OpenABESymKeySegmentedAuthEnc::makeNonce(uint8_t *nonce,
+                                              const OpenABEByteString& header,
+                                              uint32_t index, bool last) const {
+  memcpy(nonce, header.data(), OpenABE_STREAM_PREFIX_LEN);
+  nonce[OpenABE_STREAM_PREFIX_LEN]     = (uint8_t) (index >> 24);
+  nonce[OpenABE_STREAM_PREFIX_LEN + 1] = (uint8_t) (index >> 16);
+  nonce[OpenABE_STREAM_PREFIX_LEN + 2] = (uint8_t) (index >> 8);
+  nonce[OpenABE_STREAM_PREFIX_LEN + 3] = (uint8_t) index;
+  nonce[OpenABE_STREAM_NONCE_LEN - 1]  = last ? 1 : 0;
+}
+
+/*!
+ * Read the segment size out of a stream header.
+ *
+ * @param[in]   the stream header.
+ * @param[out]  the segment size in bytes.
+ * @return      true if the header is well-formed.
+ */
+bool OpenABESymKeySegmentedAuthEnc::parseHeader(const OpenABEByteString& header,
+                                                uint32_t& segmentSize) {
+  if (header.size() != OpenABE_STREAM_HEADER_LEN) {
+    return false;
+  }
+  const uint8_t *ptr = header.data() + OpenABE_STREAM_PREFIX_LEN;
+  segmentSize = ((uint32_t) ptr[0] << 24) | ((uint32_t) ptr[1] << 16) |
+                ((uint32_t) ptr[2] << 8) | (uint32_t) ptr[3];
+  return (segmentSize > 0 && segmentSize <= OpenABE_STREAM_MAX_SEGMENT);
+}
+
+void OpenABESymKeySegmentedAuthEnc::encryptSegment(uint8_t *ct, const uint8_t *pt,
+                                                   size_t pt_len,
+                                                   const OpenABEByteString& header,
+                                                   uint32_t index, bool last) const {
+  uint8_t nonce[OpenABE_STREAM_NONCE_LEN];
+  int len = 0;
+  bool ok = false;
+
+  this->makeNonce(nonce, header, index, last);
+  EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+  MALLOC_CHECK_OUT_OF_MEMORY(ctx);
+  if (EVP_EncryptInit_ex(ctx, this->cipher, NULL, NULL, NULL) == 1 &&
+      EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, OpenABE_STREAM_NONCE_LEN, NULL) == 1 &&
+      EVP_EncryptInit_ex(ctx, NULL, NULL, this->key.data(), nonce) == 1 &&
+      (this->aad.size() == 0 ||
+       EVP_EncryptUpdate(ctx, NULL, &len, this->aad.data(), this->aad.size()) == 1) &&
+      EVP_EncryptUpdate(ctx, ct, &len, pt, pt_len) == 1 &&
+      EVP_EncryptFinal_ex(ctx, ct + len, &len) == 1 &&
+      EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, AES_BLOCK_SIZE, ct + pt_len) == 1) {
+    ok = true;
+  }
+  EVP_CIPHER_CTX_free(ctx);
+  if (!ok) {
+    throw OpenABE_ERROR_ENCRYPTION_ERROR;
+  }
+}
+
+bool OpenABESymKeySegmentedAuthEnc::decryptSegment(uint8_t *pt, const uint8_t *ct,
+                                                   size_t ct_len,
+                                                   const OpenABEByteString& header,
+                                                   uint32_t index, bool last) const {
+  uint8_t nonce[OpenABE_STREAM_NONCE_LEN];
+  uint8_t final_block[AES_BLOCK_SIZE];
+  int len = 0;
+  bool ok = false;
+
+  if (ct_len < AES_BLOCK_SIZE) {
+    return false;
+  }
+  size_t pt_len = ct_len - AES_BLOCK_SIZE;
+  this->makeNonce(nonce, header, index, last);
+  EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+  if (ctx == NULL) {
+    return false;
+  }
+  if (EVP_DecryptInit_ex(ctx, this->cipher, NULL, NULL, NULL) == 1 &&
+      EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, OpenABE_STREAM_NONCE_LEN, NULL) == 1 &&
+      EVP_DecryptInit_ex(ctx, NULL, NULL, this->key.data(), nonce) == 1 &&
+      (this->aad.size() == 0 ||
+       EVP_DecryptUpdate(ctx, NULL, &len, this->aad.data(), this->aad.size()) == 1) &&
+      EVP_DecryptUpdate(ctx, pt, &len, ct, pt_len) == 1 &&
+      EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, AES_BLOCK_SIZE,
+                          (void *) (ct + pt_len)) == 1 &&
+      EVP_DecryptFinal_ex(ctx, final_block, &len) > 0) {
+    ok = true;
+  }
+  EVP_CIPHER_CTX_free(ctx);
+  return ok;
+}
+
+/*!
+ * Encrypt the plaintext segment by segment. The header carries the random
+ * nonce prefix and the segment size; the ciphertext body is the
+ * concatenation of every sealed segment (ciphertext || tag). An empty
+ * plaintext still yields one (final) segment.
+ *
+ * @param[in]   the plaintext.
+ * @param[out]  the stream header.
+ * @param[out]  the ciphertext body.
+ * @param[in]   number of threads (0 for automatic).
+ * @return      OpenABE_NOERROR or an error code.
+ */
+OpenABE_ERROR
+OpenABESymKeySegmentedAuthEnc::encrypt(const OpenABEByteString& plaintext,
+                                       OpenABEByteString& header,
+                                       OpenABEByteString& ciphertext,
+                                       unsigned int numThreads) {
+  OpenABE_ERROR result = OpenABE_NOERROR;
+
+  try {
+    ASSERT(this->cipher != NULL, OpenABE_ERROR_INVALID_PARAMS);
+    size_t segSize = this->segment_size;
+    size_t count = (plaintext.size() + segSize - 1) / segSize;
+    if (count == 0) {
+      count = 1;
+    }
+    ASSERT(count <= UINT32_MAX, OpenABE_ERROR_INVALID_LENGTH);
+
+    uint8_t prefix[OpenABE_STREAM_PREFIX_LEN];
+    getRandomBytes(prefix, OpenABE_STREAM_PREFIX_LEN);
+    header.clear();
+    header.appendArray(prefix, OpenABE_STREAM_PREFIX_LEN);
+    header.pack32bits(this->segment_size);
+
+    ciphertext.clear();
+    ciphertext.resize(plaintext.size() + count * AES_BLOCK_SIZE);
+    const uint8_t *pt = plaintext.data();
+    uint8_t *ct = ciphertext.data();
+    OpenABE_parallelFor(count, numThreads, [&](size_t i) {
+      size_t offset = i * segSize;
+      size_t len = min(segSize, plaintext.size() - offset);
+      this->encryptSegment(ct + i * (segSize + AES_BLOCK_SIZE), pt + offset, len,
+                           header, (uint32_t) i, (i + 1 == count));
+    });
+  } catch (OpenABE_ERROR& error) {
+    ciphertext.clear();
+    result = error;
+  }
+
+  return result;
+}
+
+/*!
+ * Decrypt and verify every segment of a ciphertext body. Fails if any
+ * segment does not authenticate, which also covers reordered, dropped or
+ * truncated segments.
+ *
+ * @param[out]  the plaintext.
+ * @param[in]   the stream header.
+ * @param[in]   the ciphertext body.
+ * @param[in]   number of threads (0 for automatic).
+ * @return      true if every segment was authentic.
+ */
+bool
+OpenABESymKeySegmentedAuthEnc::decrypt(OpenABEByteString& plaintext,
+                                       const OpenABEByteString& header,
+                                       const OpenABEByteString& ciphertext,
+                                       unsigned int numThreads) {
+  uint32_t segmentSize = 0;
+  if (this->cipher == NULL || !parseHeader(header, segmentSize)) {
+    return false;
+  }
+
+  size_t sealed = (size_t) segmentSize + AES_BLOCK_SIZE;
+  size_t count = getSegmentCount(ciphertext.size(), segmentSize);
+  if (count == 0 || count > UINT32_MAX ||
+      ciphertext.size() - (count - 1) * sealed < AES_BLOCK_SIZE) {
+    return false;
+  }
+
+  OpenABEByteString output;
+  output.resize(ciphertext.size() - count * AES_BLOCK_SIZE);
+  const uint8_t *ct = ciphertext.data();
+  uint8_t *pt = output.data();
+  atomic<bool> authentic(true);
+  OpenABE_parallelFor(count, numThreads, [&](size_t i) {
+    size_t offset = i * sealed;
+    size_t len = min(sealed, ciphertext.size() - offset);
+    if (!this->decryptSegment(pt + i * segmentSize, ct + offset, len, header,
+                              (uint32_t) i, (i + 1 == count))) {
+      authentic.store(false);
+    }
+  });
+
+  if (!authentic.load()) {
+    output.zeroize();
+    return false;
+  }
+  plaintext = output;
+  return true;
+}
+
+/*!
+ * Decrypt a single segment on its own, e.g. for a range read of a large
+ * ciphertext. The caller supplies the segment's index and whether it is
+ * the final one (getSegmentCount gives the total).
+ *
+ * @param[out]  the plaintext of the segment.
+ * @param[in]   the stream header.
+ * @param[in]   the sealed segment (ciphertext || tag), read in place.
+ * @param[in]   index of the segment.
+ * @param[in]   whether this is the final segment.
+ * @return      true if the segment was authentic.
+ */
+bool
+OpenABESymKeySegmentedAuthEnc::decryptSegment(OpenABEByteString& plaintext,
+                                              const OpenABEByteString& header,
+                                              span<const uint8_t> segment,
+                                              uint32_t index, bool last) {
+  uint32_t segmentSize = 0;
+  if (this->cipher == NULL || !parseHeader(header, segmentSize) ||
+      segment.size() < AES_BLOCK_SIZE ||
+      segment.size() > (size_t) segmentSize + AES_BLOCK_SIZE) {
+    return false;
+  }
+
+  OpenABEByteString output;
+  output.resize(segment.size() - AES_BLOCK_SIZE);
+  if (!this->decryptSegment(output.data(), segment.data(), segment.size(),
+                            header, index, last)) {
+    return false;
+  }
+  plaintext = output;
+  return true;
+}
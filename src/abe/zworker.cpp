@@ -0,0 +1,310 @@
+/// 
+/// Copyright (c) 2018 Zeutro, LLC. All rights reserved.
+/// 
+/// This file is part of Zeutro's OpenABE.
+/// 
+/// OpenABE is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU Affero General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+/// 
+/// OpenABE is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU Affero General Public License for more details.
+/// 
+/// You should have received a copy of the GNU Affero General Public
+/// License along with OpenABE. If not, see <http://www.gnu.org/licenses/>.
+/// 
+/// You can be released from the requirements of the GNU Affero General
+/// Public License and obtain additional features by purchasing a
+/// commercial license. Buying such a license is mandatory if you
+/// engage in commercial activities involving OpenABE that do not
+/// comply with the open source requirements of the GNU Affero General
+/// Public License. For more information on commerical licenses,
+/// visit <http://www.zeutro.com>.
+///
+///
+/// \file   zworker.cpp
+///
+/// \brief  Implementation of the per-thread RELIC contexts and the OpenABE
+///         worker thread helpers.
+///
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <abe_lsss.h>
+
+using namespace std;
+
+/********************************************************************************
+ * Per-thread RELIC contexts
+ ********************************************************************************/
+
+namespace {
+
+// RELIC state of the calling thread. A context set up by
+// OpenABE_initializeThreadContext is owned by the thread and released when
+// the thread exits; the one of the InitializeOpenABE thread is not.
+struct OpenABEThreadState {
+  bool ready = false;
+  bool owned = false;
+
+  ~OpenABEThreadState() {
+    if (this->owned) {
+      zMathShutdownLibrary();
+    }
+  }
+};
+
+thread_local OpenABEThreadState tThreadState;
+
+// set while the thread runs a job of the worker pool
+thread_local bool tInPoolJob = false;
+
+}
+
+/*!
+ * Set up the RELIC context of the calling thread if it does not have one.
+ *
+ * @return      true if a context was created by this call.
+ */
+bool OpenABE_initializeThreadContext() {
+#if OpenABE_THREADS_SUPPORTED
+  if (tThreadState.ready) {
+    return false;
+  }
+  if (zMathInitLibrary() != OpenABE_NOERROR) {
+    throw OpenABE_ERROR_LIBRARY_NOT_INITIALIZED;
+  }
+  tThreadState.ready = tThreadState.owned = true;
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*!
+ * Release the RELIC context created for the calling thread, if any.
+ */
+void OpenABE_shutdownThreadContext() {
+  if (tThreadState.owned) {
+    zMathShutdownLibrary();
+    tThreadState.ready = tThreadState.owned = false;
+  }
+}
+
+/*!
+ * Record that the calling thread's context is managed by
+ * InitializeOpenABE/ShutdownOpenABE.
+ *
+ * @param[in]   whether the context is set up.
+ */
+void OpenABE_setMainThreadContext(bool ready) {
+  tThreadState.ready = ready;
+  tThreadState.owned = false;
+}
+
+/*!
+ * Whether RELIC keeps per-thread state, so that OpenABE may be used from
+ * several threads at once.
+ */
+bool OpenABE_isThreadSafe() {
+  return OpenABE_THREADS_SUPPORTED;
+}
+
+/********************************************************************************
+ * Implementation of the OpenABEWorkerPool class
+ ********************************************************************************/
+
+OpenABEWorkerPool& OpenABEWorkerPool::getInstance() {
+  static OpenABEWorkerPool instance;
+  return instance;
+}
+
+/*!
+ * Run a job on the calling thread and on numWorkers pool threads, and wait
+ * for all of them to return.
+ *
+ * @param[in]   number of pool threads that run the job.
+ * @param[in]   the job; the caller and every worker call it once.
+ * @return      false (without running anything) if the pool is busy or
+ *              the caller is itself running a pool job.
+ */
+bool OpenABEWorkerPool::tryRun(unsigned int numWorkers, const function<void()> &job) {
+  if (tInPoolJob) {
+    return false;
+  }
+  unique_lock<mutex> running(this->runLock, try_to_lock);
+  if (!running.owns_lock()) {
+    return false;
+  }
+
+  {
+    lock_guard<mutex> guard(this->lock);
+    this->stopping = false;
+    while (this->threads.size() < numWorkers) {
+      this->threads.emplace_back(&OpenABEWorkerPool::workerLoop, this);
+    }
+    this->job = &job;
+    this->wanted = this->active = numWorkers;
+    this->taken = 0;
+    this->generation++;
+  }
+  this->wake.notify_all();
+
+  tInPoolJob = true;
+  job();
+  tInPoolJob = false;
+
+  unique_lock<mutex> guard(this->lock);
+  this->done.wait(guard, [this]() { return this->active == 0; });
+  this->job = nullptr;
+  return true;
+}
+
+void OpenABEWorkerPool::workerLoop() {
+  OpenABE_initializeThreadContext();
+  tInPoolJob = true;
+  uint64_t seen = 0;
+  unique_lock<mutex> guard(this->lock);
+  while (true) {
+    this->wake.wait(guard, [&]() {
+      return this->stopping || (this->generation != seen && this->taken < this->wanted);
+    });
+    if (this->stopping) {
+      break;
+    }
+    seen = this->generation;
+    this->taken++;
+    const function<void()> *current = this->job;
+    guard.unlock();
+    (*current)();
+    guard.lock();
+    if (--this->active == 0) {
+      this->done.notify_all();
+    }
+  }
+}
+
+/*!
+ * Stop and join the workers. Their RELIC contexts are released as they
+ * exit. The pool restarts workers on the next job.
+ */
+void OpenABEWorkerPool::shutdown() {
+  lock_guard<mutex> running(this->runLock);
+  vector<thread> workers;
+  {
+    lock_guard<mutex> guard(this->lock);
+    this->stopping = true;
+    this->wake.notify_all();
+    workers.swap(this->threads);
+  }
+  for (auto &th : workers) {
+    th.join();
+  }
+}
+
+size_t OpenABEWorkerPool::size() {
+  lock_guard<mutex> guard(this->lock);
+  return this->threads.size();
+}
+
+/********************************************************************************
+ * Parallel loops
+ ********************************************************************************/
+
+/*!
+ * Number of threads to use for a batch of tasks. A request of zero selects
+ * the hardware concurrency. The result never exceeds the number of tasks
+ * and is always one when RELIC is not built for multithreading.
+ *
+ * @param[in]   requested number of threads (0 for automatic).
+ * @param[in]   number of tasks in the batch.
+ * @return      number of threads to run (at least 1).
+ */
+unsigned int
+OpenABE_getWorkerCount(unsigned int requested, size_t numTasks) {
+#if OpenABE_THREADS_SUPPORTED
+  unsigned int count = requested;
+  if (count == 0) {
+    count = thread::hardware_concurrency();
+  }
+  if (count > numTasks) {
+    count = numTasks;
+  }
+  return (count == 0) ? 1 : count;
+#else
+  return 1;
+#endif
+}
+
+/*!
+ * Run task(i) for every i in [0, numTasks). The calling thread takes part
+ * in the work, helped by threads of the worker pool (or by temporary
+ * threads if the pool is busy). Tasks are handed out through a shared
+ * counter, so they must not depend on each other. The first exception
+ * raised by a task is rethrown in the calling thread once all workers
+ * have stopped.
+ *
+ * @param[in]   number of tasks.
+ * @param[in]   number of threads (0 for automatic).
+ * @param[in]   the task to run for each index.
+ */
+void
+OpenABE_parallelFor(size_t numTasks, unsigned int numThreads,
+                    const function<void(size_t)> &task) {
+  unsigned int workers = OpenABE_getWorkerCount(numThreads, numTasks);
+  if (workers <= 1) {
+    for (size_t i = 0; i < numTasks; i++) {
+      task(i);
+    }
+    return;
+  }
+
+  atomic<size_t> next(0);
+  atomic<bool> failed(false);
+  exception_ptr error = nullptr;
+  mutex errorLock;
+
+  auto run = [&]() {
+    try {
+      size_t i;
+      while (!failed.load() && (i = next.fetch_add(1)) < numTasks) {
+        task(i);
+      }
+    } catch (...) {
+      lock_guard<mutex> lock(errorLock);
+      if (error == nullptr) {
+        error = current_exception();
+      }
+      failed.store(true);
+    }
+  };
+
+  function<void()> job = run;
+  if (!OpenABEWorkerPool::getInstance().tryRun(workers - 1, job)) {
+    // the pool is busy: use temporary threads with their own contexts
+    vector<thread> threads;
+    threads.reserve(workers - 1);
+    for (unsigned int t = 1; t < workers; t++) {
+      threads.emplace_back([&run]() {
+        OpenABEStateContext state;
+        run();
+      });
+    }
+    run();
+    for (auto &th : threads) {
+      th.join();
+    }
+  }
+
+  if (error != nullptr) {
+    rethrow_exception(error);
+  }
+}
@@ -38,6 +38,7 @@
 #include <stdlib.h>
 #include <iostream>
 #include <fstream>
+#include <mutex>
 #include <string>
 #include <regex>
 
@@ -47,6 +48,55 @@
 
 using namespace std;
 
+/********************************************************************************
+ * Implementation of the OpenABEAttributeInterner class
+ ********************************************************************************/
+
+OpenABEAttributeInterner& OpenABEAttributeInterner::getInstance() {
+  static OpenABEAttributeInterner instance;
+  return instance;
+}
+
+/*!
+ * Return the ID of an attribute, assigning the next free ID if the
+ * attribute has not been seen before.
+ *
+ */
+
+uint32_t OpenABEAttributeInterner::intern(const string &attribute) {
+  {
+    shared_lock<shared_mutex> guard(this->m_Lock);
+    auto it = this->m_Ids.find(attribute);
+    if (it != this->m_Ids.end()) {
+      return it->second;
+    }
+  }
+  unique_lock<shared_mutex> guard(this->m_Lock);
+  // another thread may have inserted it in the meantime
+  auto result = this->m_Ids.emplace(attribute, (uint32_t) this->m_Ids.size());
+  return result.first->second;
+}
+
+/*!
+ * Find the ID of an attribute without assigning one.
+ *
+ */
+
+bool OpenABEAttributeInterner::lookup(const string &attribute, uint32_t &id) {
+  shared_lock<shared_mutex> guard(this->m_Lock);
+  auto it = this->m_Ids.find(attribute);
+  if (it == this->m_Ids.end()) {
+    return false;
+  }
+  id = it->second;
+  return true;
+}
+
+size_t OpenABEAttributeInterner::size() {
+  shared_lock<shared_mutex> guard(this->m_Lock);
+  return this->m_Ids.size();
+}
+
 /********************************************************************************
  * Implementation of the OpenABEAttributeList class
  ********************************************************************************/
@@ -85,6 +135,7 @@ OpenABEAttributeList::OpenABEAttributeList(const OpenABEAttributeList &copy) {
   this->m_Type = copy.getFunctionType();
   this->m_Attributes = copy.m_Attributes;
   this->m_OriginalAttributes = copy.m_OriginalAttributes;
+  this->m_AttributeIds = copy.m_AttributeIds;
   this->m_prefixSet = copy.m_prefixSet;
 }
 
@@ -124,8 +175,26 @@ void OpenABEAttributeList::syncOrigAttributes(const string &prefix,
  */
 
 bool OpenABEAttributeList::matchAttribute(const string &attribute) {
-  return (std::find(m_Attributes.begin(), m_Attributes.end(), attribute) !=
-          m_Attributes.end());
+  uint32_t id;
+  if (!OpenABEAttributeInterner::getInstance().lookup(attribute, id)) {
+    // never interned, so no attribute list holds it
+    return false;
+  }
+  return this->matchAttribute(id);
+}
+
+/*!
+ * Insert the interned ID of an attribute into the sorted ID list. IDs are
+ * process-wide, so the list stays proportional to the attributes it holds.
+ *
+ */
+
+void OpenABEAttributeList::addAttributeId(const string &attribute) {
+  const uint32_t id = OpenABEAttributeInterner::getInstance().intern(attribute);
+  auto it = std::lower_bound(this->m_AttributeIds.begin(), this->m_AttributeIds.end(), id);
+  if (it == this->m_AttributeIds.end() || *it != id) {
+    this->m_AttributeIds.insert(it, id);
+  }
 }
 
 bool OpenABEAttributeList::addAttribute(string attribute) {
@@ -144,6 +213,7 @@ bool OpenABEAttributeList::addAttribute(string attribute) {
   // do a quick find for the '=' symbol: if not, then proceed as usual
   if (attribute.find(EQUALS) == string::npos) {
     this->m_Attributes.push_back(attribute);
+    this->addAttributeId(attribute);
   } else {
     // otherwise, parse as a numerical attribute (using regex)
     // NOTE: we already handled prefixes in first part so would be redundant here
@@ -151,8 +221,10 @@ bool OpenABEAttributeList::addAttribute(string attribute) {
     const vector<string> *m_attrs = attr_list->getAttributeList();
     const vector<string> *orig_attrs = attr_list->getOriginalAttributeList();
     if (m_attrs && orig_attrs) {
-      for (auto& a : *m_attrs)
+      for (auto& a : *m_attrs) {
         this->m_Attributes.push_back(a);
+        this->addAttributeId(a);
+      }
       for (auto& b : *orig_attrs)
         this->m_OriginalAttributes.push_back(b);
     }
@@ -167,6 +239,10 @@ void OpenABEAttributeList::setAttributes(vector<string> &attr_list,
   this->m_Attributes = attr_list;
   this->m_OriginalAttributes = orig_attr_list;
   this->m_prefixSet = prefix_list;
+  this->m_AttributeIds.clear();
+  for (auto &attr : this->m_Attributes) {
+    this->addAttributeId(attr);
+  }
 }
 
 ostream &operator<<(ostream &os, const OpenABEAttributeList &attributeList) {
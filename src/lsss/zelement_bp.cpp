@@ -37,15 +37,19 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <atomic>
 #include <list>
 #include <memory>
+#include <stdexcept>
 
 #include "lsss/zbytestring.h"
 #include "lsss/zobject.h"
 #include "lsss/zelement_bp.h"
+#include "lsss/zrandom.h"
 
 
-int compression_flag = 1;
+// process-wide; read by every serialization, so it is atomic
+static std::atomic<int> compression_flag(1);
 
 void set_compression_flag(int value) {
   if (value == 0 || value == 1)
@@ -250,6 +254,32 @@ bool ZP::ismember(void) {
          (zmbignum_sign(m_ZP) == RLC_POS);
 }
 
+bool ZP::isZero() const {
+  return zmbignum_is_zero(m_ZP);
+}
+
+bool ZP::isOne() const {
+  return (zmbignum_sign(m_ZP) == RLC_POS) && zmbignum_is_one(m_ZP);
+}
+
+/*!
+ * True for -1, either as a negative number or reduced as (order - 1).
+ */
+bool ZP::isMinusOne() const {
+  bool result = false;
+  bignum_t t;
+  zmbignum_init(&t);
+  if (zmbignum_sign(m_ZP) == RLC_NEG) {
+    bn_neg(t, m_ZP);
+    result = zmbignum_is_one(t);
+  } else if (isOrderSet) {
+    bn_add_dig(t, m_ZP, 1);
+    result = (zmbignum_cmp(t, order) == BN_CMP_EQ);
+  }
+  zmbignum_free(t);
+  return result;
+}
+
 void ZP::setOrder(const bignum_t o) {
   if (!isOrderSet) {
     zmbignum_copy(order, o);
@@ -262,7 +292,7 @@ void ZP::setRandom(bignum_t o) {
     this->isOrderSet = true;
     zmbignum_copy(this->order, o);
   }
-  zmbignum_rand(this->m_ZP, this->order);
+  OpenABE_randomBelow(this->m_ZP, this->order);
 }
 
 void ZP::setRandom(ZP &order) {
@@ -271,7 +301,7 @@ void ZP::setRandom(ZP &order) {
       this->isOrderSet = true;
       zmbignum_copy(this->order, order.m_ZP);
     }
-    zmbignum_rand(this->m_ZP, order.m_ZP);
+    OpenABE_randomBelow(this->m_ZP, order.m_ZP);
   }
 }
 
@@ -472,7 +502,7 @@ void G1::setGenerator() {
 }
 
 int G1::getSize() const {
-  return g1_size_bin(this->m_G1, compression_flag);
+  return g1_size_bin(this->m_G1, compression_flag.load());
 }
 
 /**
@@ -497,7 +527,7 @@ bool G1::ismember() const {
 uint8_t* G1::hashToBytes(size_t *size) const {
   int len = this->getSize();
   uint8_t buffer[len];
-  g1_write_bin(buffer, len, this->m_G1, compression_flag);
+  g1_write_bin(buffer, len, this->m_G1, compression_flag.load());
 
   std::unique_ptr<uint8_t[]> hash(new uint8_t[RLC_MD_LEN]);
   md_map(hash.get(), buffer, len);
@@ -512,6 +542,12 @@ G1 G1::operator*(const ZP k) const {
   return tmp;
 }
 
+G1 G1::operator-() const {
+  G1 tmp;
+  g1_neg(tmp.m_G1, this->m_G1);
+  return tmp;
+}
+
 G1 G1::operator-(const G1 &x) const {
   G1 tmp;
   g1_neg(tmp.m_G1, x.m_G1);
@@ -540,7 +576,7 @@ G1* G1::clone() const {
 uint8_t* G1::getBytes(int *bufferSize) const {
   int size = this->getSize();
   uint8_t *buffer = (uint8_t *)malloc(size);
-  g1_write_bin(buffer, size, this->m_G1, compression_flag);
+  g1_write_bin(buffer, size, this->m_G1, compression_flag.load());
   *bufferSize = size;
   return buffer;
 }
@@ -640,7 +676,7 @@ void G2::setGenerator() {
 uint8_t* G2::hashToBytes(size_t *size) const {
   int len = this->getSize();
   uint8_t buffer[len];
-  g2_write_bin(buffer, len, this->m_G2, compression_flag);
+  g2_write_bin(buffer, len, this->m_G2, compression_flag.load());
 
   std::unique_ptr<uint8_t[]> hash(new uint8_t[RLC_MD_LEN]);
   md_map(hash.get(), buffer, len);
@@ -660,7 +696,7 @@ int G2::getDefaultSize() {
 }
 
 int G2::getSize() const {
-  return g2_size_bin(this->m_G2, compression_flag);
+  return g2_size_bin(this->m_G2, compression_flag.load());
 }
 
 size_t G2::getSizeInBytes() const {
@@ -678,6 +714,12 @@ G2 G2::operator*(const ZP k) const {
   return tmp;
 }
 
+G2 G2::operator-() const {
+  G2 tmp;
+  g2_neg(tmp.m_G2, this->m_G2);
+  return tmp;
+}
+
 G2 G2::operator-(const G2 &x) const {
   G2 tmp;
   g2_neg(tmp.m_G2, x.m_G2);
@@ -706,7 +748,7 @@ G2* G2::clone() const {
 uint8_t* G2::getBytes(int *bufferSize) const {
   int size = this->getSize();
   uint8_t *buffer = (uint8_t *)malloc(size);
-  g2_write_bin(buffer, size, this->m_G2, compression_flag);
+  g2_write_bin(buffer, size, this->m_G2, compression_flag.load());
   *bufferSize = size;
   return buffer;
 }
@@ -750,6 +792,7 @@ GT::GT() {
 GT::GT(const GT &w) {
   gt_init(this->m_GT);
   gt_copy(this->m_GT, w.m_GT);
+  this->m_FixedBase = w.m_FixedBase;
   isInit = true;
 }
 
@@ -761,14 +804,17 @@ GT::~GT() {
 }
 
 void GT::setIdentity() {
+  this->m_FixedBase.reset();
   if (isInit) gt_set_unity(this->m_GT);
 }
 
 void GT::setRandom() {
+  this->m_FixedBase.reset();
   if (isInit) gt_rand(this->m_GT);
 }
 
 void GT::setGenerator() {
+  this->m_FixedBase.reset();
   if (isInit) gt_get_gen(this->m_GT);
 }
 
@@ -783,7 +829,7 @@ uint8_t* GT::hashToBytes(size_t *size) const {
 }
 
 int GT::getSize() const {
-  return gt_size_bin((static_cast<GT>(*this)).m_GT, compression_flag);
+  return gt_size_bin((static_cast<GT>(*this)).m_GT, compression_flag.load());
 }
 
 size_t GT::getSizeInBytes() const {
@@ -800,6 +846,9 @@ bool GT::ismember() const {
 }
 
 GT GT::exp(const ZP k) const {
+  if (this->m_FixedBase != nullptr) {
+    return this->m_FixedBase->exp(k);
+  }
   GT tmp;
   gt_exp(tmp.m_GT, this->m_GT, k.m_ZP);
   return tmp;
@@ -832,6 +881,7 @@ GT& GT::operator*=(const GT &x) {
 
 GT& GT::operator=(const GT &x) {
   gt_copy(this->m_GT, x.m_GT);
+  this->m_FixedBase = x.m_FixedBase;
   return *this;
 }
 
@@ -851,7 +901,7 @@ GT* GT::clone() const {
 uint8_t* GT::getBytes(int *bufferSize) const {
   int size = this->getSize();
   uint8_t *buffer = (uint8_t *)malloc(size);
-  gt_write_bin(buffer, size, this->m_GT, compression_flag);
+  gt_write_bin(buffer, size, this->m_GT, compression_flag.load());
   *bufferSize = size;
   return buffer;
 }
@@ -877,9 +927,247 @@ void GT::deserialize(OpenABEByteString &input) {
   if(this->isInit && (input.at(index++) == OpenABE_ELEMENT_GT)) {
     gt_bytes = input.smartUnpack(&index);
     gt_read_bin(this->m_GT, gt_bytes.data(), gt_bytes.size());
+    this->m_FixedBase.reset();
+  }
+}
+
+
+/********************************************************************************
+ * Implementation of the G1FixedBase and G2FixedBase classes
+ ********************************************************************************/
+
+/*!
+ * The fixed-base tables are only valid for reduced, non-negative scalars.
+ * Anything else falls back to a generic multiplication with the stored base.
+ * The scalar is always compared against the given order, whether or not
+ * it carries one itself.
+ */
+static bool isReducedScalar(const ZP &k, const bignum_t order) {
+  if (bn_sign(k.m_ZP) == RLC_NEG) {
+    return false;
+  }
+  return bn_cmp(k.m_ZP, order) == RLC_LT;
+}
+
+G1FixedBase::G1FixedBase(const G1 &base) {
+  g1_init(this->m_Base);
+  g1_copy(this->m_Base, base.m_G1);
+  for (int i = 0; i < RLC_G1_TABLE; i++) {
+    g1_init(this->m_Table[i]);
+  }
+  g1_mul_pre(this->m_Table, this->m_Base);
+}
+
+G1FixedBase::~G1FixedBase() {
+  for (int i = 0; i < RLC_G1_TABLE; i++) {
+    g1_free(this->m_Table[i]);
+  }
+  g1_free(this->m_Base);
+}
+
+G1 G1FixedBase::operator*(const ZP &k) const {
+  G1 tmp;
+  if (isReducedScalar(k, this->m_Group.order)) {
+    g1_mul_fix(tmp.m_G1, this->m_Table, k.m_ZP);
+  } else {
+    g1_mul(tmp.m_G1, this->m_Base, k.m_ZP);
+  }
+  return tmp;
+}
+
+G2FixedBase::G2FixedBase(const G2 &base) {
+  g2_init(this->m_Base);
+  g2_copy(this->m_Base, base.m_G2);
+  for (int i = 0; i < RLC_G2_TABLE; i++) {
+    g2_init(this->m_Table[i]);
+  }
+  g2_mul_pre(this->m_Table, this->m_Base);
+}
+
+G2FixedBase::~G2FixedBase() {
+  for (int i = 0; i < RLC_G2_TABLE; i++) {
+    g2_free(this->m_Table[i]);
+  }
+  g2_free(this->m_Base);
+}
+
+G2 G2FixedBase::operator*(const ZP &k) const {
+  G2 tmp;
+  if (isReducedScalar(k, this->m_Group.order)) {
+    g2_mul_fix(tmp.m_G2, this->m_Table, k.m_ZP);
+  } else {
+    g2_mul(tmp.m_G2, this->m_Base, k.m_ZP);
   }
+  return tmp;
+}
+
+
+/********************************************************************************
+ * Implementation of multi-scalar multiplication in G1 and G2
+ ********************************************************************************/
+
+/*!
+ * Copy a scalar into a RELIC big number, reduced into [0, order) when the
+ * order is known.
+ */
+static void copyReducedScalar(bn_t out, const ZP &k) {
+  bn_copy(out, k.m_ZP);
+  if (k.isOrderSet && !isReducedScalar(k, k.order)) {
+    bn_mod(out, out, k.order);
+    if (bn_sign(out) == RLC_NEG) {
+      bn_add(out, out, k.order);
+    }
+  }
+}
+
+/*!
+ * Compute sum_i scalars[i] * points[i] as a single multi-scalar
+ * multiplication (interleaved, sharing the doublings across all terms)
+ * instead of one scalar multiplication per term.
+ *
+ * @param[in]   the points.
+ * @param[in]   the scalars (same length as the points).
+ * @return      the sum (the identity for empty inputs).
+ */
+G1 G1::multiExp(const std::vector<G1> &points, const std::vector<ZP> &scalars) {
+  G1 result;
+  const size_t n = points.size();
+  if (n != scalars.size()) {
+    throw std::invalid_argument("G1::multiExp: points and scalars differ in length");
+  }
+  if (n == 0) {
+    return result;
+  }
+
+  // on the heap: n is unbounded (one term per policy row)
+  std::unique_ptr<g1_t[]> P(new g1_t[n]);
+  std::unique_ptr<bn_t[]> K(new bn_t[n]);
+  for (size_t i = 0; i < n; i++) {
+    g1_init(P[i]);
+    g1_copy(P[i], points[i].m_G1);
+    bn_inits(K[i]);
+    copyReducedScalar(K[i], scalars[i]);
+  }
+#ifdef g1_mul_sim_lot
+  g1_mul_sim_lot(result.m_G1, P.get(), K.get(), n);
+#else
+  // pairwise simultaneous multiplication (Shamir's trick)
+  G1 tmp;
+  for (size_t i = 0; i + 1 < n; i += 2) {
+    g1_mul_sim(tmp.m_G1, P[i], K[i], P[i+1], K[i+1]);
+    g1_add(result.m_G1, result.m_G1, tmp.m_G1);
+  }
+  if (n % 2 == 1) {
+    g1_mul(tmp.m_G1, P[n-1], K[n-1]);
+    g1_add(result.m_G1, result.m_G1, tmp.m_G1);
+  }
+#endif
+  for (size_t i = 0; i < n; i++) {
+    g1_free(P[i]);
+    bn_free(K[i]);
+  }
+  return result;
+}
+
+/*!
+ * Compute sum_i scalars[i] * points[i] in G2 (see G1::multiExp).
+ *
+ * @param[in]   the points.
+ * @param[in]   the scalars (same length as the points).
+ * @return      the sum (the identity for empty inputs).
+ */
+G2 G2::multiExp(const std::vector<G2> &points, const std::vector<ZP> &scalars) {
+  G2 result;
+  const size_t n = points.size();
+  if (n != scalars.size()) {
+    throw std::invalid_argument("G2::multiExp: points and scalars differ in length");
+  }
+  if (n == 0) {
+    return result;
+  }
+
+  // on the heap: n is unbounded (one term per policy row)
+  std::unique_ptr<g2_t[]> P(new g2_t[n]);
+  std::unique_ptr<bn_t[]> K(new bn_t[n]);
+  for (size_t i = 0; i < n; i++) {
+    g2_init(P[i]);
+    g2_copy(P[i], points[i].m_G2);
+    bn_inits(K[i]);
+    copyReducedScalar(K[i], scalars[i]);
+  }
+#ifdef g2_mul_sim_lot
+  g2_mul_sim_lot(result.m_G2, P.get(), K.get(), n);
+#else
+  // pairwise simultaneous multiplication (Shamir's trick)
+  G2 tmp;
+  for (size_t i = 0; i + 1 < n; i += 2) {
+    g2_mul_sim(tmp.m_G2, P[i], K[i], P[i+1], K[i+1]);
+    g2_add(result.m_G2, result.m_G2, tmp.m_G2);
+  }
+  if (n % 2 == 1) {
+    g2_mul(tmp.m_G2, P[n-1], K[n-1]);
+    g2_add(result.m_G2, result.m_G2, tmp.m_G2);
+  }
+#endif
+  for (size_t i = 0; i < n; i++) {
+    g2_free(P[i]);
+    bn_free(K[i]);
+  }
+  return result;
 }
 
+/********************************************************************************
+ * Implementation of the GTFixedBase class
+ ********************************************************************************/
+
+GTFixedBase::GTFixedBase(const GT &base) {
+  const int entries = (1 << GT_FIXED_BASE_WINDOW) - 1;
+  BPGroup group;
+
+  // keep a plain copy of the base (without any attached table)
+  gt_copy(this->m_Base.m_GT, base.m_GT);
+  this->m_MaxBits = bn_bits(group.order);
+
+  // m_Table[i*entries + (d-1)] = base^(d * 2^(w*i))
+  int windows = (this->m_MaxBits + GT_FIXED_BASE_WINDOW - 1) / GT_FIXED_BASE_WINDOW;
+  this->m_Table.reserve(windows * entries);
+  GT cur(this->m_Base);
+  for (int i = 0; i < windows; i++) {
+    GT acc(cur);
+    for (int d = 1; d <= entries; d++) {
+      this->m_Table.push_back(acc);
+      acc *= cur;
+    }
+    // acc = cur^(2^w) is the base of the next window
+    cur = acc;
+  }
+}
+
+GT GTFixedBase::exp(const ZP &k) const {
+  const int entries = (1 << GT_FIXED_BASE_WINDOW) - 1;
+  int bits = bn_bits(k.m_ZP);
+  GT result;
+
+  if (bn_sign(k.m_ZP) == RLC_NEG || bits > this->m_MaxBits) {
+    // the table does not cover this exponent
+    gt_exp(result.m_GT, this->m_Base.m_GT, k.m_ZP);
+    return result;
+  }
+
+  for (int i = 0, pos = 0; pos < bits; i++, pos += GT_FIXED_BASE_WINDOW) {
+    int digit = 0;
+    for (int j = GT_FIXED_BASE_WINDOW - 1; j >= 0; j--) {
+      digit <<= 1;
+      if (pos + j < bits) {
+        digit |= bn_get_bit(k.m_ZP, pos + j);
+      }
+    }
+    if (digit != 0) {
+      gt_mul(result.m_GT, result.m_GT, this->m_Table[i * entries + digit - 1].m_GT);
+    }
+  }
+  return result;
+}
 
 GT pairing(const G1 &x, const G2 &y) {
   GT tmp;
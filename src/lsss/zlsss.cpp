@@ -40,6 +40,8 @@
 #include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 
 #include "lsss/zobject.h"
@@ -48,6 +50,7 @@
 #include "lsss/zattributelist.h"
 #include "lsss/zdriver.h"
 #include "lsss/zlsss.h"
+#include "lsss/zscalar.h"
 
 using namespace std;
 
@@ -104,10 +107,37 @@ OpenABELSSS::shareSecret(const OpenABEFunctionInput *input, ZP &elt)
   // Clear any existing results
   this->clearExistingResults();
 
+  // The arithmetic below uses the compile-time group order
+  ZPFixed::initGroupOrder();
+
   // Recursively share the secret
   this->performSecretSharing(policy, elt);
 }
 
+/*!
+ * Share a secret over a compiled share-generating matrix. The results are
+ * the same rows as for shareSecret() on the policy the matrix was
+ * compiled from, without walking the policy tree.
+ *
+ * @param[in] matrix    - OpenABELSSSMatrix compiled from the policy
+ * @param[in] elt       - a ZP object to share
+ */
+
+void
+OpenABELSSS::shareSecret(const OpenABELSSSMatrix &matrix, ZP &elt)
+{
+  this->clearExistingResults();
+
+  vector<ZPFixed> shares;
+  matrix.shareSecret(ZPFixed::fromZP(elt), shares);
+
+  const vector<pair<string, string>> &rows = matrix.getRowLabels();
+  for (size_t i = 0; i < rows.size(); i++) {
+    ZP share = shares[i].toZP();
+    this->m_ResultMap[rows[i].first] = OpenABELSSSElement(rows[i].second, share);
+  }
+}
+
 /*!
  * Given an access structure (policy) and an input (attribute list)
  * generates the coefficients necessary to recover the secret.
@@ -125,6 +155,9 @@ OpenABELSSS::recoverCoefficients(OpenABEPolicy *policy, OpenABEAttributeList *at
   // Clear any existing results
   this->clearExistingResults();
 
+  // The arithmetic below uses the compile-time group order
+  ZPFixed::initGroupOrder();
+
   // Recursively compute the coefficients
   if (this->performCoefficientRecovery(policy, attrList) == false) {
     // If there was an error, clear any partial results and
@@ -139,6 +172,45 @@ OpenABELSSS::recoverCoefficients(OpenABEPolicy *policy, OpenABEAttributeList *at
   return true;
 }
 
+/*!
+ * Enumerate the rows that secret sharing produces for a policy without
+ * sharing anything: one (unique row label, attribute label) pair per leaf,
+ * from left to right. The unique labels are the keys of getRows().
+ *
+ * @param[in] policy    - OpenABEPolicy object describing the access structure
+ * @param[out] rows     - the row labels
+ */
+
+void
+OpenABELSSS::getRowLabels(const OpenABEPolicy *policy, vector<pair<string, string>> &rows)
+{
+  std::stack<OpenABETreeNode*> nodes;
+  OpenABETreeNode *node = NULL;
+
+  this->m_AttrCount.clear();
+  if(policy->hasDuplicateNodes()) {
+    policy->getDuplicateInfo(this->m_AttrCount);
+  }
+
+  rows.clear();
+  node = policy->getRootNode();
+  assert(node != NULL);
+  nodes.push(node);
+
+  while(!nodes.empty()) {
+    node = nodes.top();
+    nodes.pop();
+    if (node->getNodeType() == GATE_TYPE_LEAF) {
+      rows.push_back(make_pair(this->makeUniqueLabel(node), node->getCompleteLabel()));
+    } else {
+      // push the subnodes in reverse so that leaves come out left to right
+      for (uint32_t i = node->getNumSubnodes(); i > 0; i--) {
+        nodes.push(node->getSubnode(i-1));
+      }
+    }
+  }
+}
+
 /*!
  * Utility routine. Given an access structure (policy) and an element,
  * perform secret sharing on the given element.
@@ -198,14 +270,7 @@ OpenABELSSS::performCoefficientRecovery(OpenABEPolicy *policy, OpenABEAttributeL
   // Now that we've marked the nodes, we need to parse back down to the root,
   // computing the necessary coefficients at each stage. When we hit a leaf node,
   // the coefficient will be added to the m_ResultMap result list.
-  ZP one;
-  BPGroup group;
-
-  bn_null(one.m_ZP); bn_new(one.m_ZP);
-  bn_set_dig(one.m_ZP, 1);
-  one.setOrder(group.order);
-
-  return iterativeCoefficientRecover(node, one);
+  return iterativeCoefficientRecover(node, ZPFixed::fromUint(1));
 }
 
 /*!
@@ -222,28 +287,17 @@ void
 OpenABELSSS::iterativeShareSecret(OpenABETreeNode *treeNode, ZP &elt)
 {
   std::stack<OpenABETreeNode*> nodes;
-  std::stack<ZP> eltList;
+  std::stack<ZPFixed> eltList;
   OpenABETreeNode *visitedNode = NULL;
-  ZP theSecret, coefficient;
-  BPGroup group;
-
-  bn_null(theSecret.m_ZP); bn_new(theSecret.m_ZP);
-  bn_zero(theSecret.m_ZP);
-  theSecret.setOrder(group.order);
-
-  bn_null(coefficient.m_ZP); bn_new(coefficient.m_ZP);
-  bn_zero(coefficient.m_ZP);
-
-  coefficient.setOrder(group.order);
+  ZPFixed theSecret;
+  std::vector<ZPFixed> coefficients;
 
   // push the root to the stack
   nodes.push(treeNode);
-  eltList.push(elt);
-  OpenABEElementList coefficients;
+  eltList.push(ZPFixed::fromZP(elt));
 
   do {
     uint32_t threshold = 0, totalSubnodes = 0;
-    coefficients.clear();
 
     visitedNode  = nodes.top();
     theSecret    = eltList.top();
@@ -254,37 +308,34 @@ OpenABELSSS::iterativeShareSecret(OpenABETreeNode *treeNode, ZP &elt)
     // If the node is a leaf node, simply add the given element to the results
     // and return.
     if (visitedNode->getNodeType() == GATE_TYPE_LEAF) {
-      this->addShareToResults(visitedNode, theSecret);
+      ZP share = theSecret.toZP();
+      this->addShareToResults(visitedNode, share);
     }
     else {
       // First convert this node into a pair of values "threshold" and
       // "totalSubnodes" such that any "threshold"--out-of-"totalSubnodes"
       // shares permit secret recovery.
       totalSubnodes = visitedNode->getNumSubnodes();
-      assert((threshold = visitedNode->getThresholdValue()) != 0);
-
-      // Generate a polynomial consisting of "threshold" coefficients
-      for (uint32_t i = 0; i < threshold; i++) {
-        // Each coefficient is a random element of same field
-        // as the element
-
-        coefficient.setRandom(group.order);
-        coefficients.push_back(coefficient);
+      threshold = visitedNode->getThresholdValue();
+      assert(threshold != 0);
+
+      // Generate a polynomial consisting of "threshold" coefficients:
+      // position 0 is the passed in secret and the rest are random
+      // elements of the same field
+      coefficients.clear();
+      coefficients.push_back(theSecret);
+      for (uint32_t i = 1; i < threshold; i++) {
+        coefficients.push_back(ZPFixed::random());
       }
-      // set position 0 as the passed in secret
-      coefficients[0] = theSecret;
       // Now evaluate the polynomial at points (1, 2, ..., totalSubnodes) to
       // obtain the shares
       for (uint32_t i = 0; i < totalSubnodes; i++) {
         // Evaluate the polynomial at point (i+1) and recurse on the resulting value
-        ZP share = this->evaluatePolynomial(coefficients, (i+1));
         nodes.push(visitedNode->getSubnode(i));
-        eltList.push(share);
+        eltList.push(this->evaluatePolynomial(coefficients, (i+1)));
       }
     }
   } while(!nodes.empty());
-
-  coefficients.clear();
 }
 
 /*!
@@ -299,21 +350,12 @@ OpenABELSSS::iterativeShareSecret(OpenABETreeNode *treeNode, ZP &elt)
  */
 
 bool
-OpenABELSSS::iterativeCoefficientRecover(OpenABETreeNode *treeNode, ZP &inCoeff)
+OpenABELSSS::iterativeCoefficientRecover(OpenABETreeNode *treeNode, const ZPFixed &inCoeff)
 {
   std::stack<OpenABETreeNode*> nodes;
-  std::stack<ZP> coeffs;
+  std::stack<ZPFixed> coeffs;
   OpenABETreeNode *visitedNode = NULL;
-  ZP tmpInCoeff, coefficient;
-  BPGroup group;
-
-  bn_null(tmpInCoeff.m_ZP); bn_new(tmpInCoeff.m_ZP);
-  bn_zero(tmpInCoeff.m_ZP);
-  tmpInCoeff.setOrder(group.order);
-
-  bn_null(coefficient.m_ZP); bn_new(coefficient.m_ZP);
-  bn_zero(coefficient.m_ZP);
-  coefficient.setOrder(group.order);
+  ZPFixed tmpInCoeff;
 
   // push the root to the stack
   nodes.push(treeNode);
@@ -332,7 +374,8 @@ OpenABELSSS::iterativeCoefficientRecover(OpenABETreeNode *treeNode, ZP &inCoeff)
     // If the node is a leaf node, simply add the input coefficient  to the results
     // and return.
     if (visitedNode->getNodeType() == GATE_TYPE_LEAF) {
-      this->addShareToResults(visitedNode, tmpInCoeff);
+      ZP coefficient = tmpInCoeff.toZP();
+      this->addShareToResults(visitedNode, coefficient);
       result = true;
     }
     else {
@@ -362,9 +405,8 @@ OpenABELSSS::iterativeCoefficientRecover(OpenABETreeNode *treeNode, ZP &inCoeff)
       for (uint32_t i = 0; i < numSubnodes; i++) {
         if(visitedNode->getSubnode(i)->getMark() == true) {
           // compute coefficient for this node
-          coefficient = tmpInCoeff * calculateCoefficient(visitedNode, i, threshold, numSubnodes);
           nodes.push(visitedNode->getSubnode(i));
-          coeffs.push(coefficient);
+          coeffs.push(tmpInCoeff * calculateCoefficient(visitedNode, i, threshold, numSubnodes));
           result = true;
         }
       }
@@ -377,7 +419,10 @@ OpenABELSSS::iterativeCoefficientRecover(OpenABETreeNode *treeNode, ZP &inCoeff)
 
 /*!
  * Utility routine. Calculates a Lagrange interpolation coefficient for
- * share "index" out of "total" shares for a "threshold" secret sharing.
+ * share "index" out of "total" shares for a "threshold" secret sharing:
+ * the product over the other marked subnodes i of (0 - X(i)) / (X(index) - X(i)),
+ * where X(i) = i+1. Numerator and denominator are accumulated separately,
+ * so there is a single inversion per coefficient.
  *
  * @param[in] index            - Index of the coefficient
  * @param[in] threshold        - Threshold value
@@ -386,40 +431,22 @@ OpenABELSSS::iterativeCoefficientRecover(OpenABETreeNode *treeNode, ZP &inCoeff)
  * @throw                      - an exception if there is a problem sharing the element
  */
 
-ZP
+ZPFixed
 OpenABELSSS::calculateCoefficient(OpenABETreeNode *treeNode, uint32_t index, uint32_t threshold, uint32_t total)
 {
-  BPGroup group;
-  ZP result;
-
-  bn_null(result.m_ZP); bn_new(result.m_ZP);
-  bn_set_dig(result.m_ZP, 1);
-  result.setOrder(group.order);
-
-  bn_null(this->indexPlusOne.m_ZP);
-  bn_new(this->indexPlusOne.m_ZP);
-  bn_set_dig(this->indexPlusOne.m_ZP, index + 1);
+  ZPFixed numerator = ZPFixed::fromUint(1), denominator = ZPFixed::fromUint(1);
+  ZPFixed indexPlusOne = ZPFixed::fromUint(index + 1);
 
-  this->indexPlusOne.setOrder(group.order);
-
-  // Product for all marked subnodes (excluding index) of ( (0 - (X(i))) / (X(subnode_index) - (X(i))) )
-  // Note that X(i) = i+1.
-  for (uint32_t i = 0; i < threshold; i++) {
+  for (uint32_t i = 0; i < total; i++) {
     /* Check if this subnode is being used for the recovery.	*/
-
-    bn_null(this->iPlusOne.m_ZP);
-    bn_new(this->iPlusOne.m_ZP);
-    bn_set_dig(this->iPlusOne.m_ZP, i+1);
-    this->iPlusOne.setOrder(group.order);
-
-    if (treeNode->getSubnode(i)->getMark() == true) {
-      if (i != index) {
-        result *= result * ((this->zero - this->iPlusOne) / (this->indexPlusOne - this->iPlusOne));
-      }
+    if (i != index && treeNode->getSubnode(i)->getMark() == true) {
+      ZPFixed iPlusOne = ZPFixed::fromUint(i + 1);
+      numerator *= -iPlusOne;
+      denominator *= (indexPlusOne - iPlusOne);
     }
   }
 
-  return result;
+  return numerator * denominator.inverse();
 }
 
 /*!
@@ -449,27 +476,17 @@ OpenABELSSS::addShareToResults(OpenABETreeNode *treeNode, ZP &elt)
  * @throw                       - an exception if there is a problem
  */
 
-ZP
-OpenABELSSS::evaluatePolynomial(OpenABEElementList &coefficients, uint32_t x)
+ZPFixed
+OpenABELSSS::evaluatePolynomial(const std::vector<ZPFixed> &coefficients, uint32_t x)
 {
   // Make sure the coefficients vector is non-trivial
   assert(coefficients.size() > 0);
 
-  BPGroup group;
-  ZP share, xpow;
-  unsigned int i = 0;
-
-  bn_null(share.m_ZP); bn_new(share.m_ZP);
-  bn_zero(share.m_ZP);
-  share.setOrder(group.order);
-
-  bn_null(xpow.m_ZP); bn_new(xpow.m_ZP);
-  bn_set_dig(xpow.m_ZP, x);
-  xpow.setOrder(group.order);
-
-  for (OpenABEElementListIterator it = coefficients.begin(); it != coefficients.end(); ++it) {
-    share += ( *it * power(xpow, i) );
-    i++;
+  // Horner's rule: no powers of x are computed
+  ZPFixed xval = ZPFixed::fromUint(x);
+  ZPFixed share = coefficients.back();
+  for (size_t i = coefficients.size() - 1; i > 0; i--) {
+    share = share * xval + coefficients[i - 1];
   }
 
   return share;
@@ -556,7 +573,7 @@ bool iterativeScanTree(OpenABETreeNode *treeNode, OpenABEAttributeList *attribut
     } else {
       // Visit the node
       // This is a leaf node, so let's see if there's a match
-      bool leaf_matched = attributeList->matchAttribute(topNode->getCompleteLabel());
+      bool leaf_matched = attributeList->matchAttribute(topNode->getAttributeId());
       topNode->setMark(leaf_matched, leaf_matched ? 1 : 0);
       // mark this node as visited then pop from the stack
       topNode->m_Visited = true;
@@ -658,6 +675,217 @@ pair<bool, int> checkIfSatisfied(OpenABEPolicy *policy, OpenABEAttributeList *at
 }
 
 
+/********************************************************************************
+ * Implementation of the OpenABELSSSMatrix class
+ ********************************************************************************/
+
+/*!
+ * Compile the share-generating matrix of a policy. The rows are in the
+ * order of OpenABELSSS::getRowLabels() and the columns of a gate come
+ * after those of its ancestors.
+ *
+ * @param[in] policy    - OpenABEPolicy object describing the access structure
+ * @throw               - std::invalid_argument if a gate has no threshold
+ */
+
+OpenABELSSSMatrix::OpenABELSSSMatrix(const OpenABEPolicy *policy) : m_NumColumns(1)
+{
+  OpenABELSSS lsss;
+  lsss.getRowLabels(policy, this->m_RowLabels);
+  ZPFixed::initGroupOrder();
+
+  // each pending node carries the blocks of its ancestors
+  std::stack<pair<OpenABETreeNode*, vector<Block>>> nodes;
+  nodes.push(make_pair(policy->getRootNode(), vector<Block>()));
+  this->m_RowStart.push_back(0);
+
+  while(!nodes.empty()) {
+    OpenABETreeNode *node = nodes.top().first;
+    vector<Block> blocks = std::move(nodes.top().second);
+    nodes.pop();
+
+    if (node->getNodeType() == GATE_TYPE_LEAF) {
+      this->m_Blocks.insert(this->m_Blocks.end(), blocks.begin(), blocks.end());
+      this->m_RowStart.push_back((uint32_t) this->m_Blocks.size());
+      continue;
+    }
+
+    uint32_t threshold = node->getThresholdValue();
+    if (threshold == 0) {
+      throw invalid_argument("OpenABELSSSMatrix: gate without a threshold");
+    }
+    uint32_t column = this->m_NumColumns;
+    this->m_NumColumns += threshold - 1;
+    // push the subnodes in reverse so that leaves come out left to right
+    for (uint32_t i = node->getNumSubnodes(); i > 0; i--) {
+      vector<Block> subBlocks = blocks;
+      if (threshold > 1) {
+        subBlocks.push_back(Block{column, threshold - 1, ZPFixed::fromUint(i)});
+      }
+      nodes.push(make_pair(node->getSubnode(i-1), std::move(subBlocks)));
+    }
+  }
+  assert(this->m_RowStart.size() == this->m_RowLabels.size() + 1);
+}
+
+/*!
+ * Return the non-zero entries of a row as (column, value) pairs in
+ * increasing column order.
+ *
+ * @param[in] row       - index of the row
+ * @param[out] entries  - the entries
+ */
+
+void
+OpenABELSSSMatrix::getRow(size_t row, vector<pair<uint32_t, ZPFixed>> &entries) const
+{
+  if (row >= this->numRows()) {
+    throw out_of_range("OpenABELSSSMatrix::getRow: no such row");
+  }
+  entries.clear();
+  entries.push_back(make_pair(0, ZPFixed::fromUint(1)));
+  for (uint32_t b = this->m_RowStart[row]; b < this->m_RowStart[row+1]; b++) {
+    const Block &block = this->m_Blocks[b];
+    ZPFixed power = block.x;
+    for (uint32_t k = 0; k < block.length; k++) {
+      entries.push_back(make_pair(block.column + k, power));
+      power *= block.x;
+    }
+  }
+}
+
+/*!
+ * Compute the matrix-vector product: shares[i] = row i * vec.
+ *
+ * @param[in] vec       - vector with numColumns() entries
+ * @param[out] shares   - one entry per row
+ * @throw               - std::invalid_argument if the vector has the wrong length
+ */
+
+void
+OpenABELSSSMatrix::multiply(const vector<ZPFixed> &vec, vector<ZPFixed> &shares) const
+{
+  if (vec.size() != this->m_NumColumns) {
+    throw invalid_argument("OpenABELSSSMatrix::multiply: vector length does not match");
+  }
+  shares.resize(this->numRows());
+  for (size_t i = 0; i < shares.size(); i++) {
+    ZPFixed share = vec[0];
+    for (uint32_t b = this->m_RowStart[i]; b < this->m_RowStart[i+1]; b++) {
+      // x * vec[c] + x^2 * vec[c+1] + ... by Horner's rule
+      const Block &block = this->m_Blocks[b];
+      const ZPFixed *v = &vec[block.column];
+      ZPFixed sum;
+      for (uint32_t k = block.length; k > 0; k--) {
+        sum = (sum + v[k-1]) * block.x;
+      }
+      share += sum;
+    }
+    shares[i] = share;
+  }
+}
+
+/*!
+ * Share a secret: multiply the matrix by (secret, r_1, ..., r_{d-1}) for
+ * fresh random r_j.
+ *
+ * @param[in] secret    - the secret
+ * @param[out] shares   - one share per row
+ */
+
+void
+OpenABELSSSMatrix::shareSecret(const ZPFixed &secret, vector<ZPFixed> &shares) const
+{
+  vector<ZPFixed> vec(this->m_NumColumns);
+  vec[0] = secret;
+  for (size_t i = 1; i < vec.size(); i++) {
+    vec[i] = ZPFixed::random();
+  }
+  this->multiply(vec, shares);
+}
+
+/*!
+ * Check that reconstruction coefficients (as returned by
+ * OpenABELSSS::recoverCoefficients) combine the rows they name into
+ * (1, 0, ..., 0), i.e. that they recover the secret from any sharing.
+ *
+ * @param[in] coefficients  - coefficients keyed by unique row label
+ * @return                  - true if they are a valid reconstruction
+ */
+
+bool
+OpenABELSSSMatrix::checkReconstruction(const OpenABELSSSRowMap &coefficients) const
+{
+  vector<ZPFixed> sum(this->m_NumColumns);
+  vector<pair<uint32_t, ZPFixed>> entries;
+  size_t found = 0;
+  for (size_t i = 0; i < this->numRows(); i++) {
+    auto it = coefficients.find(this->m_RowLabels[i].first);
+    if (it == coefficients.end()) {
+      continue;
+    }
+    found++;
+    ZPFixed weight = ZPFixed::fromZP(it->second.element());
+    this->getRow(i, entries);
+    for (auto& entry : entries) {
+      sum[entry.first] += weight * entry.second;
+    }
+  }
+  if (found != coefficients.size()) {
+    // a coefficient for a row that does not exist
+    return false;
+  }
+
+  if (sum[0] != ZPFixed::fromUint(1)) {
+    return false;
+  }
+  for (size_t j = 1; j < sum.size(); j++) {
+    if (!sum[j].isZero()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+ * Export the matrix for inspection, one row per line:
+ *   <unique label>: <column>=<hex value> ...
+ * listing the non-zero entries.
+ *
+ * @return                  - the matrix as a string
+ */
+
+string
+OpenABELSSSMatrix::toString() const
+{
+  static const char *hex = "0123456789abcdef";
+  stringstream ss;
+  vector<pair<uint32_t, ZPFixed>> entries;
+  uint8_t buf[OpenABE_ZP_FIXED_BYTES];
+
+  ss << this->numRows() << " x " << this->m_NumColumns << "\n";
+  for (size_t i = 0; i < this->numRows(); i++) {
+    ss << this->m_RowLabels[i].first << ":";
+    this->getRow(i, entries);
+    for (auto& entry : entries) {
+      entry.second.toBytes(buf);
+      size_t start = 0;
+      while (start < OpenABE_ZP_FIXED_BYTES - 1 && buf[start] == 0) {
+        start++;
+      }
+      ss << " " << entry.first << "=";
+      for (size_t b = start; b < OpenABE_ZP_FIXED_BYTES; b++) {
+        if (b > start || buf[b] >= 0x10) {
+          ss << hex[buf[b] >> 4];
+        }
+        ss << hex[buf[b] & 0x0f];
+      }
+    }
+    ss << "\n";
+  }
+  return ss.str();
+}
+
 #ifndef OpenABE_NO_TEST_ROUTINES
 
 //
@@ -40,6 +40,7 @@
 #include <string>
 #include <stack>
 
+#include "lsss/zattributelist.h"
 #include "lsss/zpolicy.h"
 #include "lsss/zdriver.h"
 
@@ -218,6 +219,21 @@ OpenABETreeNode::getThresholdValue() {
   return result;
 }
 
+/*!
+ * Get the interned ID of the complete label of a leaf, interning it on
+ * first use.
+ *
+ * @return                 - the attribute ID
+ */
+
+uint32_t
+OpenABETreeNode::getAttributeId() {
+  if (this->m_AttributeId < 0) {
+    this->m_AttributeId = OpenABEAttributeInterner::getInstance().intern(this->getCompleteLabel());
+  }
+  return (uint32_t) this->m_AttributeId;
+}
+
 /*!
  * Get the subnode at position "index".
  *
@@ -250,6 +266,14 @@ OpenABETreeNode::OpenABETreeNode(OpenABETreeNode *copy) {
   if (this->m_nodeType == GATE_TYPE_LEAF) {
     this->m_Prefix          = copy->m_Prefix;
     this->m_Label           = copy->m_Label;
+    this->m_AttributeId     = copy->m_AttributeId;
+    // the index makes the row label of a duplicate attribute unique
+    this->m_Index           = copy->m_Index;
+    this->m_numSubnodes     = 0;
+    this->m_thresholdValue  = 0;
+    this->m_Mark            = false;
+    this->m_Satisfied       = 0;
+    this->m_Visited         = false;
     return;
   }
 
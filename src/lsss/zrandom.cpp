@@ -0,0 +1,214 @@
+/// 
+/// Copyright (c) 2018 Zeutro, LLC. All rights reserved.
+/// 
+/// This file is part of Zeutro's OpenABE.
+/// 
+/// OpenABE is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU Affero General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+/// 
+/// OpenABE is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU Affero General Public License for more details.
+/// 
+/// You should have received a copy of the GNU Affero General Public
+/// License along with OpenABE. If not, see <http://www.gnu.org/licenses/>.
+/// 
+/// You can be released from the requirements of the GNU Affero General
+/// Public License and obtain additional features by purchasing a
+/// commercial license. Buying such a license is mandatory if you
+/// engage in commercial activities involving OpenABE that do not
+/// comply with the open source requirements of the GNU Affero General
+/// Public License. For more information on commerical licenses,
+/// visit <http://www.zeutro.com>.
+///
+/// \file   zrandom.cpp
+///
+/// \brief  Implementation of the per-thread buffered random number
+///         generator.
+///
+
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+#include <pthread.h>
+#include <openssl/rand.h>
+
+#include "lsss/zrandom.h"
+
+using namespace std;
+
+/********************************************************************************
+ * Implementation of the OpenABERandom class
+ ********************************************************************************/
+
+// bumped in the child after every fork, so each generator notices it was
+// forked with a load instead of a getpid() system call per draw
+static atomic<uint64_t> OpenABE_forkGeneration(0);
+
+static void OpenABE_onForkChild() {
+  OpenABE_forkGeneration.fetch_add(1, memory_order_relaxed);
+}
+
+OpenABERandom& OpenABERandom::getInstance() {
+  static thread_local OpenABERandom instance;
+  return instance;
+}
+
+OpenABERandom::OpenABERandom() {
+  static const int registered = pthread_atfork(NULL, NULL, OpenABE_onForkChild);
+  if (registered != 0) {
+    throw runtime_error("OpenABERandom: cannot register the fork handler");
+  }
+  this->ctx = EVP_CIPHER_CTX_new();
+  if (this->ctx == NULL) {
+    throw runtime_error("OpenABERandom: cannot allocate cipher context");
+  }
+  this->reseed();
+}
+
+OpenABERandom::~OpenABERandom() {
+  OPENSSL_cleanse(this->buffer, sizeof(this->buffer));
+  EVP_CIPHER_CTX_free(this->ctx);
+}
+
+/*!
+ * Key the generator with fresh entropy from the OS and drop any buffered
+ * output.
+ */
+void OpenABERandom::reseed() {
+  uint8_t key[OpenABE_RNG_KEY_LEN];
+  if (RAND_bytes(key, OpenABE_RNG_KEY_LEN) != 1 ||
+      EVP_EncryptInit_ex(this->ctx, EVP_aes_256_ctr(), NULL, key, NULL) != 1) {
+    OPENSSL_cleanse(key, sizeof(key));
+    throw runtime_error("OpenABERandom: cannot seed the generator");
+  }
+  OPENSSL_cleanse(key, sizeof(key));
+  this->position = OpenABE_RNG_BUFFER_SIZE;
+  this->generated = 0;
+  this->forkGeneration = OpenABE_forkGeneration.load(memory_order_relaxed);
+}
+
+/*!
+ * Produce the next batch of output. The last OpenABE_RNG_KEY_LEN bytes of
+ * the keystream become the next key and are erased, so earlier output
+ * cannot be recomputed from the generator state.
+ */
+void OpenABERandom::refill() {
+  int len = 0;
+  memset(this->buffer, 0, sizeof(this->buffer));
+  if (EVP_EncryptUpdate(this->ctx, this->buffer, &len, this->buffer,
+                        sizeof(this->buffer)) != 1 ||
+      EVP_EncryptInit_ex(this->ctx, NULL, NULL,
+                         this->buffer + OpenABE_RNG_BUFFER_SIZE, NULL) != 1) {
+    throw runtime_error("OpenABERandom: keystream generation failed");
+  }
+  OPENSSL_cleanse(this->buffer + OpenABE_RNG_BUFFER_SIZE, OpenABE_RNG_KEY_LEN);
+  this->position = 0;
+  this->generated += OpenABE_RNG_BUFFER_SIZE;
+}
+
+/*!
+ * Fill a buffer with random bytes. Bytes handed out are wiped from the
+ * internal buffer.
+ *
+ * @param[out]  the buffer.
+ * @param[in]   number of bytes.
+ */
+void OpenABERandom::getBytes(uint8_t *buf, size_t len) {
+  if (OpenABE_forkGeneration.load(memory_order_relaxed) != this->forkGeneration ||
+      this->generated >= OpenABE_RNG_RESEED_BYTES) {
+    // a forked child must not repeat the parent's output
+    this->reseed();
+  }
+  while (len > 0) {
+    if (this->position == OpenABE_RNG_BUFFER_SIZE) {
+      this->refill();
+    }
+    size_t n = min(len, (size_t) (OpenABE_RNG_BUFFER_SIZE - this->position));
+    memcpy(buf, this->buffer + this->position, n);
+    OPENSSL_cleanse(this->buffer + this->position, n);
+    this->position += n;
+    buf += n;
+    len -= n;
+  }
+}
+
+/*!
+ * Draw count values uniformly from [0, bound) by rejection sampling. Each
+ * candidate has the bit length of the bound, so at least half of them are
+ * accepted.
+ *
+ * @param[in]   the bound (big-endian, no leading zero byte).
+ * @param[in]   length of the bound in bytes.
+ * @param[out]  count values of boundLen bytes each (big-endian).
+ * @param[in]   number of values.
+ */
+void OpenABERandom::sampleBelow(const uint8_t *bound, size_t boundLen,
+                                uint8_t *out, size_t count) {
+  if (boundLen == 0) {
+    throw invalid_argument("OpenABERandom::sampleBelow: empty bound");
+  }
+  // mask the top byte down to the bit length of the bound
+  uint8_t mask = 0xFF;
+  while ((mask >> 1) >= bound[0]) {
+    mask >>= 1;
+  }
+  this->getBytes(out, boundLen * count);
+  for (size_t i = 0; i < count; i++) {
+    uint8_t *candidate = out + i * boundLen;
+    candidate[0] &= mask;
+    while (memcmp(candidate, bound, boundLen) >= 0) {
+      this->getBytes(candidate, boundLen);
+      candidate[0] &= mask;
+    }
+  }
+}
+
+/********************************************************************************
+ * Sampling of group scalars
+ ********************************************************************************/
+
+/*!
+ * Set result to a uniformly random value modulo order.
+ *
+ * @param[out]  the random value.
+ * @param[in]   the group order.
+ */
+void OpenABE_randomBelow(bignum_t result, bignum_t order) {
+  size_t len = zmbignum_countbytes(order);
+  vector<uint8_t> bound(len), value(len);
+  zmbignum_toBin(order, bound.data(), len);
+  OpenABERandom::getInstance().sampleBelow(bound.data(), len, value.data(), 1);
+  zmbignum_fromBin(result, value.data(), len);
+  OPENSSL_cleanse(value.data(), len);
+}
+
+/*!
+ * Draw count random scalars modulo order in one pass: the candidates are
+ * generated in a single batch and only rejected ones are redrawn.
+ *
+ * @param[in]   number of scalars.
+ * @param[in]   the group order.
+ * @return      the scalars.
+ */
+vector<ZP> OpenABE_randomZPs(size_t count, bignum_t order) {
+  vector<ZP> result;
+  if (count == 0) {
+    return result;
+  }
+  size_t len = zmbignum_countbytes(order);
+  vector<uint8_t> bound(len), values(len * count);
+  zmbignum_toBin(order, bound.data(), len);
+  OpenABERandom::getInstance().sampleBelow(bound.data(), len, values.data(), count);
+
+  result.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    result.emplace_back(values.data() + i * len, len, order);
+  }
+  OPENSSL_cleanse(values.data(), values.size());
+  return result;
+}
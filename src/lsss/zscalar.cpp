@@ -0,0 +1,193 @@
+/// 
+/// Copyright (c) 2018 Zeutro, LLC. All rights reserved.
+/// 
+/// This file is part of Zeutro's OpenABE.
+/// 
+/// OpenABE is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU Affero General Public License as published by
+/// the Free Software Foundation, either version 3 of the License, or
+/// (at your option) any later version.
+/// 
+/// OpenABE is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU Affero General Public License for more details.
+/// 
+/// You should have received a copy of the GNU Affero General Public
+/// License along with OpenABE. If not, see <http://www.gnu.org/licenses/>.
+/// 
+/// You can be released from the requirements of the GNU Affero General
+/// Public License and obtain additional features by purchasing a
+/// commercial license. Buying such a license is mandatory if you
+/// engage in commercial activities involving OpenABE that do not
+/// comply with the open source requirements of the GNU Affero General
+/// Public License. For more information on commerical licenses,
+/// visit <http://www.zeutro.com>.
+///
+/// \file   zscalar.cpp
+///
+/// \brief  Conversions and inversion for the fixed-width scalar type.
+///
+
+#include <stdexcept>
+#include <vector>
+
+#include "lsss/zscalar.h"
+#include "lsss/zrandom.h"
+
+using namespace std;
+
+/********************************************************************************
+ * Implementation of the ZPFixed class
+ ********************************************************************************/
+
+#ifndef OpenABE_ZP_FIXED_MODULUS
+ZPFixed::Limbs ZPFixed::MODULUS{};
+uint64_t ZPFixed::N0INV = 0;
+ZPFixed::Limbs ZPFixed::R2{};
+#endif
+
+// the group order as reported by RELIC, read once and only read afterwards
+static BPGroup& zpfixedGroup() {
+  static BPGroup group;
+  return group;
+}
+
+// the group order in big-endian byte order, without leading zero bytes
+static vector<uint8_t> zpfixedOrderBytes() {
+  BPGroup &group = zpfixedGroup();
+  vector<uint8_t> bytes(zmbignum_countbytes(group.order));
+  zmbignum_toBin(group.order, bytes.data(), bytes.size());
+  return bytes;
+}
+
+/*!
+ * Bind ZPFixed to the order of the groups RELIC was initialized with. A
+ * compile-time modulus is compared against it, otherwise the modulus and
+ * the Montgomery constants are derived from it. Done once per process;
+ * the LSSS entry points call this before any arithmetic.
+ *
+ * @throw   std::runtime_error if the order does not match the compiled
+ *          modulus or does not fit in OpenABE_ZP_FIXED_LIMBS limbs.
+ */
+void ZPFixed::initGroupOrder() {
+  static const bool valid = []() {
+    vector<uint8_t> order = zpfixedOrderBytes();
+    if (order.empty() || order.size() > OpenABE_ZP_FIXED_BYTES) {
+      return false;
+    }
+    Limbs value{};
+    for (size_t i = 0; i < order.size(); i++) {
+      value[i / 8] |= (uint64_t) order[order.size() - 1 - i] << (8 * (i % 8));
+    }
+#ifdef OpenABE_ZP_FIXED_MODULUS
+    return value == MODULUS;
+#else
+    if ((value[0] & 1) == 0) {
+      return false;
+    }
+    MODULUS = value;
+    N0INV = zpfixed_montInverse(MODULUS);
+    R2 = zpfixed_montR2(MODULUS);
+    return true;
+#endif
+  }();
+  if (!valid) {
+    throw runtime_error("ZPFixed: unsupported group order for FP_PRIME");
+  }
+}
+
+ZPFixed ZPFixed::fromUint(uint64_t x) {
+  initGroupOrder();
+  ZPFixed r;
+  Limbs value{};
+  value[0] = x;
+  // x * R^2 * R^-1 = x * R
+  montMul(r.v, value, R2);
+  return r;
+}
+
+/*!
+ * Convert a big-endian integer of at most OpenABE_ZP_FIXED_BYTES bytes,
+ * reducing it modulo MODULUS.
+ *
+ * @param[in]   the integer.
+ * @param[in]   its length in bytes.
+ * @return      the field element.
+ */
+ZPFixed ZPFixed::fromBytes(const uint8_t *buf, size_t len) {
+  if (len > OpenABE_ZP_FIXED_BYTES) {
+    throw invalid_argument("ZPFixed::fromBytes: integer is too long");
+  }
+  initGroupOrder();
+  Limbs value{};
+  for (size_t i = 0; i < len; i++) {
+    value[i / 8] |= (uint64_t) buf[len - 1 - i] << (8 * (i % 8));
+  }
+  // value < R and R2 < MODULUS, so the product is fully reduced
+  ZPFixed r;
+  montMul(r.v, value, R2);
+  return r;
+}
+
+ZPFixed ZPFixed::fromZP(const ZP &z) {
+  uint8_t buf[OpenABE_ZP_FIXED_BYTES];
+  size_t len = zmbignum_countbytes(z.m_ZP);
+  if (len > OpenABE_ZP_FIXED_BYTES) {
+    throw invalid_argument("ZPFixed::fromZP: element is not reduced");
+  }
+  zmbignum_toBin(z.m_ZP, buf, len);
+  ZPFixed r = fromBytes(buf, len);
+  return (zmbignum_sign(z.m_ZP) == RLC_NEG) ? -r : r;
+}
+
+/*!
+ * Sample a uniformly random element. Montgomery form is a bijection on
+ * [0, MODULUS), so the sample is used as the representation directly.
+ */
+ZPFixed ZPFixed::random() {
+  initGroupOrder();
+  static const vector<uint8_t> bound = zpfixedOrderBytes();
+  uint8_t buf[OpenABE_ZP_FIXED_BYTES];
+  OpenABERandom::getInstance().sampleBelow(bound.data(), bound.size(), buf, 1);
+  ZPFixed r;
+  for (size_t i = 0; i < bound.size(); i++) {
+    r.v[i / 8] |= (uint64_t) buf[bound.size() - 1 - i] << (8 * (i % 8));
+  }
+  return r;
+}
+
+void ZPFixed::toBytes(uint8_t out[OpenABE_ZP_FIXED_BYTES]) const {
+  Limbs value, one{};
+  one[0] = 1;
+  montMul(value, this->v, one);
+  for (int i = 0; i < OpenABE_ZP_FIXED_BYTES; i++) {
+    out[OpenABE_ZP_FIXED_BYTES - 1 - i] = (uint8_t) (value[i / 8] >> (8 * (i % 8)));
+  }
+}
+
+ZP ZPFixed::toZP() const {
+  uint8_t buf[OpenABE_ZP_FIXED_BYTES];
+  this->toBytes(buf);
+  return ZP(buf, OpenABE_ZP_FIXED_BYTES, zpfixedGroup().order);
+}
+
+/*!
+ * Multiplicative inverse by exponentiation to MODULUS - 2. The inverse of
+ * zero is zero.
+ *
+ * @return  the inverse.
+ */
+ZPFixed ZPFixed::inverse() const {
+  Limbs exponent, two{};
+  two[0] = 2;
+  zpfixed_subtract(exponent, MODULUS, two);
+  ZPFixed result = fromUint(1);
+  for (int i = 64 * OpenABE_ZP_FIXED_LIMBS - 1; i >= 0; i--) {
+    result *= result;
+    if ((exponent[i / 64] >> (i % 64)) & 1) {
+      result *= *this;
+    }
+  }
+  return result;
+}
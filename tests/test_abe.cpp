@@ -33,16 +33,21 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <atomic>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <math.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #include <gtest/gtest.h>
 
 #include <abe_lsss.h>
 
 #include "../utils/utils.h"
+#include "../utils/policygen.h"
 
 using namespace std;
 
@@ -52,56 +57,6 @@ using namespace std;
 #define TEST_DESCRIPTION(desc) RecordProperty("description", desc)
 #define TESTSUITE_DESCRIPTION(desc) ::testing::Test::RecordProperty("description", desc)
 
-string createAttribute(int i)
-{
-    stringstream ss;
-    ss << "Attr" << i;
-    return ss.str();
-}
-
-bool getOpenABEAttributeList(int max, vector<string> & attrList)
-{
-    if(max <= 0) { return false; }
-    int start = 0;
-    // reset
-    attrList.clear();
-    for(int i = start; i <= max; i++) {
-        attrList.push_back(createAttribute(i));
-    }
-    return true;
-}
-
-// returns an evenly distributed / balanced policy tree
-string getBalancedOpenABETree(int start, int end) {
-    if(start == end) { return createAttribute(start); }
-    int mid = ceil((start + (end - start) / 2.0));
-    if(mid == 0) {
-        return "(" + createAttribute(start) + " and " + createAttribute(end) + ")";
-    }
-    else {
-        return "(" + getBalancedOpenABETree(start, mid-1) + " and " + getBalancedOpenABETree(mid, end) + ")";
-    }
-}
-
-// returns a right-sided skewed policy tree
-string getOpenABEPolicyString(int max)
-{
-    string policystr;
-    if(max >= 2) {
-        policystr = "(" + createAttribute(0) + " and " + createAttribute(1) + ")";
-    }
-    else if(max == 1) {
-        policystr = createAttribute(0);
-    }
-
-    for(int i = 2; i <= max; i++)
-    {
-        policystr = "(" + policystr + " and " + createAttribute(i) + ")";
-    }
-
-    return policystr;
-}
-
 bool runLSSSTest(string policy_str, string attr_list_str, bool verbose = false)
 {
     // Create a pairing object
@@ -151,6 +106,37 @@ TEST(Attribute, SerializeAndDeserialize) {
     ASSERT_TRUE(attr_list.isEqual(&attr_list2));
 }
 
+TEST(Attribute, InternedMatching) {
+    TEST_DESCRIPTION("Testing attribute matching through interned IDs");
+    OpenABEAttributeInterner& interner = OpenABEAttributeInterner::getInstance();
+    const uint32_t id = interner.intern("InternedAlice");
+    ASSERT_EQ(interner.intern("InternedAlice"), id);
+    ASSERT_NE(interner.intern("InternedBob"), id);
+
+    unique_ptr<OpenABEAttributeList> attr_list = createAttributeList("|InternedAlice|uid:7|Floor=3|");
+    ASSERT_TRUE(attr_list->matchAttribute(id));
+    ASSERT_TRUE(attr_list->matchAttribute("uid:7"));
+    ASSERT_FALSE(attr_list->matchAttribute("InternedBob"));
+    ASSERT_FALSE(attr_list->matchAttribute("NeverInterned"));
+    // expanded numeric attributes are matched too
+    for (auto& attr : *attr_list->getAttributeList()) {
+        ASSERT_TRUE(attr_list->matchAttribute(attr));
+    }
+    // copies keep the interned IDs
+    OpenABEAttributeList copy(*attr_list);
+    ASSERT_TRUE(copy.matchAttribute(id));
+    // one sorted ID per attribute, however large the process-wide IDs get
+    const vector<uint32_t>& ids = attr_list->getAttributeIds();
+    ASSERT_LE(ids.size(), attr_list->getAttributeList()->size());
+    ASSERT_TRUE(is_sorted(ids.begin(), ids.end()));
+    ASSERT_TRUE(adjacent_find(ids.begin(), ids.end()) == ids.end());
+
+    unique_ptr<OpenABEPolicy> policy = createPolicyTree("(InternedAlice and Floor in (2-5))");
+    ASSERT_TRUE(checkIfSatisfied(policy.get(), attr_list.get()).first);
+    unique_ptr<OpenABEAttributeList> attr_list2 = createAttributeList("|InternedAlice|Floor=7|");
+    ASSERT_FALSE(checkIfSatisfied(policy.get(), attr_list2.get()).first);
+}
+
 class PolicyParser : public ::testing::Test {
  protected:
   virtual void SetUp() { }
@@ -371,6 +357,565 @@ TEST(LSSS, TestCorrectnessWithDupAttributes) {
     ASSERT_TRUE(runLSSSTest("((Alice and Alice) and Bob)", attrList, verbose));
 }
 
+TEST(LSSS, TestCorrectnessOfFlatGates) {
+    TEST_DESCRIPTION("Testing correctness of gates with more than two inputs");
+    string attrList = "|Alice|Bob|Charlie|David|Eve";
+    bool verbose = false;
+    ASSERT_TRUE(runLSSSTest("(Alice and Bob and Charlie)", attrList, verbose));
+    ASSERT_TRUE(runLSSSTest("(Alice and Bob and Charlie and David and Eve)", attrList, verbose));
+    ASSERT_TRUE(runLSSSTest("(Frank or Alice or Bob)", attrList, verbose));
+    ASSERT_TRUE(runLSSSTest("((Alice and Bob and Charlie) or Frank)", attrList, verbose));
+    ASSERT_FALSE(runLSSSTest("(Alice and Bob and Frank)", attrList, verbose));
+}
+
+TEST(LSSS, MatrixMatchesTreeSharing) {
+    TEST_DESCRIPTION("Testing the compiled share-generating matrix against tree sharing and recovery");
+    OpenABEPairing pairing;
+    const vector<pair<string, string>> cases = {
+        {"(Alice and Bob)", "|Alice|Bob"},
+        {"((Alice and Bob and Charlie) or David)", "|Alice|Bob|Charlie"},
+        {"((Alice or Bob) and (Charlie and (David or Eve)))", "|Bob|Charlie|Eve"},
+        {"((Alice and Alice) or (Bob and Charlie))", "|Alice"},
+        {"Alice", "|Alice"}
+    };
+    for (auto& c : cases) {
+        unique_ptr<OpenABEPolicy> policy = createPolicyTree(c.first);
+        unique_ptr<OpenABEAttributeList> attrList = createAttributeList(c.second);
+        ASSERT_TRUE(policy != nullptr && attrList != nullptr);
+        OpenABELSSSMatrix matrix(policy.get());
+
+        vector<pair<string, string>> rows;
+        OpenABELSSS lsss;
+        lsss.getRowLabels(policy.get(), rows);
+        ASSERT_TRUE(matrix.getRowLabels() == rows);
+
+        ZP secret = pairing.randomZP();
+        lsss.shareSecret(matrix, secret);
+        OpenABELSSSRowMap shares = lsss.getRows();
+        ASSERT_EQ(shares.size(), matrix.numRows());
+
+        OpenABELSSS recoveryLsss;
+        ASSERT_TRUE(recoveryLsss.recoverCoefficients(policy.get(), attrList.get()));
+        OpenABELSSSRowMap coefficients = recoveryLsss.getRows();
+        ASSERT_TRUE(matrix.checkReconstruction(coefficients));
+        ASSERT_TRUE(recoveryLsss.LSSStestSecretRecovery(coefficients, shares) == secret);
+    }
+
+    // an AND of three leaves has two random columns with entries x, x^2
+    OpenABELSSSMatrix matrix(createPolicyTree("(Alice and Bob and Charlie)").get());
+    ASSERT_EQ(matrix.numRows(), 3u);
+    ASSERT_EQ(matrix.numColumns(), 3u);
+    vector<pair<uint32_t, ZPFixed>> entries;
+    matrix.getRow(2, entries);
+    ASSERT_EQ(entries.size(), 3u);
+    ASSERT_TRUE(entries[1].second == ZPFixed::fromUint(3));
+    ASSERT_TRUE(entries[2].second == ZPFixed::fromUint(9));
+    string exported = matrix.toString();
+    ASSERT_NE(exported.find(matrix.getRowLabels()[2].first + ": 0=1 1=3 2=9\n"), string::npos);
+}
+
+TEST(ZPFixed, MatchesZPArithmetic) {
+    TEST_DESCRIPTION("Testing the fixed-width scalar type against ZP");
+    OpenABEPairing pairing;
+    ZPFixed::initGroupOrder();
+    for (int i = 0; i < 16; i++) {
+        ZP a = pairing.randomZP(), b = pairing.randomZP();
+        ZPFixed x = ZPFixed::fromZP(a), y = ZPFixed::fromZP(b);
+        ASSERT_TRUE(x.toZP() == a);
+        ASSERT_TRUE((x + y).toZP() == a + b);
+        ASSERT_TRUE((x - y).toZP() == a - b);
+        ASSERT_TRUE((x * y).toZP() == a * b);
+        ASSERT_TRUE((x * y.inverse()).toZP() == a / b);
+        ASSERT_TRUE((-x).toZP() == -a);
+    }
+    ZP seven = pairing.initZP();
+    pairing.initZP(seven, 7);
+    ASSERT_TRUE(ZPFixed::fromUint(7).toZP() == seven);
+    ASSERT_TRUE(ZPFixed::fromUint(7) * ZPFixed::fromUint(7).inverse() == ZPFixed::fromUint(1));
+    ASSERT_TRUE((ZPFixed::fromUint(3) - ZPFixed::fromUint(3)).isZero());
+    ASSERT_FALSE(ZPFixed::random() == ZPFixed::random());
+}
+
+TEST(CompiledPolicy, RowsMatchSecretSharing) {
+    TEST_DESCRIPTION("Testing that compiled policies are cached and list the LSSS rows");
+    OpenABEPairing pairing;
+    const string policyStr = "((Alice and Alice) or (Bob and Charlie))";
+    shared_ptr<const OpenABECompiledPolicy> compiled = OpenABE_getCompiledPolicy(policyStr);
+    ASSERT_TRUE(compiled != nullptr);
+    ASSERT_TRUE(OpenABE_getCompiledPolicy(policyStr) == compiled);
+
+    ZP secret = pairing.randomZP();
+    OpenABELSSS lsss;
+    lsss.shareSecret(compiled.get(), secret);
+    OpenABELSSSRowMap shares = lsss.getRows();
+    ASSERT_EQ(compiled->getRows().size(), shares.size());
+    for (auto& row : compiled->getRows()) {
+        ASSERT_TRUE(shares.count(row.first) == 1);
+        ASSERT_EQ(shares[row.first].label(), row.second);
+    }
+
+    OpenABEByteString k;
+    getRandomBytes(k, 32);
+    shared_ptr<const OpenABEHashedAttributes> points = compiled->getHashedAttributes(&pairing, k);
+    ASSERT_EQ(points->size(), 3u);
+    ASSERT_TRUE(compiled->getHashedAttributes(&pairing, k) == points);
+    for (auto& row : compiled->getRows()) {
+        G1 expected = pairing.hashToG1(k, row.second);
+        ASSERT_TRUE(points->at(row.second) == expected);
+    }
+}
+
+TEST(CompiledPolicy, CopiesKeepDuplicateRowLabels) {
+    TEST_DESCRIPTION("Testing that copied policy trees label duplicate attributes like the original");
+    OpenABEPairing pairing;
+    const string policyStr = "((Alice and Alice) or Bob)";
+    unique_ptr<OpenABEPolicy> parsed = createPolicyTree(policyStr);
+    ASSERT_TRUE(parsed != nullptr);
+    vector<pair<string, string>> expected, copied;
+    OpenABELSSS lsss;
+    lsss.getRowLabels(parsed.get(), expected);
+    ASSERT_EQ(expected.size(), 3u);
+    ASSERT_NE(expected[0].first, expected[1].first);
+
+    shared_ptr<const OpenABECompiledPolicy> compiled = OpenABE_getCompiledPolicy(policyStr);
+    ASSERT_TRUE(compiled != nullptr);
+    ASSERT_TRUE(compiled->getRows() == expected);
+    unique_ptr<OpenABEPolicy> copy = compiled->copyPolicyTree();
+    lsss.getRowLabels(copy.get(), copied);
+    ASSERT_TRUE(copied == expected);
+}
+
+TEST(CompiledPolicy, DuplicateAttributesRoundTrip) {
+    TEST_DESCRIPTION("Testing encrypt/decrypt for CP and KP policies with a duplicate attribute");
+    const string policyStr = "((Alice and Alice) or (Bob and Alice))";
+    for (OpenABE_SCHEME scheme : {OpenABE_SCHEME_CP_WATERS, OpenABE_SCHEME_KP_GPSW}) {
+        unique_ptr<OpenABEContextSchemeCPA> context = createContextABESchemeCPA(scheme);
+        ASSERT_TRUE(context != nullptr);
+        ASSERT_TRUE(context->generateParams("dupMPK", "dupMSK") == OpenABE_NOERROR);
+
+        unique_ptr<OpenABEFunctionInput> policy = createPolicyTree(policyStr);
+        unique_ptr<OpenABEFunctionInput> attributes = createAttributeList("Alice|Bob");
+        OpenABEFunctionInput *encInput = (scheme == OpenABE_SCHEME_CP_WATERS) ? policy.get() : attributes.get();
+        OpenABEFunctionInput *keyInput = (scheme == OpenABE_SCHEME_CP_WATERS) ? attributes.get() : policy.get();
+        ASSERT_TRUE(context->keygen(keyInput, "dupKey", "dupMPK", "dupMSK") == OpenABE_NOERROR);
+
+        OpenABEByteString plaintext, recovered, ctBlob;
+        getRandomBytes(plaintext, TEST_MSG_LEN);
+        OpenABECiphertext ciphertext, loaded;
+        ASSERT_TRUE(context->encrypt("dupMPK", encInput, plaintext, ciphertext) == OpenABE_NOERROR);
+        ciphertext.exportToBytes(ctBlob);
+        loaded.loadFromBytes(ctBlob);
+        ASSERT_TRUE(context->decrypt("dupMPK", "dupKey", recovered, loaded) == OpenABE_NOERROR);
+        ASSERT_TRUE(plaintext == recovered);
+    }
+}
+
+TEST(Container, EqualityComparesKeysAndValues) {
+    TEST_DESCRIPTION("Testing container equality on keys, values and serialized components");
+    OpenABEByteString a, b, blob;
+    a = "first";
+    b = "second";
+
+    OpenABECiphertext ct1, ct2, ct3, loaded;
+    ct1.setComponent("A", &a);
+    ct1.setComponent("B", &b);
+    ct2.setComponent("A", &a);
+    ct2.setComponent("B", &b);
+    ASSERT_TRUE(ct1 == ct2);
+
+    // same number of components under different names
+    ct3.setComponent("A", &a);
+    ct3.setComponent("C", &b);
+    ASSERT_FALSE(ct1 == ct3);
+
+    // a loaded (undecoded) container compares against the original
+    ct1.exportToBytes(blob);
+    loaded.loadFromBytes(blob);
+    ASSERT_TRUE(loaded == ct1);
+    ct2.setComponent("B", &a);
+    ASSERT_FALSE(loaded == ct2);
+}
+
+TEST(MultiExp, MatchesSumOfProducts) {
+    TEST_DESCRIPTION("Testing multi-scalar multiplication in G1 and G2");
+    OpenABEPairing pairing;
+    for (int terms : {1, 2, 5, 16}) {
+        vector<G1> p1;
+        vector<G2> p2;
+        vector<ZP> scalars;
+        G1 sum1;
+        G2 sum2;
+        for (int i = 0; i < terms; i++) {
+            p1.push_back(pairing.randomG1());
+            p2.push_back(pairing.randomG2());
+            scalars.push_back(pairing.randomZP());
+            sum1 += p1[i] * scalars[i];
+            sum2 += p2[i] * scalars[i];
+        }
+        ASSERT_TRUE(G1::multiExp(p1, scalars) == sum1);
+        ASSERT_TRUE(G2::multiExp(p2, scalars) == sum2);
+    }
+    // negative scalars are reduced first
+    G1 g = pairing.randomG1();
+    ZP k = pairing.randomZP();
+    ASSERT_TRUE(G1::multiExp({g}, {-k}) == g * (-k));
+}
+
+TEST(FixedBase, MatchesGenericMultiplication) {
+    TEST_DESCRIPTION("Testing fixed-base multiplication against the generic one");
+    OpenABEPairing pairing;
+    G1 g = pairing.randomG1();
+    G2 h = pairing.randomG2();
+    G1FixedBase gTable(g);
+    G2FixedBase hTable(h);
+    for (int i = 0; i < 4; i++) {
+        ZP k = pairing.randomZP();
+        ASSERT_TRUE(gTable * k == g * k);
+        ASSERT_TRUE(hTable * k == h * k);
+    }
+    // a scalar without an order is not assumed to be reduced: order + 5
+    // must give the same point as 5
+    BPGroup group;
+    ZP big, five;
+    bn_copy(big.m_ZP, group.order);
+    bn_add_dig(big.m_ZP, big.m_ZP, 5);
+    pairing.initZP(five, 5);
+    ASSERT_FALSE(big.isOrderSet);
+    ASSERT_TRUE(gTable * big == g * five);
+    ASSERT_TRUE(hTable * big == h * five);
+}
+
+TEST(MultiExp, DetectsTrivialCoefficients) {
+    TEST_DESCRIPTION("Testing detection of the 0 and +-1 coefficients");
+    OpenABEPairing pairing;
+    ZP zero, one, minusOne;
+    pairing.initZP(zero, 0);
+    pairing.initZP(one, 1);
+    minusOne = zero - one;
+    ASSERT_TRUE(zero.isZero() && !zero.isOne() && !zero.isMinusOne());
+    ASSERT_TRUE(one.isOne() && !one.isZero() && !one.isMinusOne());
+    ASSERT_TRUE(minusOne.isMinusOne() && !minusOne.isOne());
+    ASSERT_TRUE((-one).isMinusOne());
+
+    G1 g = pairing.randomG1();
+    ASSERT_TRUE(-g == g * minusOne);
+}
+
+TEST(Random, ScalarsAreBelowTheOrderAndDistinct) {
+    TEST_DESCRIPTION("Testing single and bulk sampling of random scalars");
+    OpenABEPairing pairing;
+    ZP zero = pairing.initZP();
+    ZP order(pairing.order);
+    vector<ZP> scalars = pairing.randomZPs(200);
+    ASSERT_EQ(scalars.size(), 200u);
+    scalars.push_back(pairing.randomZP());
+    for (size_t i = 0; i < scalars.size(); i++) {
+        ASSERT_TRUE(scalars[i] < order);
+        ASSERT_FALSE(scalars[i] == zero);
+        for (size_t j = 0; j < i; j++) {
+            ASSERT_FALSE(scalars[i] == scalars[j]);
+        }
+    }
+    ASSERT_TRUE(pairing.randomZPs(0).empty());
+
+    // byte output spans refills of the per-thread buffer
+    OpenABEByteString a, b;
+    getRandomBytes(a, 3 * OpenABE_RNG_BUFFER_SIZE + 5);
+    getRandomBytes(b, 3 * OpenABE_RNG_BUFFER_SIZE + 5);
+    ASSERT_EQ(a.size(), 3u * OpenABE_RNG_BUFFER_SIZE + 5);
+    ASSERT_FALSE(a == b);
+}
+
+TEST(Random, ForkedChildDoesNotRepeatParentOutput) {
+    TEST_DESCRIPTION("Testing that a forked child reseeds its generator");
+    uint8_t parentBytes[32], childBytes[32];
+    OpenABERandom& rng = OpenABERandom::getInstance();
+    // start from a partly used buffer, as the child would inherit it
+    rng.getBytes(parentBytes, sizeof(parentBytes));
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        OpenABERandom::getInstance().getBytes(childBytes, sizeof(childBytes));
+        ssize_t written = write(fds[1], childBytes, sizeof(childBytes));
+        _exit(written == (ssize_t)sizeof(childBytes) ? 0 : 1);
+    }
+    close(fds[1]);
+    rng.getBytes(parentBytes, sizeof(parentBytes));
+    ASSERT_EQ(read(fds[0], childBytes, sizeof(childBytes)), (ssize_t)sizeof(childBytes));
+    close(fds[0]);
+    int status = 0;
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+    ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    ASSERT_NE(memcmp(parentBytes, childBytes, sizeof(childBytes)), 0);
+}
+
+TEST(HashToG1Cache, CountsHitsAndRespectsBudget) {
+    TEST_DESCRIPTION("Testing the hash_to_G1 cache counters and byte budget");
+    OpenABEPairing pairing;
+    OpenABEHashToG1Cache& cache = OpenABEHashToG1Cache::getInstance();
+    cache.clear();
+    cache.resetStats();
+
+    OpenABEByteString k;
+    getRandomBytes(k, 32);
+    G1 first = pairing.hashToG1(k, "Alice");
+    G1 second = pairing.hashToG1(k, "Alice");
+    ASSERT_TRUE(first == second);
+    OpenABECacheStats stats = cache.getStats();
+    ASSERT_EQ(stats.misses, 1u);
+    ASSERT_EQ(stats.hits, 1u);
+    ASSERT_EQ(stats.entries, 1u);
+
+    // a different key prefix must not hit the cached point
+    OpenABEByteString k2;
+    getRandomBytes(k2, 32);
+    ASSERT_FALSE(pairing.hashToG1(k2, "Alice") == first);
+
+    // shrink the budget to a single entry: older entries are evicted
+    cache.setMaxBytes(cache.getStats().bytes / 2);
+    stats = cache.getStats();
+    ASSERT_LE(stats.bytes, stats.maxBytes);
+    ASSERT_EQ(stats.entries, 1u);
+    ASSERT_GE(stats.evictions, 1u);
+
+    cache.setMaxBytes(DEFAULT_HASH_TO_G1_CACHE_BYTES);
+    cache.clear();
+}
+
+TEST(ReconstructionCache, CountsHitsAndRespectsBudget) {
+    TEST_DESCRIPTION("Testing the reconstruction coefficient cache counters and byte budget");
+    OpenABEPairing pairing;
+    OpenABEReconstructionCache& cache = OpenABEReconstructionCache::getInstance();
+    cache.clear();
+    cache.resetStats();
+
+    const string policyStr = "((Alice and Bob) or Charlie)";
+    unique_ptr<OpenABEAttributeList> attrs = createAttributeList("|Alice|Bob");
+    unique_ptr<OpenABEAttributeList> reordered = createAttributeList("|Bob|Alice");
+    shared_ptr<const OpenABELSSSRowMap> first = OpenABE_recoverCoefficients(policyStr, attrs.get());
+    ASSERT_TRUE(first != nullptr);
+    ASSERT_EQ(first->size(), 2u);
+    // the same attribute set in another order hits the cached coefficients
+    ASSERT_TRUE(OpenABE_recoverCoefficients(policyStr, reordered.get()) == first);
+    OpenABECacheStats stats = cache.getStats();
+    ASSERT_EQ(stats.misses, 1u);
+    ASSERT_EQ(stats.hits, 1u);
+    ASSERT_EQ(stats.entries, 1u);
+
+    // the cached coefficients recover a secret shared over the policy
+    unique_ptr<OpenABEPolicy> policy = createPolicyTree(policyStr);
+    ZP secret = pairing.randomZP();
+    OpenABELSSS lsss;
+    lsss.shareSecret(policy.get(), secret);
+    ASSERT_TRUE(lsss.LSSStestSecretRecovery(*first, lsss.getRows()) == secret);
+
+    // unsatisfied pairs are not cached
+    unique_ptr<OpenABEAttributeList> partial = createAttributeList("|Alice");
+    ASSERT_TRUE(OpenABE_recoverCoefficients(policyStr, partial.get()) == nullptr);
+    ASSERT_EQ(cache.getStats().entries, 1u);
+
+    // a budget of zero empties and disables the cache
+    cache.setMaxBytes(0);
+    ASSERT_TRUE(OpenABE_recoverCoefficients(policyStr, attrs.get()) != nullptr);
+    stats = cache.getStats();
+    ASSERT_EQ(stats.entries, 0u);
+    ASSERT_EQ(stats.bytes, 0u);
+    ASSERT_GE(stats.evictions, 1u);
+
+    cache.setMaxBytes(DEFAULT_RECONSTRUCTION_CACHE_BYTES);
+    cache.clear();
+}
+
+TEST(ReconstructionCache, KPDuplicateAttributeDecryptsFromCache) {
+    TEST_DESCRIPTION("Testing KP decryption with a duplicate-attribute key policy on a cache miss and hit");
+    OpenABEReconstructionCache& cache = OpenABEReconstructionCache::getInstance();
+    cache.clear();
+    cache.resetStats();
+
+    unique_ptr<OpenABEContextSchemeCPA> context = createContextABESchemeCPA(OpenABE_SCHEME_KP_GPSW);
+    ASSERT_TRUE(context != nullptr);
+    ASSERT_TRUE(context->generateParams("kpMPK", "kpMSK") == OpenABE_NOERROR);
+    unique_ptr<OpenABEFunctionInput> keyPolicy = createPolicyTree("((Alice and Alice) or (Bob and Alice))");
+    unique_ptr<OpenABEFunctionInput> attributes = createAttributeList("Alice|Bob");
+    ASSERT_TRUE(context->keygen(keyPolicy.get(), "kpKey", "kpMPK", "kpMSK") == OpenABE_NOERROR);
+
+    OpenABEByteString plaintext;
+    getRandomBytes(plaintext, TEST_MSG_LEN);
+    OpenABECiphertext ciphertext;
+    ASSERT_TRUE(context->encrypt("kpMPK", attributes.get(), plaintext, ciphertext) == OpenABE_NOERROR);
+    for (int i = 0; i < 2; i++) {
+        OpenABEByteString recovered;
+        ASSERT_TRUE(context->decrypt("kpMPK", "kpKey", recovered, ciphertext) == OpenABE_NOERROR);
+        ASSERT_TRUE(plaintext == recovered);
+    }
+    OpenABECacheStats stats = cache.getStats();
+    ASSERT_EQ(stats.misses, 1u);
+    ASSERT_EQ(stats.hits, 1u);
+    cache.clear();
+}
+
+TEST(Threads, SeparateContextsEncryptDecryptConcurrently) {
+    TEST_DESCRIPTION("Testing encrypt/decrypt with one context per thread");
+    if (!OpenABE_isThreadSafe()) {
+        GTEST_SKIP() << "RELIC was not built with MULTI=PTHREAD";
+    }
+    const int numThreads = 4, rounds = 3;
+    atomic<int> failures(0);
+    vector<thread> workers;
+    for (int t = 0; t < numThreads; t++) {
+        workers.emplace_back([&]() {
+            // no explicit setup: the RELIC context is created on first use
+            unique_ptr<OpenABEContextSchemeCPA> context =
+                createContextABESchemeCPA(OpenABE_SCHEME_CP_WATERS);
+            unique_ptr<OpenABEFunctionInput> policy = createPolicyTree("(Alice and (Bob or Charlie))");
+            unique_ptr<OpenABEFunctionInput> attrs = createAttributeList("|Alice|Charlie|");
+            if (context->generateParams("MPK", "MSK") != OpenABE_NOERROR ||
+                context->keygen(attrs.get(), "key", "MPK", "MSK") != OpenABE_NOERROR) {
+                failures++;
+                return;
+            }
+            for (int r = 0; r < rounds; r++) {
+                OpenABEByteString plaintext, recovered;
+                getRandomBytes(plaintext, 64);
+                OpenABECiphertext ciphertext;
+                if (context->encrypt("MPK", policy.get(), plaintext, ciphertext) != OpenABE_NOERROR ||
+                    context->decrypt("MPK", "key", recovered, ciphertext) != OpenABE_NOERROR ||
+                    recovered != plaintext) {
+                    failures++;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    ASSERT_EQ(failures.load(), 0);
+}
+
+TEST(Threads, SharedContextEncryptDecryptAcrossThreads) {
+    TEST_DESCRIPTION("Testing encrypt/decrypt from other threads with one shared context");
+    if (!OpenABE_isThreadSafe()) {
+        GTEST_SKIP() << "RELIC was not built with MULTI=PTHREAD";
+    }
+    unique_ptr<OpenABEContextSchemeCPA> context = createContextABESchemeCPA(OpenABE_SCHEME_CP_WATERS);
+    unique_ptr<OpenABEFunctionInput> keyAttrs = createAttributeList("|Alice|Charlie|");
+    ASSERT_TRUE(context->generateParams("MPK", "MSK") == OpenABE_NOERROR);
+    ASSERT_TRUE(context->keygen(keyAttrs.get(), "key", "MPK", "MSK") == OpenABE_NOERROR);
+
+    const int numThreads = 4, rounds = 3;
+    atomic<int> failures(0);
+    vector<thread> workers;
+    for (int t = 0; t < numThreads; t++) {
+        workers.emplace_back([&]() {
+            // the entry points set up the RELIC context of this thread
+            unique_ptr<OpenABEFunctionInput> policy = createPolicyTree("(Alice and (Bob or Charlie))");
+            for (int r = 0; r < rounds; r++) {
+                OpenABEByteString plaintext, recovered;
+                getRandomBytes(plaintext, 64);
+                OpenABECiphertext ciphertext;
+                if (context->encrypt("MPK", policy.get(), plaintext, ciphertext) != OpenABE_NOERROR ||
+                    context->decrypt("MPK", "key", recovered, ciphertext) != OpenABE_NOERROR ||
+                    recovered != plaintext) {
+                    failures++;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    ASSERT_EQ(failures.load(), 0);
+}
+
+TEST(OnlineOffline, PrecomputedEncryptionDecrypts) {
+    TEST_DESCRIPTION("Testing CP-Waters encryption with a pool of precomputed randomness");
+    unique_ptr<OpenABEContextSchemeCPA> context = createContextABESchemeCPA(OpenABE_SCHEME_CP_WATERS);
+    unique_ptr<OpenABEFunctionInput> policy = createPolicyTree("((Alice or Bob) and (2 of (Charlie, Dave, Eve)))");
+    unique_ptr<OpenABEFunctionInput> attrs = createAttributeList("|Bob|Dave|Eve|");
+    ASSERT_TRUE(context->generateParams("MPK", "MSK") == OpenABE_NOERROR);
+    ASSERT_TRUE(context->keygen(attrs.get(), "key", "MPK", "MSK") == OpenABE_NOERROR);
+
+    OpenABEPrecomputeSettings settings;
+    settings.sessionDepth = 4;
+    settings.shareDepth = 16;
+    settings.attributeDepth = 4;
+    ASSERT_TRUE(context->enablePrecomputation("MPK", settings) == OpenABE_NOERROR);
+    shared_ptr<OpenABEPrecomputePool> pool = context->getPrecomputePool("MPK");
+    ASSERT_TRUE(pool != nullptr);
+
+    // the first encryption teaches the pool the attributes of the policy
+    for (int round = 0; round < 3; round++) {
+        pool->refill(64);
+        OpenABEByteString plaintext, recovered, blob;
+        getRandomBytes(plaintext, 64);
+        OpenABECiphertext ciphertext, loaded;
+        ASSERT_TRUE(context->encrypt("MPK", policy.get(), plaintext, ciphertext) == OpenABE_NOERROR);
+        ciphertext.exportToBytes(blob);
+        loaded.loadFromBytes(blob);
+        ASSERT_TRUE(context->decrypt("MPK", "key", recovered, loaded) == OpenABE_NOERROR);
+        ASSERT_TRUE(recovered == plaintext);
+    }
+    OpenABEPrecomputeStats stats = pool->getStats();
+    ASSERT_GT(stats.sessionHits, 0u);
+    ASSERT_GT(stats.shareHits, 0u);
+    ASSERT_GT(stats.attributeHits, 0u);
+    ASSERT_EQ(stats.attributes, 5u);
+    ASSERT_LE(stats.sessions, settings.sessionDepth);
+
+    // without the pool the ciphertexts are unchanged and still decrypt
+    ASSERT_TRUE(context->disablePrecomputation("MPK") == OpenABE_NOERROR);
+    ASSERT_TRUE(context->getPrecomputePool("MPK") == nullptr);
+    OpenABEByteString plaintext, recovered;
+    getRandomBytes(plaintext, 64);
+    OpenABECiphertext ciphertext;
+    ASSERT_TRUE(context->encrypt("MPK", policy.get(), plaintext, ciphertext) == OpenABE_NOERROR);
+    ASSERT_TRUE(context->decrypt("MPK", "key", recovered, ciphertext) == OpenABE_NOERROR);
+    ASSERT_TRUE(recovered == plaintext);
+}
+
+TEST(OnlineOffline, PoolFollowsReplacedMPK) {
+    TEST_DESCRIPTION("Testing that the precompute pool is rebuilt when the MPK is replaced");
+    unique_ptr<OpenABEContextSchemeCPA> context = createContextABESchemeCPA(OpenABE_SCHEME_CP_WATERS);
+    unique_ptr<OpenABEFunctionInput> policy = createPolicyTree("(Alice or Bob)");
+    unique_ptr<OpenABEFunctionInput> attrs = createAttributeList("|Alice|");
+    ASSERT_TRUE(context->generateParams("MPK", "MSK") == OpenABE_NOERROR);
+
+    OpenABEPrecomputeSettings settings;
+    settings.sessionDepth = 4;
+    settings.shareDepth = 8;
+    settings.attributeDepth = 2;
+    ASSERT_TRUE(context->enablePrecomputation("MPK", settings) == OpenABE_NOERROR);
+    shared_ptr<OpenABEPrecomputePool> oldPool = context->getPrecomputePool("MPK");
+    ASSERT_TRUE(oldPool != nullptr);
+    oldPool->refill(64);
+
+    // new parameters under the same identifier: the filled pool of the old
+    // MPK must not be used for them
+    ASSERT_TRUE(context->generateParams("MPK", "MSK") == OpenABE_NOERROR);
+    ASSERT_TRUE(context->keygen(attrs.get(), "key", "MPK", "MSK") == OpenABE_NOERROR);
+    shared_ptr<OpenABEPrecomputePool> newPool = context->getPrecomputePool("MPK");
+    ASSERT_TRUE(newPool != nullptr);
+    ASSERT_TRUE(newPool != oldPool);
+    ASSERT_TRUE(context->getPrecomputePool("MPK") == newPool);
+
+    newPool->refill(64);
+    OpenABEByteString plaintext, recovered;
+    getRandomBytes(plaintext, 64);
+    OpenABECiphertext ciphertext;
+    ASSERT_TRUE(context->encrypt("MPK", policy.get(), plaintext, ciphertext) == OpenABE_NOERROR);
+    ASSERT_TRUE(context->decrypt("MPK", "key", recovered, ciphertext) == OpenABE_NOERROR);
+    ASSERT_TRUE(recovered == plaintext);
+    ASSERT_GT(newPool->getStats().sessionHits, 0u);
+    ASSERT_EQ(oldPool->getStats().sessionHits, 0u);
+
+    // deleting the MPK drops the pool
+    ASSERT_TRUE(context->deleteKey("MPK") == OpenABE_NOERROR);
+    ASSERT_TRUE(context->getPrecomputePool("MPK") == nullptr);
+}
+
 string convertToAttributeListString(vector<string>& attr_list) {
     string a_str = "|";
     for (auto a : attr_list) {
@@ -602,6 +1147,331 @@ TEST_P(CPASecurityForSchemeTest, testWorkingExamples) {
     }
 }
 
+TEST_P(CPASecurityForSchemeTest, testBatchEncryption) {
+    Input input = GetParam();
+    TEST_DESCRIPTION("Testing batch encryption for " + printScheme(input.scheme_type) + " scheme with Key: '" + \
+    		input.key_input + "' and Enc: '" + input.func_input + "'");
+    unique_ptr<OpenABEContextSchemeCPA> schemeContext = createContextABESchemeCPA(input.scheme_type);
+    ASSERT_TRUE(schemeContext != nullptr);
+    ASSERT_TRUE(schemeContext->generateParams(MPK, MSK) == OpenABE_NOERROR);
+
+    vector<OpenABEByteString> plaintexts(5);
+    for (auto& pt : plaintexts) {
+        getRandomBytes(pt, TEST_MSG_LEN);
+    }
+    vector<unique_ptr<OpenABECiphertext>> ciphertexts;
+    unique_ptr<OpenABEFunctionInput> encInput = getEncInput(input.scheme_type, input.func_input);
+    ASSERT_TRUE(schemeContext->encryptBatch(MPK, encInput.get(), plaintexts, ciphertexts, 2) == OpenABE_NOERROR);
+    ASSERT_EQ(ciphertexts.size(), plaintexts.size());
+
+    unique_ptr<OpenABEFunctionInput> keyInput = getKeyInput(input.scheme_type, input.key_input);
+    ASSERT_TRUE(schemeContext->keygen(keyInput.get(), "DecKey", MPK, MSK) == OpenABE_NOERROR);
+
+    for (size_t i = 0; i < plaintexts.size(); i++) {
+        OpenABEByteString recovered;
+        OpenABE_ERROR result = schemeContext->decrypt(MPK, "DecKey", recovered, *ciphertexts[i]);
+        if(input.expect_pass_) {
+            ASSERT_TRUE(result == OpenABE_NOERROR);
+            ASSERT_TRUE(plaintexts[i] == recovered);
+        } else {
+            ASSERT_FALSE(result == OpenABE_NOERROR);
+        }
+    }
+}
+
+TEST_P(CPASecurityForSchemeTest, testBatchKeygen) {
+    Input input = GetParam();
+    TEST_DESCRIPTION("Testing batch key generation for " + printScheme(input.scheme_type) + " scheme with Key: '" + \
+    		input.key_input + "' and Enc: '" + input.func_input + "'");
+    unique_ptr<OpenABEContextSchemeCPA> schemeContext = createContextABESchemeCPA(input.scheme_type);
+    ASSERT_TRUE(schemeContext != nullptr);
+    ASSERT_TRUE(schemeContext->generateParams(MPK, MSK) == OpenABE_NOERROR);
+
+    OpenABEByteString plaintext, recovered;
+    getRandomBytes(plaintext, TEST_MSG_LEN);
+    OpenABECiphertext ciphertext;
+    unique_ptr<OpenABEFunctionInput> encInput = getEncInput(input.scheme_type, input.func_input);
+    ASSERT_TRUE(schemeContext->encrypt(MPK, encInput.get(), plaintext, ciphertext) == OpenABE_NOERROR);
+
+    // several users share the threads; a single key uses them for its rows
+    unique_ptr<OpenABEFunctionInput> keyInput = getKeyInput(input.scheme_type, input.key_input);
+    for (size_t users : {1, 4}) {
+        vector<OpenABEFunctionInput*> keyInputs(users, keyInput.get());
+        vector<string> keyIDs;
+        for (size_t i = 0; i < users; i++) {
+            keyIDs.push_back("BatchKey" + to_string(i));
+        }
+        vector<OpenABEByteString> keyBlobs;
+        ASSERT_TRUE(schemeContext->keygenBatch(keyInputs, keyIDs, MPK, MSK, keyBlobs, 2) == OpenABE_NOERROR);
+        ASSERT_EQ(keyBlobs.size(), users);
+
+        for (size_t i = 0; i < users; i++) {
+            ASSERT_FALSE(schemeContext->checkSecretKey(keyIDs[i]));
+            ASSERT_TRUE(schemeContext->loadUserSecretParams(keyIDs[i], keyBlobs[i]) == OpenABE_NOERROR);
+            OpenABE_ERROR result = schemeContext->decrypt(MPK, keyIDs[i], recovered, ciphertext);
+            if(input.expect_pass_) {
+                ASSERT_TRUE(result == OpenABE_NOERROR);
+                ASSERT_TRUE(plaintext == recovered);
+            } else {
+                ASSERT_FALSE(result == OpenABE_NOERROR);
+            }
+            ASSERT_TRUE(schemeContext->deleteKey(keyIDs[i]) == OpenABE_NOERROR);
+        }
+    }
+
+    // mismatched identifiers are rejected
+    vector<OpenABEByteString> keyBlobs;
+    ASSERT_TRUE(schemeContext->keygenBatch({keyInput.get()}, {}, MPK, MSK, keyBlobs) == OpenABE_ERROR_INVALID_LENGTH);
+    ASSERT_TRUE(keyBlobs.empty());
+}
+
+TEST_P(CPASecurityForSchemeTest, testStreamingEncryption) {
+    Input input = GetParam();
+    TEST_DESCRIPTION("Testing streaming encryption for " + printScheme(input.scheme_type) + " scheme with Key: '" + \
+    		input.key_input + "' and Enc: '" + input.func_input + "'");
+    unique_ptr<OpenABEContextSchemeCPA> schemeContext = createContextABESchemeCPA(input.scheme_type);
+    ASSERT_TRUE(schemeContext != nullptr);
+    ASSERT_TRUE(schemeContext->generateParams(MPK, MSK) == OpenABE_NOERROR);
+
+    // header first, then the payload in blocks of uneven size
+    OpenABECiphertext header, header2;
+    vector<OpenABEByteString> ptBlocks(3), ctBlocks(3);
+    getRandomBytes(ptBlocks[0], 1000);
+    getRandomBytes(ptBlocks[1], 1);
+    getRandomBytes(ptBlocks[2], 4096);
+    OpenABEByteString tag;
+    unique_ptr<OpenABEFunctionInput> encInput = getEncInput(input.scheme_type, input.func_input);
+    unique_ptr<OpenABEStreamEncryptor> encryptor;
+    ASSERT_TRUE(schemeContext->encryptInit(MPK, encInput.get(), header, encryptor) == OpenABE_NOERROR);
+    ASSERT_TRUE(encryptor != nullptr);
+    for (size_t i = 0; i < ptBlocks.size(); i++) {
+        ASSERT_TRUE(encryptor->update(ptBlocks[i], ctBlocks[i]) == OpenABE_NOERROR);
+        ASSERT_EQ(ctBlocks[i].size(), ptBlocks[i].size());
+    }
+    ASSERT_TRUE(encryptor->finalize(tag) == OpenABE_NOERROR);
+    ASSERT_EQ(tag.size(), (size_t)AES_BLOCK_SIZE);
+    // a finalized stream cannot be reused
+    ASSERT_FALSE(encryptor->update(ptBlocks[0], ctBlocks[0]) == OpenABE_NOERROR);
+
+    header.exportToBytes(ctBlob);
+    header2.loadFromBytes(ctBlob);
+    unique_ptr<OpenABEFunctionInput> keyInput = getKeyInput(input.scheme_type, input.key_input);
+    ASSERT_TRUE(schemeContext->keygen(keyInput.get(), "DecKey", MPK, MSK) == OpenABE_NOERROR);
+    unique_ptr<OpenABEStreamDecryptor> decryptor;
+    OpenABE_ERROR result = schemeContext->decryptInit(MPK, "DecKey", header2, decryptor);
+    if (!input.expect_pass_) {
+        ASSERT_FALSE(result == OpenABE_NOERROR);
+        return;
+    }
+    ASSERT_TRUE(result == OpenABE_NOERROR);
+    OpenABEByteString recovered, expected;
+    for (size_t i = 0; i < ctBlocks.size(); i++) {
+        ASSERT_TRUE(decryptor->update(ctBlocks[i], recovered) == OpenABE_NOERROR);
+        expected += ptBlocks[i];
+    }
+    ASSERT_TRUE(decryptor->finalize(tag) == OpenABE_NOERROR);
+    ASSERT_TRUE(recovered == expected);
+
+    // a modified block is caught by the tag
+    ctBlocks[1][0] ^= 0x01;
+    recovered.clear();
+    OpenABECiphertext header3;
+    header3.loadFromBytes(ctBlob);
+    ASSERT_TRUE(schemeContext->decryptInit(MPK, "DecKey", header3, decryptor) == OpenABE_NOERROR);
+    for (size_t i = 0; i < ctBlocks.size(); i++) {
+        ASSERT_TRUE(decryptor->update(ctBlocks[i], recovered) == OpenABE_NOERROR);
+    }
+    ASSERT_TRUE(decryptor->finalize(tag) == OpenABE_ERROR_DECRYPTION_FAILED);
+    ctBlocks[1][0] ^= 0x01;
+
+    // so is a modified header: it is the AAD of the stream
+    OpenABECiphertext header4;
+    OpenABEByteString extra;
+    extra.appendArray((uint8_t *)"extra", 5);
+    header4.loadFromBytes(ctBlob);
+    header4.setComponent("extra", &extra);
+    ASSERT_TRUE(schemeContext->decryptInit(MPK, "DecKey", header4, decryptor) == OpenABE_NOERROR);
+    recovered.clear();
+    for (size_t i = 0; i < ctBlocks.size(); i++) {
+        ASSERT_TRUE(decryptor->update(ctBlocks[i], recovered) == OpenABE_NOERROR);
+    }
+    ASSERT_TRUE(decryptor->finalize(tag) == OpenABE_ERROR_DECRYPTION_FAILED);
+
+    // streams on one context are independent: interleave two of them
+    OpenABECiphertext headerA, headerB;
+    OpenABEByteString ctA, ctB, tagA, tagB, ptA, ptB;
+    unique_ptr<OpenABEStreamEncryptor> encA, encB;
+    ASSERT_TRUE(schemeContext->encryptInit(MPK, encInput.get(), headerA, encA) == OpenABE_NOERROR);
+    ASSERT_TRUE(schemeContext->encryptInit(MPK, encInput.get(), headerB, encB) == OpenABE_NOERROR);
+    for (size_t i = 0; i < ptBlocks.size(); i++) {
+        ASSERT_TRUE(encA->update(ptBlocks[i], ctA) == OpenABE_NOERROR);
+        ASSERT_TRUE(encB->update(ptBlocks[ptBlocks.size() - 1 - i], ctB) == OpenABE_NOERROR);
+    }
+    ASSERT_TRUE(encA->finalize(tagA) == OpenABE_NOERROR);
+    ASSERT_TRUE(encB->finalize(tagB) == OpenABE_NOERROR);
+    unique_ptr<OpenABEStreamDecryptor> decA, decB;
+    ASSERT_TRUE(schemeContext->decryptInit(MPK, "DecKey", headerA, decA) == OpenABE_NOERROR);
+    ASSERT_TRUE(schemeContext->decryptInit(MPK, "DecKey", headerB, decB) == OpenABE_NOERROR);
+    ASSERT_TRUE(decB->update(ctB, ptB) == OpenABE_NOERROR);
+    ASSERT_TRUE(decA->update(ctA, ptA) == OpenABE_NOERROR);
+    ASSERT_TRUE(decA->finalize(tagA) == OpenABE_NOERROR);
+    ASSERT_TRUE(decB->finalize(tagB) == OpenABE_NOERROR);
+    ASSERT_TRUE(ptA == expected);
+    ASSERT_EQ(ptB.size(), expected.size());
+
+    // an empty payload still gets a tag
+    OpenABECiphertext emptyHeader;
+    OpenABEByteString emptyTag;
+    ASSERT_TRUE(schemeContext->encryptInit(MPK, encInput.get(), emptyHeader, encryptor) == OpenABE_NOERROR);
+    ASSERT_TRUE(encryptor->finalize(emptyTag) == OpenABE_NOERROR);
+    ASSERT_TRUE(schemeContext->decryptInit(MPK, "DecKey", emptyHeader, decryptor) == OpenABE_NOERROR);
+    ASSERT_TRUE(decryptor->finalize(emptyTag) == OpenABE_NOERROR);
+}
+
+TEST_P(CPASecurityForSchemeTest, testPayloadModes) {
+    Input input = GetParam();
+    TEST_DESCRIPTION("Testing payload modes for " + printScheme(input.scheme_type) + " scheme with Key: '" + \
+    		input.key_input + "' and Enc: '" + input.func_input + "'");
+    if (!input.expect_pass_) {
+        return;
+    }
+    unique_ptr<OpenABEContextSchemeCPA> schemeContext = createContextABESchemeCPA(input.scheme_type);
+    ASSERT_TRUE(schemeContext != nullptr);
+    ASSERT_TRUE(schemeContext->generateParams(MPK, MSK) == OpenABE_NOERROR);
+    unique_ptr<OpenABEFunctionInput> keyInput = getKeyInput(input.scheme_type, input.key_input);
+    unique_ptr<OpenABEFunctionInput> encInput = getEncInput(input.scheme_type, input.func_input);
+    ASSERT_TRUE(schemeContext->keygen(keyInput.get(), "DecKey", MPK, MSK) == OpenABE_NOERROR);
+    ASSERT_EQ(schemeContext->getPayloadMode(), OpenABE_PAYLOAD_AES_CTR);
+
+    // larger than one keystream chunk, not a multiple of the block size
+    OpenABEByteString plaintext, recovered;
+    getRandomBytes(plaintext, OpenABE_PAYLOAD_CHUNK_SIZE + 77);
+    for (auto mode : {OpenABE_PAYLOAD_HASH, OpenABE_PAYLOAD_AES_CTR}) {
+        OpenABECiphertext ciphertext, ciphertext2;
+        schemeContext->setPayloadMode(mode);
+        ASSERT_TRUE(schemeContext->encrypt(MPK, encInput.get(), plaintext, ciphertext) == OpenABE_NOERROR);
+        // the hash mode writes the original layout without a mode component
+        ASSERT_EQ(ciphertext.hasComponent("_PM"), mode != OpenABE_PAYLOAD_HASH);
+        ciphertext.exportToBytes(ctBlob);
+        ciphertext2.loadFromBytes(ctBlob);
+
+        // decryption follows the ciphertext, not the context setting
+        schemeContext->setPayloadMode(OpenABE_PAYLOAD_AES_CTR);
+        recovered.clear();
+        ASSERT_TRUE(schemeContext->decrypt(MPK, "DecKey", recovered, ciphertext2) == OpenABE_NOERROR);
+        ASSERT_TRUE(recovered == plaintext);
+    }
+}
+
+TEST_P(CPASecurityForSchemeTest, testParallelDecryption) {
+    Input input = GetParam();
+    TEST_DESCRIPTION("Testing multi-threaded decryption for " + printScheme(input.scheme_type) + " scheme with Key: '" + \
+    		input.key_input + "' and Enc: '" + input.func_input + "'");
+    unique_ptr<OpenABEContextSchemeCPA> schemeContext = createContextABESchemeCPA(input.scheme_type);
+    ASSERT_TRUE(schemeContext != nullptr);
+    ASSERT_TRUE(schemeContext->generateParams(MPK, MSK) == OpenABE_NOERROR);
+
+    OpenABECiphertext ciphertext;
+    unique_ptr<OpenABEFunctionInput> encInput = getEncInput(input.scheme_type, input.func_input);
+    ASSERT_TRUE(schemeContext->encrypt(MPK, encInput.get(), plaintext, ciphertext) == OpenABE_NOERROR);
+    unique_ptr<OpenABEFunctionInput> keyInput = getKeyInput(input.scheme_type, input.key_input);
+    ASSERT_TRUE(schemeContext->keygen(keyInput.get(), "DecKey", MPK, MSK) == OpenABE_NOERROR);
+
+    for (unsigned int threads : {2, 4}) {
+        schemeContext->setDecryptionThreads(threads);
+        OpenABEByteString recovered;
+        OpenABE_ERROR result = schemeContext->decrypt(MPK, "DecKey", recovered, ciphertext);
+        if(input.expect_pass_) {
+            ASSERT_TRUE(result == OpenABE_NOERROR);
+            ASSERT_TRUE(plaintext == recovered);
+        } else {
+            ASSERT_FALSE(result == OpenABE_NOERROR);
+        }
+    }
+}
+
+TEST_P(CPASecurityForSchemeTest, testFlatCiphertextFormat) {
+    Input input = GetParam();
+    TEST_DESCRIPTION("Testing the flat ciphertext format for " + printScheme(input.scheme_type) + " scheme with Key: '" + \
+    		input.key_input + "' and Enc: '" + input.func_input + "'");
+    unique_ptr<OpenABEContextSchemeCPA> schemeContext = createContextABESchemeCPA(input.scheme_type);
+    ASSERT_TRUE(schemeContext != nullptr);
+    ASSERT_TRUE(schemeContext->generateParams(MPK, MSK) == OpenABE_NOERROR);
+
+    OpenABECiphertext ciphertext, ciphertext2;
+    unique_ptr<OpenABEFunctionInput> encInput = getEncInput(input.scheme_type, input.func_input);
+    ASSERT_TRUE(schemeContext->encrypt(MPK, encInput.get(), plaintext, ciphertext) == OpenABE_NOERROR);
+
+    OpenABEByteString flatBlob;
+    ciphertext.exportToFlatBytes(flatBlob);
+    OpenABEFlatCiphertextReader reader(flatBlob);
+    ASSERT_EQ(reader.numComponents(), ciphertext.numComponents());
+    for (const string& name : ciphertext.getKeys()) {
+        ASSERT_TRUE(reader.hasComponent(name));
+    }
+    ASSERT_FALSE(reader.hasComponent("missing"));
+    ASSERT_THROW(reader.getRawComponent("missing"), OpenABE_ERROR);
+
+    // a truncated table is rejected up front
+    span<const uint8_t> truncated(flatBlob.data(), OpenABE_FLAT_CT_HEADER_LEN + OpenABE_FLAT_CT_ENTRY_LEN);
+    ASSERT_THROW(OpenABEFlatCiphertextReader bad(truncated), OpenABE_ERROR);
+
+    // loadFromBytes recognizes the flat layout
+    ciphertext2.loadFromBytes(flatBlob);
+    OpenABEByteString hdr1, hdr2;
+    ciphertext.getHeader(hdr1);
+    ciphertext2.getHeader(hdr2);
+    ASSERT_TRUE(hdr1 == hdr2);
+    // the loaded ciphertext keeps its own copy of the blob to decode from
+    flatBlob.fillBuffer(0, flatBlob.size());
+    ASSERT_TRUE(ciphertext == ciphertext2);
+
+    unique_ptr<OpenABEFunctionInput> keyInput = getKeyInput(input.scheme_type, input.key_input);
+    ASSERT_TRUE(schemeContext->keygen(keyInput.get(), "DecKey", MPK, MSK) == OpenABE_NOERROR);
+    OpenABEByteString recovered;
+    OpenABE_ERROR result = schemeContext->decrypt(MPK, "DecKey", recovered, ciphertext2);
+    if(input.expect_pass_) {
+        ASSERT_TRUE(result == OpenABE_NOERROR);
+        ASSERT_TRUE(plaintext == recovered);
+    } else {
+        ASSERT_FALSE(result == OpenABE_NOERROR);
+    }
+}
+
+TEST_P(CPASecurityForSchemeTest, testLazyCiphertextLoading) {
+    Input input = GetParam();
+    TEST_DESCRIPTION("Testing lazy ciphertext loading for " + printScheme(input.scheme_type) + " scheme with Key: '" + \
+    		input.key_input + "' and Enc: '" + input.func_input + "'");
+    unique_ptr<OpenABEContextSchemeCPA> schemeContext = createContextABESchemeCPA(input.scheme_type);
+    ASSERT_TRUE(schemeContext != nullptr);
+    ASSERT_TRUE(schemeContext->generateParams(MPK, MSK) == OpenABE_NOERROR);
+
+    OpenABECiphertext ciphertext, ciphertext2;
+    unique_ptr<OpenABEFunctionInput> encInput = getEncInput(input.scheme_type, input.func_input);
+    ASSERT_TRUE(schemeContext->encrypt(MPK, encInput.get(), plaintext, ciphertext) == OpenABE_NOERROR);
+
+    // re-exporting an undecoded ciphertext reproduces the same bytes
+    OpenABEByteString ctBlob1, ctBlob2;
+    ciphertext.exportToBytes(ctBlob1);
+    ciphertext2.loadFromBytes(ctBlob1);
+    ciphertext2.exportToBytes(ctBlob2);
+    ASSERT_TRUE(ctBlob1 == ctBlob2);
+    ASSERT_TRUE(ciphertext == ciphertext2);
+
+    unique_ptr<OpenABEFunctionInput> keyInput = getKeyInput(input.scheme_type, input.key_input);
+    ASSERT_TRUE(schemeContext->keygen(keyInput.get(), "DecKey", MPK, MSK) == OpenABE_NOERROR);
+    OpenABECiphertext ciphertext3;
+    ciphertext3.loadFromBytes(ctBlob1);
+    OpenABEByteString recovered;
+    OpenABE_ERROR result = schemeContext->decrypt(MPK, "DecKey", recovered, ciphertext3);
+    if(input.expect_pass_) {
+        ASSERT_TRUE(result == OpenABE_NOERROR);
+        ASSERT_TRUE(plaintext == recovered);
+    } else {
+        ASSERT_FALSE(result == OpenABE_NOERROR);
+    }
+}
+
 #if 0
 /* Unit test fixture for CCA KEM contexts */
 TEST_P(CCASecurityForKEMTest, testWorkingExamples) {
@@ -752,6 +1622,15 @@ INSTANTIATE_TEST_CASE_P(ABETest2, CPASecurityForSchemeTest,
     Input(OpenABE_SCHEME_KP_GPSW, "Alice|Charlie|uid:567abcdef", "((Alice and Bob) and Charlie)", false)
 ));
 
+// wide policies, so that decryption is split across several threads
+INSTANTIATE_TEST_CASE_P(ABETestWide, CPASecurityForSchemeTest,
+    ::testing::Values(
+    Input(OpenABE_SCHEME_CP_WATERS, "(((a1 and a2) and (a3 and a4)) and ((a5 and a6) and (a7 and a8))) and (((a9 and a10) and (a11 and a12)) and ((a13 and a14) and (a15 and a16)))",
+          "a1|a2|a3|a4|a5|a6|a7|a8|a9|a10|a11|a12|a13|a14|a15|a16", true),
+    Input(OpenABE_SCHEME_KP_GPSW, "a1|a2|a3|a4|a5|a6|a7|a8|a9|a10|a11|a12|a13|a14|a15|a16",
+          "(((a1 and a2) and (a3 and a4)) and ((a5 and a6) and (a7 and a8))) and (((a9 and a10) and (a11 and a12)) and ((a13 and a14) and (a15 and a16)))", true)
+));
+
 INSTANTIATE_TEST_CASE_P(ABETest3, CPASecurityForSchemeTest,
     ::testing::Values(
     Input(OpenABE_SCHEME_CP_WATERS, "Alice and Date = May 1-10, 2016", "Alice|Date=May 5, 2016", true),
@@ -38,6 +38,8 @@
 #include <sstream>
 #include <string>
 #include <math.h>
+#include <atomic>
+#include <thread>
 #include <gtest/gtest.h>
 
 #include <abe_lsss.h>
@@ -173,6 +175,101 @@ TEST_P(KeystoreManagerTest, testBaseCases) {
 }
 #endif
 
+TEST(Keystore, ConcurrentAddLookupDelete) {
+    TEST_DESCRIPTION("Testing concurrent add/lookup/delete on the keystore (run under TSAN)");
+    const int numThreads = 8, numKeys = 256, rounds = 200;
+    OpenABEKeystore keystore;
+    // keys are created up front: the worker threads only move references
+    vector<shared_ptr<OpenABEKey>> keys;
+    for (int i = 0; i < numKeys; i++) {
+        keys.push_back(make_shared<OpenABEKey>());
+        keystore.addKey("shared" + to_string(i), keys.back(), KEY_TYPE_PUBLIC);
+    }
+
+    atomic<int> failures(0);
+    vector<thread> workers;
+    for (int t = 0; t < numThreads; t++) {
+        workers.emplace_back([&, t]() {
+            for (int r = 0; r < rounds; r++) {
+                // keys shared by every thread are always found
+                const int i = (t * 31 + r) % numKeys;
+                if (keystore.getPublicKey("shared" + to_string(i)) != keys[i]) {
+                    failures++;
+                }
+                // keys owned by this thread come and go
+                const string ownID = "own" + to_string(t) + "_" + to_string(r % 8);
+                keystore.addKey(ownID, keys[i], KEY_TYPE_SECRET);
+                if (!keystore.checkSecretKey(ownID) || keystore.getKey(ownID) != keys[i]) {
+                    failures++;
+                }
+                keystore.deleteKey(ownID);
+                if (keystore.getSecretKey(ownID) != nullptr) {
+                    failures++;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    ASSERT_EQ(failures.load(), 0);
+    for (int i = 0; i < numKeys; i++) {
+        ASSERT_TRUE(keystore.getKey("shared" + to_string(i)) == keys[i]);
+    }
+}
+
+// stores key metadata directly, so the search index can be tested without
+// generating key blobs
+class IndexedKeystoreManager : public OpenABEKeystoreManager {
+public:
+    void addInput(const string& userId, const string& keyID, unique_ptr<OpenABEFunctionInput> input) {
+        OpenABEMetadata metadata(new _OpenABEMetadata);
+        metadata->userId = userId;
+        metadata->inputType = input->getFunctionType();
+        metadata->input = move(input);
+        addKeyMetadata(keyID, metadata);
+    }
+};
+
+TEST(KeystoreManager, SearchUsesAttributeIndex) {
+    TEST_DESCRIPTION("Testing key search through the inverted attribute index");
+    unique_ptr<OpenABEPolicy> policy = createPolicyTree("((Alice or Bob) and Charlie)");
+    ASSERT_EQ(getPolicyClauses(policy->getRootNode()).size(), 2u);
+
+    IndexedKeystoreManager km;
+    km.addInput("user", "key1", createAttributeList("|Alice|Bob|"));
+    km.addInput("user", "key2", createAttributeList("|Alice|Charlie|"));
+    km.addInput("user", "key3", createAttributeList("|David|"));
+    km.addInput("other", "key4", createAttributeList("|Eve|"));
+    km.addInput("user", "key5", createPolicyTree("(Alice and Bob)"));
+    km.addInput("user", "key6", createPolicyTree("((Alice or Bob) and Charlie)"));
+
+    OpenABEKeyQuery query;
+    query.isEfficient = false;
+    query.currentTime = 0;
+    query.userId = "user";
+    auto search = [&](unique_ptr<OpenABEFunctionInput> input) {
+        return km.searchKeyCommand(&query, input.get());
+    };
+    // ciphertext policies match attribute list keys
+    ASSERT_EQ(search(createPolicyTree("(Alice and Charlie)")), "key2");
+    ASSERT_EQ(search(createPolicyTree("(Bob or David)")), "key1");
+    ASSERT_EQ(search(createPolicyTree("(Eve and Alice)")), "");
+    // ciphertext attribute lists match policy keys
+    ASSERT_EQ(search(createAttributeList("|Bob|Charlie|")), "key6");
+    ASSERT_EQ(search(createAttributeList("|Alice|Bob|")), "key5");
+    ASSERT_EQ(search(createAttributeList("|Charlie|David|")), "");
+    // keys of other users are never returned
+    ASSERT_EQ(search(createPolicyTree("Eve")), "");
+
+    // deleted keys leave the index
+    km.deleteKeyCommand(&query);
+    ASSERT_EQ(search(createPolicyTree("(Alice and Charlie)")), "");
+    ASSERT_EQ(search(createAttributeList("|Bob|Charlie|")), "");
+    query.userId = "other";
+    ASSERT_EQ(search(createPolicyTree("Eve")), "key4");
+}
+
 }
 
 INSTANTIATE_TEST_CASE_P(ABETest5, KeystoreManagerTest,
@@ -106,6 +106,93 @@ TEST(SK, TestSymKeyHandlerForGCMMode) {
 }
 
 
+TEST(SK, TestSegmentedAuthEncStream) {
+    TEST_DESCRIPTION("Testing segmented STREAM enc/dec, random access and tampering");
+    OpenABEByteString key, aad, plaintext, header, ciphertext, decrypted, segment;
+    const uint32_t segSize = 1024;
+
+    getRandomBytes(key, DEFAULT_SYM_KEY_BYTES);
+    getRandomBytes(aad, AES_BLOCK_SIZE);
+    getRandomBytes(plaintext, 5 * segSize + 100);
+
+    OpenABESymKeySegmentedAuthEnc stream(DEFAULT_AES_SEC_LEVEL, key, segSize);
+    stream.setAddAuthData(aad);
+    ASSERT_EQ(stream.encrypt(plaintext, header, ciphertext, 4), OpenABE_NOERROR);
+    size_t count = OpenABESymKeySegmentedAuthEnc::getSegmentCount(ciphertext.size(), segSize);
+    ASSERT_EQ(count, 6);
+    ASSERT_TRUE(stream.decrypt(decrypted, header, ciphertext, 4));
+    ASSERT_EQ(plaintext, decrypted);
+
+    // read a single segment out of the middle
+    size_t sealed = segSize + AES_BLOCK_SIZE;
+    segment = ciphertext.getSubset(2 * sealed, sealed);
+    ASSERT_TRUE(stream.decryptSegment(decrypted, header, segment, 2, false));
+    ASSERT_EQ(decrypted, plaintext.getSubset(2 * segSize, segSize));
+    // wrong index or a spoofed last-segment flag must fail
+    ASSERT_FALSE(stream.decryptSegment(decrypted, header, segment, 3, false));
+    ASSERT_FALSE(stream.decryptSegment(decrypted, header, segment, 2, true));
+
+    // truncating at a segment boundary is detected
+    OpenABEByteString truncated = ciphertext.getSubset(0, 3 * sealed);
+    ASSERT_FALSE(stream.decrypt(decrypted, header, truncated));
+
+    // swapping two segments is detected
+    OpenABEByteString swapped = ciphertext.getSubset(sealed, sealed);
+    swapped += ciphertext.getSubset(0, sealed);
+    swapped += ciphertext.getSubset(2 * sealed, ciphertext.size() - 2 * sealed);
+    ASSERT_FALSE(stream.decrypt(decrypted, header, swapped));
+
+    // an empty plaintext still carries a (final) tag
+    OpenABEByteString empty;
+    ASSERT_EQ(stream.encrypt(empty, header, ciphertext), OpenABE_NOERROR);
+    ASSERT_EQ(ciphertext.size(), AES_BLOCK_SIZE);
+    ASSERT_TRUE(stream.decrypt(decrypted, header, ciphertext));
+    ASSERT_EQ(decrypted.size(), 0);
+}
+
+TEST(SK, TestSymKeyHandlerForStreamMode) {
+    TEST_DESCRIPTION("Testing Symmetric Key Handler with STREAM_GCM mode");
+    OpenABEByteString key, aad, plaintext, ciphertext, decrypted, segment;
+
+    getRandomBytes(key, DEFAULT_SYM_KEY_BYTES);
+    getRandomBytes(aad, AES_BLOCK_SIZE);
+    getRandomBytes(plaintext, 3 * OpenABE_STREAM_SEGMENT_SIZE + 17);
+
+    SymKeyEncHandler handler(key.toString(), EncryptionMode::STREAM_GCM);
+    handler.setAuthData(aad);
+    ASSERT_EQ(handler.encrypt(ciphertext, plaintext), OpenABE_NOERROR);
+    ASSERT_EQ(handler.decrypt(decrypted, ciphertext), OpenABE_NOERROR);
+    ASSERT_EQ(plaintext, decrypted);
+
+    ASSERT_EQ(handler.decryptSegment(segment, ciphertext, 3), OpenABE_NOERROR);
+    ASSERT_EQ(segment, plaintext.getSubset(3 * OpenABE_STREAM_SEGMENT_SIZE, 17));
+    ASSERT_EQ(handler.decryptSegment(segment, ciphertext, 4), OpenABE_ERROR_INDEX_OUT_OF_BOUNDS);
+
+    // range reads also work through Base64 framing (only the ranges read
+    // are decoded)
+    SymKeyEncHandler b64Handler(key.toString(), EncryptionMode::STREAM_GCM, true);
+    b64Handler.setAuthData(aad);
+    OpenABEByteString b64Ciphertext;
+    ASSERT_EQ(b64Handler.encrypt(b64Ciphertext, plaintext), OpenABE_NOERROR);
+    for (size_t i = 0; i < 4; i++) {
+        ASSERT_EQ(b64Handler.decryptSegment(segment, b64Ciphertext, i), OpenABE_NOERROR);
+        size_t offset = i * OpenABE_STREAM_SEGMENT_SIZE;
+        ASSERT_EQ(segment, plaintext.getSubset(offset, min((size_t)OpenABE_STREAM_SEGMENT_SIZE, plaintext.size() - offset)));
+    }
+    ASSERT_EQ(b64Handler.decryptSegment(segment, b64Ciphertext, 4), OpenABE_ERROR_INDEX_OUT_OF_BOUNDS);
+    // a truncated ciphertext is rejected, not read past its end
+    OpenABEByteString truncated = ciphertext.getSubset(0, ciphertext.size() / 2);
+    ASSERT_NE(handler.decryptSegment(segment, truncated, 3), OpenABE_NOERROR);
+
+    // a handler with different auth data rejects the ciphertext
+    OpenABEByteString otherAad;
+    getRandomBytes(otherAad, AES_BLOCK_SIZE);
+    SymKeyEncHandler other(key.toString(), EncryptionMode::STREAM_GCM);
+    other.setAuthData(otherAad);
+    ASSERT_THROW(other.decrypt(decrypted, ciphertext), runtime_error);
+}
+
+
 // Test encryption and decryption from SymKeyEncHandler class
 TEST(SKETest, TestSKEWithOpenABESymKey) {
   OpenABEByteString key_bytes, aad;
@@ -0,0 +1,98 @@
+///
+/// \file   policygen.h
+///
+/// \brief  Generators of synthetic attributes, attribute lists and policy
+///         strings (Attr0, Attr1, ...), shared by the tests and the
+///         benchmarks.
+///
+
+#ifndef __POLICYGEN_H__
+#define __POLICYGEN_H__
+
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+inline std::string createAttribute(int i) {
+  std::stringstream ss;
+  ss << "Attr" << i;
+  return ss.str();
+}
+
+// fills attrList with Attr0 ... Attr<max>
+inline bool getOpenABEAttributeList(int max, std::vector<std::string> &attrList) {
+  if (max <= 0) { return false; }
+  attrList.clear();
+  for (int i = 0; i <= max; i++) {
+    attrList.push_back(createAttribute(i));
+  }
+  return true;
+}
+
+// returns an evenly distributed / balanced policy tree
+inline std::string getBalancedOpenABETree(int start, int end) {
+  if (start == end) { return createAttribute(start); }
+  int mid = ceil((start + (end - start) / 2.0));
+  if (mid == 0) {
+    return "(" + createAttribute(start) + " and " + createAttribute(end) + ")";
+  } else {
+    return "(" + getBalancedOpenABETree(start, mid - 1) + " and " + getBalancedOpenABETree(mid, end) + ")";
+  }
+}
+
+// returns a right-sided skewed policy tree
+inline std::string getOpenABEPolicyString(int max) {
+  std::string policystr;
+  if (max >= 2) {
+    policystr = "(" + createAttribute(0) + " and " + createAttribute(1) + ")";
+  } else if (max == 1) {
+    policystr = createAttribute(0);
+  }
+  for (int i = 2; i <= max; i++) {
+    policystr = "(" + policystr + " and " + createAttribute(i) + ")";
+  }
+  return policystr;
+}
+
+// returns a policy of 'leaves' attributes joined by the given gate
+inline std::string getFlatPolicyString(int leaves, const std::string &gate) {
+  std::string policystr = createAttribute(0);
+  for (int i = 1; i < leaves; i++) {
+    policystr = "(" + policystr + " " + gate + " " + createAttribute(i) + ")";
+  }
+  return policystr;
+}
+
+// returns an AND of 'pairs' clauses of the form (Attr2i or Attr2i+1)
+inline std::string getOrPairsPolicyString(int pairs) {
+  std::string policystr;
+  for (int i = 0; i < pairs; i++) {
+    std::string clause = "(" + createAttribute(2 * i) + " or " +
+                         createAttribute(2 * i + 1) + ")";
+    policystr = (i == 0) ? clause : "(" + policystr + " and " + clause + ")";
+  }
+  return policystr;
+}
+
+// returns 'Attr0|Attr2|...', satisfying one side of every clause above
+inline std::string getOrPairsAttributeString(int pairs) {
+  std::string attrs;
+  for (int i = 0; i < pairs; i++) {
+    if (i > 0) attrs += "|";
+    attrs += createAttribute(2 * i);
+  }
+  return attrs;
+}
+
+// returns 'Attr0|Attr1|...' with the given number of attributes
+inline std::string getAttributeListString(int count) {
+  std::string attrs;
+  for (int i = 0; i < count; i++) {
+    if (i > 0) attrs += "|";
+    attrs += createAttribute(i);
+  }
+  return attrs;
+}
+
+#endif // __POLICYGEN_H__